@@ -41,6 +41,7 @@ vector_t SECOND_STONE = {2, 2};
 const size_t CIRC_NPOINTS = 100;
 
 struct state {
+  sdl_context_t *sdl;
   scene_t *scene;
   double time_pressed;
   body_t *ball;
@@ -374,9 +375,9 @@ void add_force_creators(state_t *state) {
 
 state_t *emscripten_init() {
   // TODO: implement this!
-  sdl_init(MIN, MAX);
   state_t *state = malloc(sizeof(state_t));
   assert(state != NULL);
+  state->sdl = sdl_init(MIN, MAX);
   state->scene = scene_init();
   add_bricks(state);
   add_walls(state);
@@ -384,21 +385,24 @@ state_t *emscripten_init() {
   add_user(state);
   add_force_creators(state);
   state->time_pressed = 0.0;
-  sdl_on_key((void *)on_key);
+  sdl_on_key(state->sdl, (void *)on_key);
   return state;
 }
 
 bool emscripten_main(state_t *state) {
   // TODO: implement this!
-  double dt = time_since_last_tick();
+  double dt = time_since_last_tick(state->sdl);
   scene_tick(state->scene, dt);
   user_wrap_edges(state->user);
-  sdl_render_scene(state->scene, NULL);
+  sdl_render_scene(state->sdl, state->scene, NULL);
   return false;
 }
 
 void emscripten_free(state_t *state) {
   // TODO: implement this!
   scene_free(state->scene);
+  sdl_free(state->sdl);
   free(state);
-}
\ No newline at end of file
+}
+
+sdl_context_t *emscripten_get_sdl(state_t *state) { return state->sdl; }
\ No newline at end of file
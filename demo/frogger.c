@@ -60,6 +60,8 @@ const char *LOG_PATH = "assets/log.png";
 const char *BACKGROUND_PATH = "assets/frogger-background.png";
 
 struct state {
+  sdl_context_t *sdl;
+  asset_cache_t *assets;
   list_t *body_assets;
   asset_t *frog;
   scene_t *scene;
@@ -163,9 +165,9 @@ double rand_double(double low, double high) {
 }
 
 state_t *emscripten_init() {
-  asset_cache_init();
-  sdl_init(MIN, MAX);
   state_t *state = malloc(sizeof(state_t));
+  state->sdl = sdl_init(MIN, MAX);
+  state->assets = asset_cache_init(state->sdl);
   state->points = 0;
   srand(time(NULL));
   state->scene = scene_init();
@@ -178,10 +180,10 @@ state_t *emscripten_init() {
 
   SDL_Rect window = {
       .x = MIN.x, .y = MIN.y, .w = MAX.x - MIN.x, .h = MAX.y - MIN.y};
-  state->bg = asset_make_image(BACKGROUND_PATH, window);
+  state->bg = asset_make_image(state->assets, BACKGROUND_PATH, window);
 
   list_add(state->body_assets,
-           asset_make_image_with_body(FROGGER_PATH, froggy));
+           asset_make_image_with_body(state->assets, FROGGER_PATH, froggy));
 
   for (size_t r = 3; r < ROWS + 3; r++) {
     double cx = 0;
@@ -209,25 +211,25 @@ state_t *emscripten_init() {
       create_drag(state->scene, 0.5, obstacle);
 
       list_add(state->body_assets,
-               asset_make_image_with_body(LOG_PATH, obstacle));
+               asset_make_image_with_body(state->assets, LOG_PATH, obstacle));
     }
   }
-  sdl_on_key((key_handler_t)on_key);
+  sdl_on_key(state->sdl, (key_handler_t)on_key);
   return state;
 }
 
 bool emscripten_main(state_t *state) {
-  double dt = time_since_last_tick();
+  double dt = time_since_last_tick(state->sdl);
   player_wrap_edges(state);
   for (int i = 1; i < scene_bodies(state->scene); i++) {
     wrap_edges(scene_get_body(state->scene, i));
   }
-  sdl_clear();
+  sdl_clear(state->sdl);
   asset_render(state->bg);
   for (size_t i = 0; i < list_size(state->body_assets); i++) {
     asset_render(list_get(state->body_assets, i));
   }
-  sdl_show();
+  sdl_show(state->sdl);
 
   scene_tick(state->scene, dt);
   return false;
@@ -236,6 +238,9 @@ bool emscripten_main(state_t *state) {
 void emscripten_free(state_t *state) {
   list_free(state->body_assets);
   scene_free(state->scene);
-  asset_cache_destroy();
+  asset_cache_destroy(state->assets);
+  sdl_free(state->sdl);
   free(state);
-}
\ No newline at end of file
+}
+
+sdl_context_t *emscripten_get_sdl(state_t *state) { return state->sdl; }
\ No newline at end of file
@@ -5,19 +5,20 @@
 #include <string.h>
 #include <time.h>
 
+#include "ai.h"
 #include "asset.h"
 #include "asset_cache.h"
-#include "background.h"
 #include "car.h"
 #include "checkpoints.h"
 #include "collision.h"
 #include "forces.h"
+#include "minimap.h"
 #include "power_up.h"
 #include "sdl_wrapper.h"
+#include "track.h"
 #include <SDL2/SDL_mixer.h>
 
 typedef enum { MENU, SETTINGS, RACE, PAUSE } game_state_t;
-const double SCALE_CONST = 29875.0;
 const size_t NUM_MENU_BUTTONS = 4;
 const double G = 9.81;
 const char *BACKGROUND_PATH = "assets/frogger-background.png";
@@ -26,17 +27,13 @@ const double TRACK_MU = 2;
 const double CAR_ELASTICITY = 2.5;
 const size_t NUM_CARS = 3;
 const double WALL_ELASTICITY = 1;
-double AI_PATH_TOLERANCE = 0.2;
-double STAR_MULTIPLIER = 1.2;
-
-double EASY_AI_SPEED = 250;
-double MED_AI_SPEED = 300;
-double HARD_AI_SPEED = 350;
-size_t NUM_VILLAINS = 4;
+const double STAR_MULTIPLIER = 1.2;
+const size_t NUM_VILLAINS = 4;
 
 const vector_t MIN = {0, 0};
 const vector_t MAX = {1000, 500};
 const vector_t SPAWN_POS = {600, 200};
+const char *TRACK_PATHS[] = {"assets/tracks/caltech.trk"};
 const SDL_Rect CAR_BOX = {.x = 350, .y = 175, .w = 50, .h = 100};
 const SDL_Rect CAR_STATS_BOX = {.x = 450, .y = 160, .w = 234, .h = 175};
 const SDL_Rect VILLAIN_CHOOSER_BOX = {.x = 50, .y = 100, .w = 300, .h = 111};
@@ -46,7 +43,6 @@ const char *VILLAIN_CHOOSER_PATHS[] = {
 
 const SDL_Rect GAME_LOGO = {.x = 335, .y = 10, .w = 330, .h = 150};
 const char *MENU_BACKGROUND_PATH = "assets/background.png";
-const char *GAME_BACKGROUND_PATH = "assets/new_track.png";
 const char *GAME_LOGO_PATH = "assets/caltech_karts_logo.png";
 const char *CAR_STAT_PATHS[] = {"assets/f1_car_menu.png",
                                 "assets/golf_cart_menu.png",
@@ -57,8 +53,39 @@ const char *LAP_NO_PATHS[] = {
     "assets/lap_3.png",
 };
 const size_t NO_LAPS = 3;
+// The sprites and menu images drawn most, which are packed into shared
+// textures at startup. The rest are too large to pack or rarely drawn.
+const char *PACKED_IMAGE_PATHS[] = {
+    "assets/f1_car.png",
+    "assets/golf_cart.png",
+    "assets/pickup_truck.png",
+    "assets/ai_minimap.png",
+    "assets/ghost.png",
+    "assets/box.png",
+    "assets/shell.png",
+    "assets/mushroom.png",
+    "assets/star.png",
+    "assets/boost_pad.png",
+    "assets/reverse_controls.png",
+    "assets/lap_1.png",
+    "assets/lap_2.png",
+    "assets/lap_3.png",
+    "assets/wrong_way.png",
+    "assets/wrong_way_arrow.png",
+    "assets/home.png",
+    "assets/easy_ai.png",
+    "assets/mid_ai.png",
+    "assets/hard_ai.png",
+    "assets/ghost_setting.png",
+    "assets/f1_car_menu.png",
+    "assets/golf_cart_menu.png",
+    "assets/pickup_menu.png",
+    "assets/caltech_karts_logo.png",
+};
+const size_t NUM_PACKED_IMAGES =
+    sizeof(PACKED_IMAGE_PATHS) / sizeof(PACKED_IMAGE_PATHS[0]);
 const SDL_Rect LAP_BOX = {.x = 20, .y = 280, .w = 180, .h = 60};
-const double WALL_WIDTH = 50.0;
+const double WALL_RADIUS = 5.0;
 const double MINIMAP_SCALE = 0.02;
 const double MINI_CAR_RADIUS = 50;
 
@@ -68,12 +95,14 @@ const double STAR_DURATION = 10;
 const double REVERSE_DURATION = 10;
 const double ITEM_DISTANCE = 50; // how an item should be placed
 const double SHELL_ROT_SPEED = 6.0;
+// How many of each item can be out at once before the oldest is recycled
+const size_t ITEM_POOL_SIZE = 8;
 const double STUN_ROT_SPEED = 2 * M_PI;
 
-const vector_t START_IN = {408, 200};
-const vector_t START_OUT = {640, 200};
-const size_t START_OFFSET = 3;
 const vector_t AI_START_OFFSET = {-120, 0};
+const double GRID_ROW_SPACING = 80;
+const size_t MAX_OPPONENTS = 64;
+const SDL_Rect OPPONENTS_BOX = {.x = 200, .y = 320, .w = 200, .h = 40};
 const double MAX_W = M_PI / 32;
 
 const char *WRONG_WAY_IMAGE_PATH = "assets/wrong_way.png";
@@ -89,7 +118,7 @@ const char *GAME_MUSIC = "assets/game_music.wav";
 const char *MENU_MUSIC = "assets/menu_music.wav";
 const char *STAR_MUSIC = "assets/star_music.wav";
 
-SDL_Rect WINDOW = {
+const SDL_Rect WINDOW = {
     .x = MIN.x, .y = MIN.y, .w = MAX.x - MIN.x, .h = MAX.y - MIN.y};
 
 void toggle_pause(state_t *state);
@@ -99,6 +128,8 @@ void prev_car(state_t *state);
 void next_car(state_t *state);
 void next_villain(state_t *state);
 void prev_villain(state_t *state);
+void more_opponents(state_t *state);
+void fewer_opponents(state_t *state);
 void restart_game(state_t *state);
 
 typedef struct button_info {
@@ -111,7 +142,7 @@ typedef struct button_info {
   button_handler_t handler;
 } button_info_t;
 
-button_info_t PAUSE_BUTTON = {.image_path = "assets/pause_button.png",
+const button_info_t PAUSE_BUTTON = {.image_path = "assets/pause_button.png",
                               .font_path = NULL,
                               .image_box = (SDL_Rect){900, 25, 75, 75},
                               .text_box = (SDL_Rect){900, 25, 0, 0},
@@ -119,7 +150,7 @@ button_info_t PAUSE_BUTTON = {.image_path = "assets/pause_button.png",
                               .text = NULL,
                               .handler = (void *)toggle_pause};
 
-button_info_t MENU_BUTTON_TEMPLATES[] = {
+const button_info_t MENU_BUTTON_TEMPLATES[] = {
     {.image_path = "assets/start.png",
      .font_path = NULL,
      .image_box = (SDL_Rect){200, 350, 600, 50},
@@ -151,7 +182,7 @@ button_info_t MENU_BUTTON_TEMPLATES[] = {
      .text = NULL,
      .handler = (void *)prev_car}};
 
-button_info_t HOME_BUTTON = {.image_path = "assets/home.png",
+const button_info_t HOME_BUTTON = {.image_path = "assets/home.png",
                              .font_path = NULL,
                              .image_box = (SDL_Rect){225, 350, 500, 100},
                              .text_box = (SDL_Rect){200, 100, 0, 0},
@@ -160,12 +191,12 @@ button_info_t HOME_BUTTON = {.image_path = "assets/home.png",
                              .handler = (void *)restart_game};
 
 const char *INSTRUCTIONS_FILE_PATH = "assets/instructions.png";
-SDL_Rect INSTRUCTIONS_BOX_SETTINGS = {600, 100, 300, 150};
-SDL_Rect INSTRUCTIONS_BOX_PAUSE = {225, 100, 500, 250};
+const SDL_Rect INSTRUCTIONS_BOX_SETTINGS = {600, 100, 300, 150};
+const SDL_Rect INSTRUCTIONS_BOX_PAUSE = {225, 100, 500, 250};
 
-const size_t NUM_SETTINGS_BUTTONS = 2;
+const size_t NUM_SETTINGS_BUTTONS = 4;
 
-button_info_t SETTINGS_BUTTONS_TEMPLATES[] = {
+const button_info_t SETTINGS_BUTTONS_TEMPLATES[] = {
     {.image_path = "assets/right_arrow.png",
      .font_path = NULL,
      .image_box = (SDL_Rect){150, 250, 40, 40},
@@ -180,11 +211,28 @@ button_info_t SETTINGS_BUTTONS_TEMPLATES[] = {
      .text_color = (rgb_color_t){255, 255, 255},
      .text = NULL,
      .handler = (void *)prev_villain},
+    {.image_path = NULL,
+     .font_path = "assets/RetroMario-Regular.ttf",
+     .image_box = (SDL_Rect){150, 320, 40, 40},
+     .text_box = (SDL_Rect){150, 320, 40, 40},
+     .text_color = (rgb_color_t){255, 255, 255},
+     .text = "+",
+     .handler = (void *)more_opponents},
+    {.image_path = NULL,
+     .font_path = "assets/RetroMario-Regular.ttf",
+     .image_box = (SDL_Rect){100, 320, 40, 40},
+     .text_box = (SDL_Rect){100, 320, 40, 40},
+     .text_color = (rgb_color_t){255, 255, 255},
+     .text = "-",
+     .handler = (void *)fewer_opponents},
 };
 
 struct state {
+  sdl_context_t *sdl;
+  asset_cache_t *assets;
+  ai_tuning_t tuning;
   double time;
-  list_t *body_assets;
+  slot_map_t *body_assets; // the assets drawn with the scene
   list_t *lap_numbers;
   list_t *car_stats;
   list_t *villain_chooser;
@@ -196,25 +244,37 @@ struct state {
   villain_type_t villain_type;
   list_t *settings_buttons;
   body_t *car;
-  body_t *villain;
+  ai_t *ai;
+  list_t *cars;
+  size_t num_opponents;
+  char opponents_text[16];
+  asset_t *opponents_count;
+  char time_text[16];
+  asset_t *time_asset;
+  list_t *item_icons; // the HUD image of each power_up_type_t
+  list_t *checkpoints;
   asset_t *wrong_way_arrow;
   scene_t *scene;
-  asset_t *bg;
+  handle_t bg; // the background, in body_assets
   double villain_speed;
   checkpoint_state_t *checkpoint_state;
   game_state_t game_state;
   list_t *menu_buttons;
-  asset_t *mini_map;
+  minimap_t *mini_map;
   asset_t *wrong_way;
-  asset_t *mini_car;
-  asset_t *mini_villain;
-  list_t *inside_walls;
-  list_t *outside_walls;
+  minimap_marker_t mini_car;
+  minimap_marker_t mini_villain;
+  track_t *track;
+  size_t track_idx;
+  body_t *walls;
   asset_t *home_button;
   asset_t *instructions;
   bool *switches;
+  box_rules_t box_rules;
   list_t *boxes;
-  list_t *shells;
+  item_pool_t *shells;
+  item_pool_t *fake_boxes;
+  item_pool_t *boosts;
   size_t *key_mapping;
   Mix_Chunk *menu_music;
   Mix_Chunk *game_music;
@@ -226,12 +286,13 @@ struct state {
 asset_t *create_button_from_info(state_t *state, button_info_t info) {
   asset_t *button_image = NULL;
   if (info.image_path != NULL) {
-    button_image = asset_make_image(info.image_path, info.image_box);
+    button_image =
+        asset_make_image(state->assets, info.image_path, info.image_box);
   }
   asset_t *button_text = NULL;
   if (info.text != NULL) {
-    button_text = asset_make_text(info.font_path, info.text_box, info.text,
-                                  info.text_color);
+    button_text = asset_make_text(state->assets, info.font_path,
+                                  info.text_box, info.text, info.text_color);
   }
   SDL_Rect box;
   if (button_image == NULL) {
@@ -241,84 +302,71 @@ asset_t *create_button_from_info(state_t *state, button_info_t info) {
   }
   asset_t *button =
       asset_make_button(box, button_image, button_text, info.handler);
-  asset_cache_register_button(button);
+  asset_cache_register_button(state->assets, button);
   return button;
 }
 
-list_t *inside_walls() {
-  list_t *points = inside_walls_points(WALL_WIDTH);
-  size_t size = list_size(points);
-  list_t *inside_walls = list_init(size, NULL);
-  for (size_t i = 0; i < size; i++) {
-    body_t *body = body_init(list_get(points, i), INFINITY, get_blue());
-    list_add(inside_walls, body);
-  }
-  return inside_walls;
-}
-
-list_t *outside_walls() {
-  list_t *points = outside_walls_points(WALL_WIDTH);
-  size_t size = list_size(points);
-  list_t *outside_walls = list_init(size, NULL);
-  for (size_t i = 0; i < size; i++) {
-    body_t *body = body_init(list_get(points, i), INFINITY, get_blue());
-    list_add(outside_walls, body);
-  }
-  return outside_walls;
-}
-
 void race_free(state_t *state) {
   // remember to set things to null after freeing
-  for (size_t i = 0; i < list_size(state->body_assets); i++) {
-    body_remove(asset_get_body(list_get(state->body_assets, i)));
-  }
-  list_free(state->body_assets);
-  for (size_t i = 0; i < list_size(state->shells); i++) {
-    body_remove(asset_get_body(list_get(state->shells, i)));
-  }
-  list_free(state->shells);
-  for (size_t i = 0; i < list_size(state->boxes); i++) {
-    body_remove(asset_get_body(list_get(state->boxes, i)));
-  }
+  slot_map_free(state->body_assets);
+  asset_destroy(state->time_asset);
+  state->time_asset = NULL;
+  list_free(state->item_icons);
+  state->item_icons = NULL;
+  item_pool_free(state->shells);
+  item_pool_free(state->fake_boxes);
+  item_pool_free(state->boosts);
   list_free(state->boxes);
-  state->bg = NULL;
+  state->walls = NULL;
+  list_free(state->checkpoints);
+  state->checkpoints = NULL;
+  state->bg = (handle_t){0};
   state->car = NULL;
-  state->villain = NULL;
-  body_remove(asset_get_body(state->mini_map));
-  asset_destroy(state->mini_map);
+  ai_free(state->ai);
+  state->ai = NULL;
+  list_free(state->cars);
+  state->cars = NULL;
+  // Every body in the scene belongs to the race, so it is all freed at once
+  scene_clear(state->scene);
+  minimap_free(state->mini_map);
   state->mini_map = NULL;
-  body_remove(asset_get_body(state->mini_car));
-  asset_destroy(state->mini_car);
-  state->mini_car = NULL;
-  body_remove(asset_get_body(state->mini_villain));
-  asset_destroy(state->mini_villain);
-  state->mini_villain = NULL;
 
   return;
 }
 
-body_t *background() {
-  return body_init(background_list(), INFINITY, get_blue());
+body_t *background(arena_t *arena, track_t *track) {
+  vector_t min, max;
+  track_get_background_bounds(track, &min, &max);
+  vector_t size = vec_subtract(max, min);
+  vector_t center = vec_multiply(0.5, vec_add(min, max));
+  return body_init_rect(arena, center, size.x, size.y, INFINITY, get_blue(),
+                        NULL, NULL);
+}
+
+/**
+ * Timer callback for the end of the player's star. Switches back to the race
+ * music unless another star has extended the immunity since.
+ */
+void end_star(state_t *state) {
+  power_up_info_t info = car_get_powerup_state(state->car);
+  if (scene_get_time(state->scene) >= info.immune_until) {
+    Mix_HaltChannel(0);
+    Mix_PlayChannel(0, state->game_music, -1);
+  }
 }
 
 void use_item(state_t *state) {
   body_t *car = state->car;
-  if (car_has_shell(car)) {
+  body_t *shell = car_get_shell(state->shells, car);
+  if (shell != NULL) {
     power_up_info_t info = car_get_powerup_state(car);
-    body_t *shell = info.shell;
-    info.shell = NULL;
+    fire_shell(shell);
+    info.shell = (handle_t){0};
     car_set_powerup_state(car, info);
-    create_stun_collision(state->scene, car, shell, 1.0);
-    size_t size = list_size(state->inside_walls);
-    for (size_t i = 0; i < size; i++) {
-      create_physics_collision(state->scene, list_get(state->inside_walls, i),
-                               shell, WALL_ELASTICITY);
-      create_physics_collision(state->scene, list_get(state->outside_walls, i),
-                               shell, WALL_ELASTICITY);
-    }
     return;
   }
   power_up_info_t info = car_get_powerup_state(car);
+  double now = scene_get_time(state->scene);
   double theta = body_get_rotation(car);
   vector_t direction = {.x = sin(theta), .y = -cos(theta)};
   power_up_type_t power = info.power_up;
@@ -327,7 +375,7 @@ void use_item(state_t *state) {
     break;
   }
   case SHROOM: {
-    info.fast = fmax(info.fast, SHROOM_DURATION);
+    info.fast_until = fmax(info.fast_until, now + SHROOM_DURATION);
     vector_t vel = body_get_velocity(car);
     if (vec_get_length(vel) == 0) {
       vel = direction;
@@ -343,7 +391,9 @@ void use_item(state_t *state) {
   case STAR: {
     Mix_HaltChannel(0);
     Mix_PlayChannel(0, state->star_music, -1);
-    info.immune = STAR_DURATION;
+    info.immune_until = now + STAR_DURATION;
+    scene_add_timer(state->scene, STAR_DURATION, car,
+                    (timer_callback_t)end_star, state);
     vector_t vel = body_get_velocity(car);
     if (vec_get_length(vel) == 0) {
       vel = direction;
@@ -356,52 +406,23 @@ void use_item(state_t *state) {
     break;
   }
   case REVERSE: {
-    info.reverse = REVERSE_DURATION;
+    info.reverse_until = now + REVERSE_DURATION;
     printf("CONTROLS SCRAMBLED!\n");
-    permute(state->key_mapping, 4);
+    permute(scene_get_rng(state->scene), state->key_mapping, 4);
     break;
   }
   case FAKE: {
     vector_t center = vec_subtract(body_get_centroid(state->car),
                                    vec_multiply(ITEM_DISTANCE, direction));
-    asset_t *box = make_box(center);
-    list_add(state->body_assets, box);
-    scene_add_body(state->scene, asset_get_body(box));
-    create_stun_collision(state->scene, state->car, asset_get_body(box),
-                          3.0); // constant over 2
-    create_stun_collision(state->scene, state->villain, asset_get_body(box),
-                          3.0); // constant over 2
+    spawn_fake_box(state->fake_boxes, center);
     break;
   }
   case SHELL: {
-    vector_t center = vec_subtract(body_get_centroid(state->car),
-                                   vec_multiply(ITEM_DISTANCE, direction));
-    asset_t *shell = make_shell(center, theta, SHELL_ROT_SPEED);
-    body_t *body = asset_get_body(shell);
-    info.shell = body;
-    scene_add_body(state->scene, body);
-    size_t size = list_size(state->shells);
-    for (ssize_t i = 0; i < size; i++) {
-      body_t *curr = asset_get_body(list_get(state->shells, i));
-      if (curr == NULL) {
-        list_remove(state->shells, i);
-        i--;
-        size--;
-      } else {
-        create_shell_collision(state->scene, curr, body);
-      }
-    }
-    list_add(state->shells, shell);
-    create_stun_collision(state->scene, state->villain, body,
-                          1.0); // constant under 2
+    info.shell = spawn_shell(state->shells, car, theta, SHELL_ROT_SPEED);
     break;
   }
   case BOOST: {
-    asset_t *boost = make_boost(state->car);
-    body_t *body = asset_get_body(boost);
-    scene_add_body(state->scene, body);
-    list_add(state->body_assets, boost);
-    create_boost_collision(state->scene, state->car, body);
+    spawn_boost(state->boosts, car);
     break;
   }
   default:
@@ -419,13 +440,14 @@ void on_key(char key, key_event_type_t type, double held_time, state_t *state) {
   body_t *car = state->car;
   vector_t vel = body_get_velocity(car);
   power_up_info_t car_powerups = car_get_powerup_state(state->car);
-  if (car_powerups.stun > 0) {
+  double now = scene_get_time(state->scene);
+  if (now < car_powerups.stun_until) {
     return;
   }
   double multiplier = 1;
-  if (car_powerups.fast > 0) {
+  if (now < car_powerups.fast_until) {
     multiplier = get_speed_multiplier();
-  } else if (car_powerups.immune > 0) {
+  } else if (now < car_powerups.immune_until) {
     multiplier = STAR_MULTIPLIER;
   }
   double speed = vec_get_length(vel);
@@ -434,7 +456,7 @@ void on_key(char key, key_event_type_t type, double held_time, state_t *state) {
   double top_speed = multiplier * car_get_top_speed(car);
   double turining_radius =
       vec_get_length(vel) * vec_get_length(vel) / (car_get_friction(car) * G);
-  if (key < 5 && car_get_powerup_state(state->car).reverse > 0) {
+  if (key < 5 && now < car_powerups.reverse_until) {
     key = state->key_mapping[key - 1] + 1;
   }
   if (type == KEY_PRESSED) {
@@ -488,8 +510,9 @@ void on_key(char key, key_event_type_t type, double held_time, state_t *state) {
       break;
     }
     case R: {
-      if (car_has_shell(car)) {
-        flip_shell(car_get_powerup_state(car).shell);
+      body_t *shell = car_get_shell(state->shells, car);
+      if (shell != NULL) {
+        flip_shell(shell);
       }
       break;
     }
@@ -520,43 +543,36 @@ void handle_checkpoint_state(state_t *state, double dt) {
   } else {
     state->lap_time += dt;
   }
-  if (get_lap_over(car_get_checkpoint_state(state->villain))) {
-    reset_checkpoint_state(car_get_checkpoint_state(state->villain));
-    car_set_laps_done(state->villain, car_get_laps_done(state->villain) + 1);
-  }
 }
 
 void create_mini_map(state_t *state) {
-  list_t *map = background_list();
-  vector_t vec = vec_subtract(*(vector_t *)list_get(map, 3),
-                              *(vector_t *)list_get(map, 1));
-  list_free(map);
-  vec = vec_multiply(MINIMAP_SCALE, vec);
-  vector_t center = vec_multiply(0.5, vec);
-  center = (vector_t){.x = center.x, .y = MAX.y - center.y};
-  list_t *points = make_rectangle(center, vec.x, vec.y);
-  body_t *body = body_init(points, INFINITY, get_blue());
-  state->mini_map = asset_make_image_with_body(MINIMAP_PATH, body);
-  state->mini_car = make_mini_car(state->car_type);
-  state->mini_villain = make_mini_villain(state->villain_type);
+  vector_t min, max;
+  track_get_background_bounds(state->track, &min, &max);
+  vector_t size = vec_multiply(MINIMAP_SCALE, vec_subtract(max, min));
+  // In the top left corner of the scene
+  vector_t box_min = {.x = MIN.x, .y = MAX.y - size.y};
+  vector_t box_max = {.x = MIN.x + size.x, .y = MAX.y};
+  state->mini_map =
+      minimap_init(state->sdl, MINIMAP_PATH, min, max, box_min, box_max);
+  state->mini_car = make_mini_car_marker(state->assets, state->car_type);
+  state->mini_villain =
+      make_mini_villain_marker(state->assets, state->villain_type);
 }
 
-void update_mini_map(state_t *state) {
-  vector_t bg_center = body_get_centroid(asset_get_body(state->bg));
-  vector_t car_center = body_get_centroid(state->car);
-  vector_t car_pos = vec_subtract(car_center, bg_center);
-  car_pos = vec_add(body_get_centroid(asset_get_body(state->mini_map)),
-                    vec_multiply(MINIMAP_SCALE, car_pos));
-  body_set_centroid(asset_get_body(state->mini_car), car_pos);
-  body_set_rotation(asset_get_body(state->mini_car),
-                    body_get_rotation(state->car));
-  vector_t villain_center = body_get_centroid(state->villain);
-  vector_t villain_pos = vec_subtract(villain_center, bg_center);
-  villain_pos = vec_add(body_get_centroid(asset_get_body(state->mini_map)),
-                        vec_multiply(MINIMAP_SCALE, villain_pos));
-  body_set_centroid(asset_get_body(state->mini_villain), villain_pos);
-  body_set_rotation(asset_get_body(state->mini_villain),
-                    body_get_rotation(state->villain) + M_PI);
+void render_mini_map(state_t *state) {
+  // The background is centered on the area the minimap covers
+  asset_t *bg = slot_map_get(state->body_assets, state->bg);
+  vector_t bg_center = body_get_centroid(asset_get_body(bg));
+  minimap_draw(state->mini_map);
+  vector_t car_pos = vec_subtract(body_get_centroid(state->car), bg_center);
+  minimap_draw_marker(state->mini_map, state->mini_car, car_pos,
+                      body_get_rotation(state->car));
+  for (size_t i = 0; i < ai_num_cars(state->ai); i++) {
+    body_t *villain = ai_get_car(state->ai, i);
+    vector_t villain_pos = vec_subtract(body_get_centroid(villain), bg_center);
+    minimap_draw_marker(state->mini_map, state->mini_villain, villain_pos,
+                        body_get_rotation(villain) + M_PI);
+  }
 }
 
 void update_arrow(state_t *state) {
@@ -572,27 +588,22 @@ void update_arrow(state_t *state) {
 }
 
 void create_boxes(state_t *state) {
-  state->boxes = list_init(2, (free_func_t)asset_destroy);
-  list_t *inside = get_inside_out();
-  list_t *outside = get_outside_in();
-  size_t size = list_size(inside);
-  for (size_t i = 0; i < size; i += 2) {
-    vector_t in = *(vector_t *)list_get(inside, i);
-    vector_t out = *(vector_t *)list_get(outside, i);
-    for (size_t j = 1; j <= NUM_BOXES; j++) {
-      vector_t center =
-          vec_add(vec_multiply(j, in), vec_multiply(NUM_BOXES + 1 - j, out));
-      center = vec_multiply(1.0 / ((double)NUM_BOXES + 1.0), center);
-      asset_t *box = make_box(center);
-      body_t *body = asset_get_body(box);
-      scene_add_body(state->scene, body);
-      create_box_collision(state->scene, state->car, body, state->switches);
-      create_box_collision(state->scene, state->villain, body, state->switches);
-      list_add(state->boxes, box);
-    }
+  size_t size;
+  const vector_t *centers = track_get_boxes(state->track, &size);
+  state->boxes = list_init(size, (free_func_t)asset_destroy);
+  list_t *bodies = list_init(size, NULL);
+  for (size_t i = 0; i < size; i++) {
+    asset_t *box =
+        make_box(state->assets, scene_get_arena(state->scene), centers[i]);
+    body_t *body = asset_get_body(box);
+    scene_add_body(state->scene, body);
+    list_add(bodies, body);
+    list_add(state->boxes, box);
   }
-  list_free(inside);
-  list_free(outside);
+  state->box_rules =
+      (box_rules_t){.switches = state->switches, .scene = state->scene};
+  create_box_collisions(state->scene, state->cars, bodies, &state->box_rules);
+  list_free(bodies);
 }
 
 void menu_free(state_t *state) {
@@ -615,19 +626,67 @@ void prev_villain(state_t *state) {
   state->villain_type = (state->villain_type + 3) % NUM_VILLAINS;
 }
 
-double get_villain_speed(state_t *state, villain_type_t villain_type) {
-  switch (villain_type) {
-  case EASY_AI:
-    return EASY_AI_SPEED;
-  case MEDIUM_AI:
-    return MED_AI_SPEED;
-  case HARD_AI:
-    return HARD_AI_SPEED;
-  case GHOST:
-    return SCALE_CONST / (state->best_time);
+void update_time_text(state_t *state) {
+  size_t seconds = (size_t)floor(state->time);
+  size_t minutes = seconds / 60;
+  size_t milliseconds = (size_t)(1000.0 * (state->time - seconds));
+  seconds = seconds % 60;
+  snprintf(state->time_text, sizeof(state->time_text), "%zu:%02zu.%zu",
+           minutes, seconds, milliseconds);
+}
+
+void update_opponents_text(state_t *state) {
+  snprintf(state->opponents_text, sizeof(state->opponents_text),
+           "Opponents: %zu", state->num_opponents);
+}
+
+void more_opponents(state_t *state) {
+  if (state->num_opponents < MAX_OPPONENTS) {
+    state->num_opponents++;
+    update_opponents_text(state);
+  }
+}
+void fewer_opponents(state_t *state) {
+  if (state->num_opponents > 1) {
+    state->num_opponents--;
+    update_opponents_text(state);
   }
 }
 
+/**
+ * Creates the pools the player's items are drawn from, and their collisions.
+ * Only the player's car can use the boost pads.
+ */
+void create_item_pools(state_t *state) {
+  state->shells =
+      item_pool_init(state->scene, state->assets, SHELL, ITEM_POOL_SIZE);
+  create_shell_collisions(state->scene, state->shells, state->cars,
+                          state->walls, WALL_ELASTICITY);
+  state->fake_boxes =
+      item_pool_init(state->scene, state->assets, FAKE, ITEM_POOL_SIZE);
+  create_fake_box_collisions(state->scene, state->fake_boxes, state->cars);
+  state->boosts =
+      item_pool_init(state->scene, state->assets, BOOST, ITEM_POOL_SIZE);
+  list_t *player = list_init(1, NULL);
+  list_add(player, state->car);
+  create_boost_collisions(state->scene, state->boosts, player);
+  list_free(player);
+}
+
+/**
+ * Returns where an opponent starts the race: two abreast across the track,
+ * in rows behind the player.
+ */
+vector_t opponent_spawn(state_t *state, size_t idx) {
+  vector_t spawn = track_get_spawn(state->track);
+  double theta = track_get_spawn_rotation(state->track);
+  vector_t direction = {.x = sin(theta), .y = -cos(theta)};
+  size_t slot = idx + 1; // the player has the first slot
+  vector_t side = vec_multiply(slot % 2, AI_START_OFFSET);
+  vector_t back = vec_multiply(-GRID_ROW_SPACING * (slot / 2), direction);
+  return vec_add(spawn, vec_add(side, back));
+}
+
 void start_race(state_t *state) {
   Mix_HaltChannel(0);
   Mix_PlayChannel(0, state->game_music, -1);
@@ -639,91 +698,101 @@ void start_race(state_t *state) {
   }
   menu_free(state);
 
-  state->body_assets = list_init(2, (free_func_t)asset_destroy);
-  body_t *bg_body = background();
+  state->body_assets = slot_map_init(state->num_opponents + 2,
+                                     (free_func_t)asset_destroy);
+  body_t *bg_body = background(scene_get_arena(state->scene), state->track);
   scene_add_body(state->scene, bg_body);
-  state->bg = asset_make_image_with_body(GAME_BACKGROUND_PATH, bg_body);
-  list_add(state->body_assets, state->bg);
+  state->bg = slot_map_insert(
+      state->body_assets,
+      asset_make_tiled_image_with_body(
+          state->assets, track_get_background_path(state->track), bg_body));
   state->lap_numbers = list_init(NO_LAPS, (free_func_t)asset_destroy);
   for (size_t i = 0; i < NO_LAPS; i++) {
-    list_add(state->lap_numbers, asset_make_image(LAP_NO_PATHS[i], LAP_BOX));
+    list_add(state->lap_numbers,
+             asset_make_image(state->assets, LAP_NO_PATHS[i], LAP_BOX));
   }
   state->pause_button = create_button_from_info(state, PAUSE_BUTTON);
+  // The timer text is rewritten in place every frame
+  update_time_text(state);
+  SDL_Rect time_box = {
+      .x = TIME_POSITION.x, .y = TIME_POSITION.y, .w = 100, .h = 100};
+  state->time_asset = asset_make_dynamic_text(
+      state->assets, GAME_FONT_PATH, time_box, state->time_text, get_blue());
+  state->item_icons = list_init(FAKE + 1, (free_func_t)asset_destroy);
+  for (power_up_type_t power = NONE; power <= FAKE; power++) {
+    list_add(state->item_icons, item_asset(state->assets, power));
+  }
 
-  body_t *car = make_car(state->car_type);
-  body_set_centroid(car, SPAWN_POS);
+  vector_t spawn = track_get_spawn(state->track);
+  double spawn_rotation = track_get_spawn_rotation(state->track);
+  arena_t *arena = scene_get_arena(state->scene);
+  body_t *car = make_car(arena, state->car_type);
+  body_set_centroid(car, spawn);
   state->car = car;
-  list_add(state->body_assets, make_car_image(car));
-  body_set_rotation(car, M_PI);
+  slot_map_insert(state->body_assets, make_car_image(state->assets, car));
+  body_set_rotation(car, spawn_rotation);
   scene_add_body(state->scene, car);
   create_drag(state->scene, TRACK_MU, car);
 
-  body_t *villain = make_car((state->car_type + 1) % NUM_CARS);
-  body_set_centroid(villain, vec_add(AI_START_OFFSET, SPAWN_POS));
-  state->villain = villain;
-  list_add(state->body_assets, make_car_image(villain));
-  body_set_rotation(villain, M_PI);
-  scene_add_body(state->scene, villain);
-  create_drag(state->scene, TRACK_MU, villain);
-  state->villain_speed = get_villain_speed(state, state->villain_type);
-  change_top_speed(villain, state->villain_speed);
+  size_t num_gates;
+  const track_gate_t *gates = track_get_gates(state->track, &num_gates);
+  state->checkpoints = make_checkpoints(arena, gates, num_gates);
+  car_set_checkpoint_state(car, checkpoint_state_init(state->checkpoints));
+
+  state->cars = list_init(state->num_opponents + 1, NULL);
+  list_add(state->cars, car);
+  state->ai = ai_init(state->tuning.path_tolerance, STUN_ROT_SPEED);
+  state->villain_speed =
+      ai_villain_speed(state->tuning, state->villain_type, state->best_time);
+  for (size_t i = 0; i < state->num_opponents; i++) {
+    car_type_t type = (state->car_type + 1 + i % (NUM_CARS - 1)) % NUM_CARS;
+    body_t *villain = make_car(arena, type);
+    body_set_centroid(villain, opponent_spawn(state, i));
+    slot_map_insert(state->body_assets,
+                    make_car_image(state->assets, villain));
+    body_set_rotation(villain, spawn_rotation);
+    scene_add_body(state->scene, villain);
+    create_drag(state->scene, TRACK_MU, villain);
+    change_top_speed(villain, state->villain_speed);
+    car_set_checkpoint_state(villain,
+                             checkpoint_state_init(state->checkpoints));
+    ai_add_car(state->ai, villain);
+    list_add(state->cars, villain);
+  }
 
   body_t *arrow_body =
-      body_init(make_rectangle(VEC_ZERO, WRONG_WAY_WIDTH, WRONG_WAY_HEIGHT),
-                INFINITY, get_blue());
+      body_init_rect(NULL, VEC_ZERO, WRONG_WAY_WIDTH, WRONG_WAY_HEIGHT,
+                     INFINITY, get_blue(), NULL, NULL);
   state->wrong_way_arrow = asset_make_rotatable_image_with_body(
-      WRONG_WAY_ARROW_IMAGE_PATH, arrow_body);
+      state->assets, WRONG_WAY_ARROW_IMAGE_PATH, arrow_body);
 
   if (state->villain_type != GHOST) {
-    create_car_collision(state->scene, state->car, villain);
+    create_car_collisions(state->scene, state->cars);
   }
 
-  list_t *checkpoints = make_checkpoints(get_inside_out(), get_outside_in(),
-                                         START_IN, START_OUT, START_OFFSET);
-  checkpoint_state_t *checkpoint_state_car = checkpoint_state_init(checkpoints);
-  checkpoint_state_t *checkpoint_state_villain =
-      checkpoint_state_init(checkpoints);
-
-  car_set_checkpoint_state(state->car, checkpoint_state_car);
-  car_set_checkpoint_state(state->villain, checkpoint_state_villain);
+  state->wrong_way =
+      asset_make_image(state->assets, WRONG_WAY_IMAGE_PATH, GAME_LOGO);
 
-  state->wrong_way = asset_make_image(WRONG_WAY_IMAGE_PATH, GAME_LOGO);
-
-  for (size_t i = 0; i < list_size(checkpoints); i++) {
-    scene_add_body(state->scene, list_get(checkpoints, i));
-    create_collision(state->scene, state->car, list_get(checkpoints, i),
-                     checkpoint_collision, checkpoint_state_car, 0);
-    create_collision(state->scene, state->villain, list_get(checkpoints, i),
-                     checkpoint_collision, checkpoint_state_villain, 0);
+  for (size_t i = 0; i < list_size(state->checkpoints); i++) {
+    scene_add_body(state->scene, list_get(state->checkpoints, i));
   }
+  create_checkpoint_collisions(state->scene, state->cars, state->checkpoints);
 
-  state->outside_walls = outside_walls();
-  state->inside_walls = inside_walls();
-  size_t len_outside_walls = list_size(state->outside_walls);
-  size_t len_inside_walls = list_size(state->inside_walls);
-  for (size_t i = 0; i < len_outside_walls; i++) {
-    scene_add_body(state->scene, list_get(state->outside_walls, i));
-    create_physics_collision(state->scene, state->car,
-                             list_get(state->outside_walls, i),
-                             WALL_ELASTICITY);
-    create_physics_collision(state->scene, state->villain,
-                             list_get(state->outside_walls, i),
-                             WALL_ELASTICITY);
-  }
-  for (size_t i = 0; i < len_inside_walls; i++) {
-    scene_add_body(state->scene, list_get(state->inside_walls, i));
-    create_physics_collision(state->scene, state->car,
-                             list_get(state->inside_walls, i), WALL_ELASTICITY);
-    create_physics_collision(state->scene, state->villain,
-                             list_get(state->inside_walls, i), WALL_ELASTICITY);
+  state->walls = body_init_track_walls(state->track, WALL_RADIUS, get_blue());
+  scene_add_body(state->scene, state->walls);
+  for (size_t i = 0; i < list_size(state->cars); i++) {
+    create_physics_collision(state->scene, list_get(state->cars, i),
+                             state->walls, WALL_ELASTICITY);
   }
+  ai_set_track(state->ai, state->scene, state->track, state->walls,
+               state->checkpoints);
   state->switches = malloc(6 * sizeof(bool));
   for (size_t i = 0; i < 6; i++)
     state->switches[i] = true;
   create_boxes(state);
-  state->shells = list_init(2, (free_func_t)asset_destroy);
+  create_item_pools(state);
   create_mini_map(state);
-  sdl_on_key((key_handler_t)on_key);
+  sdl_on_key(state->sdl, (key_handler_t)on_key);
 }
 
 void next_car(state_t *state) {
@@ -744,22 +813,6 @@ void create_menu_buttons(state_t *state) {
   state->lap_time = 0.0;
 }
 
-void fix_villain_path(body_t *car) {
-  double theta = body_get_rotation(car);
-  vector_t direction = {.x = sin(theta), .y = -cos(theta)};
-  vector_t right_way =
-      get_right_way_from_position(car_get_checkpoint_state(car), car);
-  double dot_prod = vec_dot(direction, right_way);
-  if (abs(dot_prod > AI_PATH_TOLERANCE)) {
-    theta = theta + atan2(right_way.y, right_way.x) -
-            atan2(direction.y, direction.x);
-    body_set_rotation(car, theta);
-  }
-  vector_t new_dir = {sin(theta), -cos(theta)};
-  vector_t velocity = vec_multiply(car_get_top_speed(car), new_dir);
-  body_set_velocity(car, velocity);
-}
-
 void show_menu(state_t *state) {
   asset_render(state->menu_bg);
   asset_render(state->logo);
@@ -770,38 +823,33 @@ void show_menu(state_t *state) {
   asset_render(list_get(state->car_stats, state->car_type));
 }
 
-asset_t *make_time_asset(double time) {
-  size_t seconds = (size_t)floor(time);
-  size_t minutes = seconds / 60;
-  size_t milliseconds = (size_t)(1000.0 * (time - seconds));
-  seconds = seconds % 60;
-  char *aux = malloc(5 * sizeof(char));
-  if (seconds < 10) { // 1 digit
-    sprintf(aux, ":0%zu.", seconds);
-  } else {
-    sprintf(aux, ":%zu.", seconds);
-  }
-  char *text = malloc(12 * sizeof(char)); // give more than enough space
-  sprintf(text, "%zu%s%zu", minutes, aux, milliseconds);
-  free(aux);
-  SDL_Rect rect = {
-      .x = TIME_POSITION.x, .y = TIME_POSITION.y, .w = 100, .h = 100};
-  asset_t *asset = asset_make_text(GAME_FONT_PATH, rect, text, get_blue());
-  return asset;
+/* MOUSE HANDLER */
+void on_click(state_t *state, double x, double y) {
+  asset_cache_handle_buttons(state->assets, state, x, y);
 }
 
 /* EMSCRIPTEN FUNCTIONS */
 state_t *emscripten_init() {
-  asset_cache_init();
-  sdl_init(MIN, MAX);
+  state_t *state = malloc(sizeof(state_t));
+  assert(state != NULL);
+  state->sdl = sdl_init(MIN, MAX);
+  state->assets = asset_cache_init(state->sdl);
+  asset_cache_pack_images(state->assets, PACKED_IMAGE_PATHS,
+                          NUM_PACKED_IMAGES);
+  sdl_on_click(state->sdl, (mouse_handler_t)on_click);
   // Initialie mixer
   Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 1, 2048);
   Mix_AllocateChannels(1);
-  state_t *state = malloc(sizeof(state_t));
+  state->tuning = ai_default_tuning();
   state->villain_type = MEDIUM_AI;
+  state->num_opponents = 1;
+  update_opponents_text(state);
+  state->track_idx = 0;
+  state->track = track_load(TRACK_PATHS[state->track_idx]);
+  assert(state->track != NULL);
   state->scene = scene_init();
   state->game_state = MENU;
-  srand(time(NULL));
+  scene_seed(state->scene, time(NULL));
   restart_game(state);
   return state;
 }
@@ -810,8 +858,8 @@ void toggle_pause(state_t *state) {
   if (state->game_state == RACE) {
     state->game_state = PAUSE;
     state->home_button = create_button_from_info(state, HOME_BUTTON);
-    state->instructions =
-        asset_make_image(INSTRUCTIONS_FILE_PATH, INSTRUCTIONS_BOX_PAUSE);
+    state->instructions = asset_make_image(
+        state->assets, INSTRUCTIONS_FILE_PATH, INSTRUCTIONS_BOX_PAUSE);
   } else {
     state->game_state = RACE;
     asset_destroy(state->home_button);
@@ -831,20 +879,24 @@ void create_settings_buttons(state_t *state) {
 
 void open_settings(state_t *state) {
   menu_free(state);
-  state->menu_bg = asset_make_image(MENU_BACKGROUND_PATH, WINDOW);
+  state->menu_bg =
+      asset_make_image(state->assets, MENU_BACKGROUND_PATH, WINDOW);
   state->home_button = create_button_from_info(state, HOME_BUTTON);
   state->villain_chooser = list_init(NUM_VILLAINS, (free_func_t)asset_destroy);
   state->game_state = SETTINGS;
   for (size_t i = 0; i < NUM_VILLAINS; i++) {
-    asset_t *villain_choice =
-        asset_make_image(VILLAIN_CHOOSER_PATHS[i], VILLAIN_CHOOSER_BOX);
+    asset_t *villain_choice = asset_make_image(
+        state->assets, VILLAIN_CHOOSER_PATHS[i], VILLAIN_CHOOSER_BOX);
     list_add(state->villain_chooser, villain_choice);
   }
   state->settings_buttons =
       list_init(NUM_SETTINGS_BUTTONS, (free_func_t)asset_destroy);
   create_settings_buttons(state);
-  state->instructions =
-      asset_make_image(INSTRUCTIONS_FILE_PATH, INSTRUCTIONS_BOX_SETTINGS);
+  state->opponents_count =
+      asset_make_text(state->assets, GAME_FONT_PATH, OPPONENTS_BOX,
+                      state->opponents_text, get_blue());
+  state->instructions = asset_make_image(
+      state->assets, INSTRUCTIONS_FILE_PATH, INSTRUCTIONS_BOX_SETTINGS);
 }
 
 void settings_free(state_t *state) {
@@ -852,14 +904,16 @@ void settings_free(state_t *state) {
   asset_destroy(state->menu_bg);
   asset_destroy(state->instructions);
   asset_destroy(state->home_button);
+  asset_destroy(state->opponents_count);
 }
 
 void show_settings(state_t *state) {
   asset_render(state->menu_bg);
   asset_render(list_get(state->villain_chooser, state->villain_type));
-  for (size_t i = 0; i < 2; i++) {
+  for (size_t i = 0; i < NUM_SETTINGS_BUTTONS; i++) {
     asset_render(list_get(state->settings_buttons, i));
   }
+  asset_render(state->opponents_count);
   asset_render(state->instructions);
   asset_render(state->home_button);
 }
@@ -872,11 +926,12 @@ void restart_game(state_t *state) {
     settings_free(state);
     state->game_state = MENU;
   }
-  state->menu_bg = asset_make_image(MENU_BACKGROUND_PATH, WINDOW);
+  state->menu_bg =
+      asset_make_image(state->assets, MENU_BACKGROUND_PATH, WINDOW);
   state->car_options = list_init(NUM_CARS, (free_func_t)asset_destroy);
   state->car_stats = list_init(NUM_CARS, (free_func_t)asset_destroy);
   state->car_type = F1;
-  state->logo = asset_make_image(GAME_LOGO_PATH, GAME_LOGO);
+  state->logo = asset_make_image(state->assets, GAME_LOGO_PATH, GAME_LOGO);
 
   // Load audio files
   state->menu_music = Mix_LoadWAV(MENU_MUSIC);
@@ -886,9 +941,11 @@ void restart_game(state_t *state) {
   Mix_Volume(-1, MIX_MAX_VOLUME);
 
   for (size_t i = 0; i < NUM_CARS; i++) {
-    asset_t *car_img = asset_make_image(get_car_img_path(i), CAR_BOX);
+    asset_t *car_img =
+        asset_make_image(state->assets, get_car_img_path(i), CAR_BOX);
     list_add(state->car_options, car_img);
-    asset_t *car_stat = asset_make_image(CAR_STAT_PATHS[i], CAR_STATS_BOX);
+    asset_t *car_stat =
+        asset_make_image(state->assets, CAR_STAT_PATHS[i], CAR_STATS_BOX);
     list_add(state->car_stats, car_stat);
   }
 
@@ -899,78 +956,36 @@ void restart_game(state_t *state) {
 void show_race(state_t *state, double dt) {
   state->time += dt;
   power_up_info_t info = car_get_powerup_state(state->car);
-  if (info.stun > 0) {
+  if (scene_get_time(state->scene) < info.stun_until) {
     body_set_rotation(state->car,
                       body_get_rotation(state->car) + dt * STUN_ROT_SPEED);
   }
-  info.fast -= dt;
-  info.immune -= dt;
-  info.reverse -= dt;
-  info.stun -= dt;
-  if (info.immune <= 0 && info.immune > -dt) {
-    Mix_HaltChannel(0);
-    Mix_PlayChannel(0, state->game_music, -1);
-  }
-  power_up_info_t villain_info = car_get_powerup_state(state->villain);
-  if (villain_info.stun > 0) {
-    body_set_rotation(state->villain,
-                      body_get_rotation(state->villain) + dt * STUN_ROT_SPEED);
-  }
-  villain_info.fast -= dt;
-  villain_info.immune -= dt;
-  villain_info.reverse -= dt;
-  villain_info.stun -= dt;
-  car_set_powerup_state(state->car, info);
-  scene_tick(state->scene, dt);
+  scene_tick_bounded(state->scene, dt, WALL_RADIUS);
   scene_center_body(state->scene, state->car, SPAWN_POS);
-  update_shell(state->car, dt);
-  update_mini_map(state);
+  update_shell(state->shells, state->car, dt);
   update_arrow(state);
-  fix_villain_path(state->villain);
-  size_t size = list_size(state->body_assets);
-  for (ssize_t i = 0; i < size; i++) {
-    asset_t *curr = list_get(state->body_assets, i);
-    body_t *body = asset_get_body(curr);
-    if (body == NULL) {
-      list_remove(state->body_assets, i);
-      i--;
-      size--;
-    } else {
-      asset_render(curr);
-    }
+  ai_tick(state->ai, state->car, dt);
+  for (size_t i = 0; i < slot_map_size(state->body_assets); i++) {
+    asset_render(slot_map_get_at(state->body_assets, i));
   }
-  size = list_size(state->boxes);
+  item_pool_render(state->boosts);
+  item_pool_render(state->fake_boxes);
+  size_t size = list_size(state->boxes);
   for (size_t i = 0; i < size; i++) {
     asset_t *box = list_get(state->boxes, i);
-    if (update_box(box, dt)) {
+    if (box_is_ready(box)) {
       asset_render(box);
     }
   }
-  size = list_size(state->shells);
-  for (ssize_t i = 0; i < size; i++) {
-    asset_t *curr = list_get(state->shells, i);
-    body_t *body = asset_get_body(curr);
-    if (body == NULL) {
-      list_remove(state->shells, i);
-      i--;
-      size--;
-    } else {
-      asset_render(curr);
-    }
-  }
+  item_pool_render(state->shells);
   car_respawn(state->car);
   handle_checkpoint_state(state, dt);
-  asset_render(state->mini_map);
-  asset_render(state->mini_car);
-  asset_render(state->mini_villain);
-  asset_t *time_asset = make_time_asset(state->time);
-  asset_render(time_asset);
-  asset_destroy(time_asset);
+  render_mini_map(state);
+  update_time_text(state);
+  asset_render(state->time_asset);
   power_up_type_t power = car_get_powerup_state(state->car).power_up;
   if (power > 0) {
-    asset_t *item = item_asset(power);
-    asset_render(item);
-    asset_destroy(item);
+    asset_render(list_get(state->item_icons, power));
   }
   asset_render(state->pause_button);
   if (car_get_laps_done(state->car) == NO_LAPS) {
@@ -989,8 +1004,8 @@ void pause_game(state_t *state) {
 }
 
 bool emscripten_main(state_t *state) {
-  double dt = time_since_last_tick();
-  sdl_clear();
+  double dt = time_since_last_tick(state->sdl);
+  sdl_clear(state->sdl);
   switch (state->game_state) {
   case MENU:
     show_menu(state);
@@ -1007,7 +1022,7 @@ bool emscripten_main(state_t *state) {
   default:
     assert(false && "invalid state");
   }
-  sdl_show();
+  sdl_show(state->sdl);
 
   return false;
 }
@@ -1017,8 +1032,12 @@ void emscripten_free(state_t *state) {
   Mix_FreeChunk(state->game_music);
   Mix_FreeChunk(state->star_music);
   Mix_Quit();
-  list_free(state->body_assets);
+  slot_map_free(state->body_assets);
   scene_free(state->scene);
-  asset_cache_destroy();
+  track_free(state->track);
+  asset_cache_destroy(state->assets);
+  sdl_free(state->sdl);
   free(state);
 }
+
+sdl_context_t *emscripten_get_sdl(state_t *state) { return state->sdl; }
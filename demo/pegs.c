@@ -201,43 +201,41 @@ void add_pegs(scene_t *scene) {
 /** Adds the walls to the scene */
 void add_walls(scene_t *scene) {
   // Add walls
-  list_t *rect_list = rect_init(WALL_LENGTH, WALL_WIDTH);
-  // delete below later
-  polygon_t *rect = polygon_init(rect_list, VEC_ZERO, 0, 0, 0, 0);
-
-  polygon_translate(rect, (vector_t){.x = WALL_LENGTH / 2, .y = 0.0});
-  polygon_rotate(rect, WALL_ANGLE, VEC_ZERO);
-  body_t *body = body_init_with_info(polygon_get_points(rect), INFINITY,
-                                     WALL_COLOR, make_type_info(WALL), free);
+  // Each wall starts centered on the origin, then is rotated in place and
+  // moved so that its bottom end is at a bottom corner of the window
+  vector_t half_wall = {.x = WALL_LENGTH / 2, .y = 0.0};
+  body_t *body =
+      body_init_with_info(rect_init(WALL_LENGTH, WALL_WIDTH), INFINITY,
+                          WALL_COLOR, make_type_info(WALL), free);
+  body_set_rotation(body, WALL_ANGLE);
+  body_set_centroid(body, vec_rotate(half_wall, WALL_ANGLE));
   scene_add_body(scene, body);
 
-  rect_list = rect_init(WALL_LENGTH, WALL_WIDTH);
-  rect = polygon_init(rect_list, VEC_ZERO, 0, 0, 0, 0);
-  polygon_translate(rect, (vector_t){.x = MAX.x - WALL_LENGTH / 2, .y = 0.0});
-  polygon_rotate(rect, -WALL_ANGLE, (vector_t){.x = MAX.x, .y = 0.0});
-  body = body_init_with_info(polygon_get_points(rect), INFINITY, WALL_COLOR,
-                             make_type_info(WALL), free);
+  body = body_init_with_info(rect_init(WALL_LENGTH, WALL_WIDTH), INFINITY,
+                             WALL_COLOR, make_type_info(WALL), free);
+  body_set_rotation(body, -WALL_ANGLE);
+  body_set_centroid(body, vec_add((vector_t){.x = MAX.x, .y = 0.0},
+                                  vec_rotate(vec_negate(half_wall),
+                                             -WALL_ANGLE)));
   scene_add_body(scene, body);
 
   // Ground is special; it freezes balls when they touch it
-  rect_list = rect_init(MAX.x, WALL_WIDTH);
-  rect = polygon_init(rect_list, VEC_ZERO, 0, 0, 0, 0);
-  body = body_init_with_info(polygon_get_points(rect), INFINITY, WALL_COLOR,
-                             make_type_info(FROZEN), free);
+  body = body_init_with_info(rect_init(MAX.x, WALL_WIDTH), INFINITY,
+                             WALL_COLOR, make_type_info(FROZEN), free);
   body_set_centroid(body, (vector_t){.x = MAX.x / 2, .y = WALL_WIDTH / 2});
   scene_add_body(scene, body);
 }
 
 typedef struct state {
+  sdl_context_t *sdl;
   scene_t *scene;
   double time_since_drop;
 } state_t;
 
 state_t *emscripten_init(void) {
   srand(time(NULL));
-  asset_cache_init();
   // Initialize scene
-  sdl_init(VEC_ZERO, MAX);
+  sdl_context_t *sdl = sdl_init(VEC_ZERO, MAX);
   scene_t *scene = scene_init();
   // Add elements to the scene
   add_gravity_body(scene);
@@ -247,13 +245,14 @@ state_t *emscripten_init(void) {
   double time_since_drop = INFINITY;
 
   state_t *state = malloc(sizeof(state_t));
+  state->sdl = sdl;
   state->scene = scene;
   state->time_since_drop = time_since_drop;
   return state;
 }
 
 bool emscripten_main(state_t *state) {
-  double dt = time_since_last_tick();
+  double dt = time_since_last_tick(state->sdl);
   // Add a new ball every DROP_INTERVAL seconds
   state->time_since_drop += dt;
   if (state->time_since_drop > DROP_INTERVAL) {
@@ -261,12 +260,15 @@ bool emscripten_main(state_t *state) {
     state->time_since_drop = 0.0;
   }
   scene_tick(state->scene, dt);
-  sdl_render_scene(state->scene, NULL);
+  sdl_render_scene(state->sdl, state->scene, NULL);
 
   return false;
 }
 
 void emscripten_free(state_t *state) {
   scene_free(state->scene);
+  sdl_free(state->sdl);
   free(state);
 }
+
+sdl_context_t *emscripten_get_sdl(state_t *state) { return state->sdl; }
@@ -0,0 +1,144 @@
+#ifndef __AI_H__
+#define __AI_H__
+
+#include "body.h"
+#include "car.h"
+#include "list.h"
+#include "scene.h"
+#include "track.h"
+
+/**
+ * The computer-controlled cars in a race.
+ * The cars are kept in one array and are all updated by a single call to
+ * ai_tick() each frame, rather than each subsystem special-casing a villain.
+ *
+ * How much work each car gets depends on how far it is from the player:
+ * near cars are steered every tick, cars further away are steered a few times
+ * a second, and cars out of sight are taken off the physics simulation and
+ * moved along the track's centerline by their speed. Cars switch back to
+ * full physics as they come near the player.
+ */
+typedef struct ai ai_t;
+
+/**
+ * How much detail an AI car is simulated in.
+ */
+typedef enum {
+  /** Full physics and steering every tick. */
+  AI_LOD_NEAR,
+  /** Full physics, but steering only a few times a second. */
+  AI_LOD_MID,
+  /** Kinematic, moved along the track path without physics. */
+  AI_LOD_FAR
+} ai_lod_t;
+
+/**
+ * The tunable parameters of the AI: how fast each difficulty drives and how
+ * closely cars follow their checkpoints. This is a plain value, so each race
+ * (or each race of a tournament) can be tuned independently.
+ */
+typedef struct ai_tuning {
+  double easy_speed;
+  double medium_speed;
+  double hard_speed;
+  /** See ai_init(). */
+  double path_tolerance;
+} ai_tuning_t;
+
+/**
+ * Returns the tuning the game ships with.
+ */
+ai_tuning_t ai_default_tuning(void);
+
+/**
+ * Returns the top speed of an AI car of the given difficulty.
+ *
+ * @param tuning the AI tuning
+ * @param type the difficulty of the car
+ * @param best_time the player's best lap time, which the ghost is as fast as
+ * @return the car's top speed
+ */
+double ai_villain_speed(ai_tuning_t tuning, villain_type_t type,
+                        double best_time);
+
+/**
+ * Allocates an empty set of AI cars.
+ *
+ * @param path_tolerance how closely a car must already be facing its next
+ *   checkpoint before it snaps to face it exactly
+ * @param stun_rot_speed how fast a stunned car spins, in radians per second
+ * @return a pointer to the newly allocated AI
+ */
+ai_t *ai_init(double path_tolerance, double stun_rot_speed);
+
+/**
+ * Releases the memory allocated for the AI.
+ * Does not free the cars, which belong to the scene.
+ *
+ * @param ai a pointer returned from ai_init()
+ */
+void ai_free(ai_t *ai);
+
+/**
+ * Gives the AI the track to move far cars along, and the scene near cars look
+ * for walls and other cars in. Until this is called every car is fully
+ * simulated and drives straight at its checkpoints.
+ *
+ * @param ai a pointer returned from ai_init()
+ * @param scene the scene the cars are in
+ * @param track the track being raced on
+ * @param anchor a track walls body (see body_init_track_walls()), used to
+ *   find where the track currently is in the scene
+ * @param checkpoints the checkpoints of the track, one per path point, which
+ *   far cars cross as they pass each path point
+ */
+void ai_set_track(ai_t *ai, scene_t *scene, track_t *track, body_t *anchor,
+                  list_t *checkpoints);
+
+/**
+ * Hands a car over to the AI. The car must already have a checkpoint state.
+ *
+ * @param ai a pointer returned from ai_init()
+ * @param car the car to drive
+ */
+void ai_add_car(ai_t *ai, body_t *car);
+
+/**
+ * Returns the number of cars driven by the AI.
+ */
+size_t ai_num_cars(ai_t *ai);
+
+/**
+ * Returns the car at a given index. Asserts that the index is valid.
+ */
+body_t *ai_get_car(ai_t *ai, size_t idx);
+
+/**
+ * Returns the list of cars driven by the AI, e.g. to register collisions.
+ * The list belongs to the AI and must not be modified.
+ */
+list_t *ai_get_cars(ai_t *ai);
+
+/**
+ * Returns the level of detail a car was simulated in on the last tick.
+ */
+ai_lod_t ai_get_lod(ai_t *ai, size_t idx);
+
+/**
+ * Returns how many cars were simulated in a level of detail on the last tick.
+ */
+size_t ai_count_lod(ai_t *ai, ai_lod_t lod);
+
+/**
+ * Updates every AI car for one tick: counts down their power ups, spins the
+ * stunned ones, picks each car's level of detail, steers or moves it
+ * accordingly and counts the laps they finish.
+ *
+ * @param ai a pointer returned from ai_init()
+ * @param player the player's car, which decides each car's level of detail,
+ *   or NULL to fully simulate every car (e.g. in a race without a player)
+ * @param dt the number of seconds elapsed since the last tick
+ */
+void ai_tick(ai_t *ai, body_t *player, double dt);
+
+#endif // #ifndef __AI_H__
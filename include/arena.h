@@ -0,0 +1,59 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A region allocator. Allocations are bumped out of large chunks and are
+ * never freed on their own: the whole arena is released at once by
+ * arena_reset() or arena_free(). Chunks are kept across resets, so an arena
+ * that is reset and refilled with the same allocations calls malloc() only
+ * the first time.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates an empty arena.
+ * Asserts that the required memory was allocated.
+ *
+ * @param chunk_size the size in bytes of the chunks to allocate from.
+ *   Larger allocations get a chunk of their own.
+ * @return a pointer to the newly allocated arena
+ */
+arena_t *arena_init(size_t chunk_size);
+
+/**
+ * Releases an arena and every allocation made from it.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Allocates memory from an arena, aligned for any type.
+ * Asserts that the required memory was allocated.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return a pointer to the memory, valid until the arena is reset or freed
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Releases every allocation made from an arena in constant time, keeping its
+ * chunks to allocate from again.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Gets the number of bytes allocated from an arena since it was last reset,
+ * including the padding for alignment and the unused ends of full chunks.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @return the number of bytes in use
+ */
+size_t arena_used(arena_t *arena);
+
+#endif // #ifndef __ARENA_H__
@@ -2,13 +2,30 @@
 #define __ASSET_H__
 
 #include "sdl_wrapper.h"
+#include "state.h"
 #include <color.h>
 #include <stddef.h>
 
-typedef enum { ASSET_IMAGE, ASSET_FONT, ASSET_BUTTON } asset_type_t;
+/**
+ * The types of assets. ASSET_TILED_IMAGE is only the type of the tiled images
+ * in an asset cache; assets drawing them are ASSET_IMAGE.
+ */
+typedef enum {
+  ASSET_IMAGE,
+  ASSET_FONT,
+  ASSET_BUTTON,
+  ASSET_TILED_IMAGE
+} asset_type_t;
 
 typedef struct asset asset_t;
 
+/**
+ * The cache the images and fonts of assets are loaded through
+ * (see asset_cache.h). Assets are rendered in the SDL context of the cache
+ * they were made with.
+ */
+typedef struct asset_cache asset_cache_t;
+
 /**
  * Gets the `asset_type_t` of the asset.
  *
@@ -20,48 +37,83 @@ asset_type_t asset_get_type(asset_t *asset);
  * Allocates memory for an image asset with the given parameters.
  * The image cannot be rotated
  *
+ * @param cache the cache to load the image through
  * @param filepath the filepath to the image file
  * @param bounding_box the bounding box containing the location and dimensions
  * of the text when it is rendered
  * @return a pointer to the newly allocated image asset
  */
-asset_t *asset_make_image(const char *filepath, SDL_Rect bounding_box);
+asset_t *asset_make_image(asset_cache_t *cache, const char *filepath,
+                          SDL_Rect bounding_box);
 
 /**
  * Allocates memory for an image asset with an attached body. When the asset
  * is rendered, the image will be rendered on top of the body.
  * The image cannot be rotated
  *
+ * @param cache the cache to load the image through
  * @param filepath the filepath to the image file
  * @param body the body to render the image on top of
  * @return a pointer to the newly allocated image asset
  */
-asset_t *asset_make_image_with_body(const char *filepath, body_t *body);
+asset_t *asset_make_image_with_body(asset_cache_t *cache, const char *filepath,
+                                    body_t *body);
 
 /**
  * Allocates memory for an image asset with an attached body. When the asset
  * is rendered, the image will be rendered on top of the body.
  * The image can be rotated
  *
+ * @param cache the cache to load the image through
  * @param filepath the filepath to the image file
  * @param body the body to render the image on top of
  * @return a pointer to the newly allocated image asset
  */
-asset_t *asset_make_rotatable_image_with_body(const char *filepath,
+asset_t *asset_make_rotatable_image_with_body(asset_cache_t *cache,
+                                              const char *filepath,
                                               body_t *body);
 
+/**
+ * Allocates memory for an image asset with an attached body, like
+ * asset_make_image_with_body(), for an image too large to be one texture.
+ * The image is loaded as a tiled image (see sdl_load_tiled_image()), and only
+ * the tiles on screen are drawn. The image cannot be rotated.
+ *
+ * @param cache the cache to load the image through
+ * @param filepath the filepath to the image file
+ * @param body the body to render the image on top of
+ * @return a pointer to the newly allocated image asset
+ */
+asset_t *asset_make_tiled_image_with_body(asset_cache_t *cache,
+                                          const char *filepath, body_t *body);
+
 /**
  * Allocates memory for a text asset with the given parameters.
  *
+ * @param cache the cache to load the font through
  * @param filepath the filepath to the .ttf file
  * @param bounding_box the bounding box containing the location and dimensions
  * of the text when it is rendered
- * @param text the text to render
+ * @param text the text to render, which is read every time the asset is
+ * rendered, so it can be updated in place
  * @param color the color of the text
  * @return a pointer to the newly allocated text asset
  */
-asset_t *asset_make_text(const char *filepath, SDL_Rect bounding_box,
-                         const char *text, rgb_color_t color);
+asset_t *asset_make_text(asset_cache_t *cache, const char *filepath,
+                         SDL_Rect bounding_box, const char *text,
+                         rgb_color_t color);
+
+/**
+ * Allocates memory for a text asset whose text changes most frames, like a
+ * timer. Text assets made with asset_make_text() keep a rendered texture of
+ * each string they draw (see sdl_draw_cached_text()), which would be wasted on
+ * such text, so this one is drawn glyph by glyph instead.
+ *
+ * Takes the same parameters as asset_make_text().
+ */
+asset_t *asset_make_dynamic_text(asset_cache_t *cache, const char *filepath,
+                                 SDL_Rect bounding_box, const char *text,
+                                 rgb_color_t color);
 
 /**
  * A button handler.
@@ -76,7 +128,8 @@ typedef void (*button_handler_t)(void *state);
  * `asset_destroy` will only free the memory allocated for the button.
  *
  * Asserts that `image_asset` is NULL or has type `ASSET_IMAGE`.
- * Asserts that `text_asset` is NULL or has type `ASSET_FONT`.
+ * Asserts that `text_asset` is NULL or has type `ASSET_FONT`, and that at
+ * least one of them is not NULL.
  *
  * @param bounding_box the bounding box containing the area on the screen that
  * should activate the button handler.
@@ -2,40 +2,72 @@
 #define __ASSET_CACHE_H__
 
 #include "asset.h"
+#include "sdl_wrapper.h"
 #include <stddef.h>
 
 /**
- * Initializes the empty, list-based global asset cache. The caller must then
- * destroy the cache with `asset_cache_destroy` when done.
+ * Initializes an empty asset cache, which loads its textures for the renderer
+ * of an SDL context. Assets are looked up in a hash map keyed by filepath, so
+ * getting an asset takes constant time however many are cached. The caller
+ * must then destroy the cache with `asset_cache_destroy` when done.
+ *
+ * @param sdl the context the cached assets are drawn in
+ * @return the new cache
+ */
+asset_cache_t *asset_cache_init(sdl_context_t *sdl);
+
+/**
+ * Frees an asset cache and its owned contents.
  */
-void asset_cache_init();
+void asset_cache_destroy(asset_cache_t *cache);
 
 /**
- * Frees the global asset cache and its owned contents.
+ * Returns the SDL context the cache was initialized with.
  */
-void asset_cache_destroy();
+sdl_context_t *asset_cache_get_sdl(asset_cache_t *cache);
 
 /**
  * Gets the pointer to the object that is associated with the given filepath.
  * If the object exists, asserts that its type matches the given type.
  *
  * If the object doesn't exist, adds a new entry to the asset cache and returns
- * the pointer to the newly created object.
+ * the pointer to the newly created object. Images are loaded as
+ * texture_region_t (see asset_cache_pack_images()), fonts as glyph atlases
+ * (see sdl_load_glyph_atlas()) and tiled images with sdl_load_tiled_image().
  *
  * Example:
  * ```
  * char *img_path = "assets/image.png";
- * SDL_Texture *obj = asset_cache_obj_get_or_create(ASSET_IMAGE, img_path);
+ * texture_region_t *obj =
+ *     asset_cache_obj_get_or_create(cache, ASSET_IMAGE, img_path);
  *
  * char *font_path = "assets/font.ttf";
- * TTF_Font *obj = asset_cache_obj_get_or_create(ASSET_FONT, font_path);
+ * glyph_atlas_t *obj =
+ *     asset_cache_obj_get_or_create(cache, ASSET_FONT, font_path);
  * ```
  *
+ * @param cache the cache to look in
  * @param ty the type of the asset
  * @param filepath the filepath to the asset
  * @return the object that corresponds to the filepath, as a void*
  */
-void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath);
+void *asset_cache_obj_get_or_create(asset_cache_t *cache, asset_type_t ty,
+                                    const char *filepath);
+
+/**
+ * Loads images into the cache packed together into a few atlas textures, so
+ * that drawing them can be batched. Call this at startup with the images
+ * that are drawn most; they are then returned by
+ * asset_cache_obj_get_or_create() like any other image. Images already in
+ * the cache, too large to pack or missing are skipped, and are loaded on
+ * their own when first used.
+ *
+ * @param cache the cache to load the images into
+ * @param paths the filepaths to the images
+ * @param count the number of images
+ */
+void asset_cache_pack_images(asset_cache_t *cache, const char *const *paths,
+                             size_t count);
 
 /**
  * Registers the button to the asset cache, effectively activating its button
@@ -44,17 +76,21 @@ void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath);
  *
  * Asserts that the type of `button` is ASSET_BUTTON.
  *
+ * @param cache the cache to register the button in
  * @param button pointer to the button asset
  */
-void asset_cache_register_button(asset_t *button);
+void asset_cache_register_button(asset_cache_t *cache, asset_t *button);
 
 /**
  * Runs `asset_on_button_click` on all the buttons stored in the asset cache.
+ * Usually called from a click handler registered with sdl_on_click().
  *
+ * @param cache the cache holding the buttons
  * @param state the game state
  * @param x the x position of the mouse click
  * @param y the y position of the mouse click
  */
-void asset_cache_handle_buttons(state_t *state, double x, double y);
+void asset_cache_handle_buttons(asset_cache_t *cache, state_t *state, double x,
+                                double y);
 
 #endif // #ifndef __ASSET_CACHE_H__
@@ -3,9 +3,11 @@
 
 #include <stdbool.h>
 
+#include "arena.h"
 #include "color.h"
 #include "list.h"
 #include "polygon.h"
+#include "track.h"
 
 /**
  * A rigid body constrained to the plane.
@@ -13,6 +15,20 @@
  */
 typedef struct body body_t;
 
+/**
+ * The shapes a body can collide as.
+ * Every body keeps a polygon, which is what gets drawn and moved around; the
+ * collider only changes how find_collision() tests it against other bodies.
+ */
+typedef enum {
+  /** The body's polygon. This is the default. */
+  COLLIDER_POLYGON,
+  /** A circle of the collider radius around the body's centroid. */
+  COLLIDER_CIRCLE,
+  /** The walls of a track, as capsules of the collider radius. */
+  COLLIDER_TRACK_WALLS
+} collider_type_t;
+
 /**
  * Initializes a body without any info.
  * Acts like body_init_with_info() where info and info_freer are NULL.
@@ -25,7 +41,8 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color);
  * The body is initially at rest.
  * Asserts that the mass is positive and that the required memory is allocated.
  *
- * @param shape a list of vectors describing the initial shape of the body
+ * @param shape a list of vectors describing the initial shape of the body.
+ *   The vectors are copied into the body and the list is freed.
  * @param mass the mass of the body (if INFINITY, stops the body from moving)
  * @param color the color of the body, used to draw it on the screen
  * @param info additional information to associate with the body,
@@ -37,7 +54,58 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer);
 
 /**
- * Releases the memory allocated for a body.
+ * Acts like body_init_with_info(), but allocates the body and its polygon
+ * from an arena, e.g. the scene_get_arena() of the scene the body goes in.
+ * body_free() then only frees the info; the rest is released along with
+ * everything else in the arena when it is reset or freed, so the body must be
+ * freed before that.
+ *
+ * @param arena the arena to allocate the body from
+ */
+body_t *body_init_in_arena(arena_t *arena, list_t *shape, double mass,
+                           rgb_color_t color, void *info,
+                           free_func_t info_freer);
+
+/**
+ * Acts like body_init_with_info(), but copies the shape from an array of
+ * vertices instead of a list.
+ *
+ * @param arena the arena to allocate the body from, as in
+ *   body_init_in_arena(), or NULL to allocate it like body_init_with_info()
+ * @param shape the vertices of the initial shape of the body
+ */
+body_t *body_init_span(arena_t *arena, vertex_span_t shape, double mass,
+                       rgb_color_t color, void *info, free_func_t info_freer);
+
+/**
+ * Acts like body_init_span() with the corners of a rectangle, which are
+ * written straight into the body's polygon (see polygon_init_rect()).
+ *
+ * @param center the center of the rectangle
+ * @param w the width of the rectangle
+ * @param h the height of the rectangle
+ */
+body_t *body_init_rect(arena_t *arena, vector_t center, double w, double h,
+                       double mass, rgb_color_t color, void *info,
+                       free_func_t info_freer);
+
+/**
+ * Allocates a single immovable body that collides as every wall of a track.
+ * Its polygon is the background rectangle of the track, so it moves with the
+ * rest of the scene; the walls are looked up in the track's grid relative to
+ * wherever that rectangle currently is.
+ *
+ * @param track the track whose walls to collide with; must outlive the body
+ * @param radius how far the walls extend on either side of their segments
+ * @param color the color of the body
+ * @return a pointer to the newly allocated body
+ */
+body_t *body_init_track_walls(track_t *track, double radius,
+                              rgb_color_t color);
+
+/**
+ * Releases the memory allocated for a body. Of a body from
+ * body_init_in_arena(), only the info is freed.
  *
  * @param body a pointer to a body returned from body_init()
  */
@@ -102,6 +170,39 @@ double body_get_mass(body_t *body);
  */
 polygon_t *body_get_polygon(body_t *body);
 
+/**
+ * Gets the kind of shape a body collides as.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's collider type
+ */
+collider_type_t body_get_collider_type(body_t *body);
+
+/**
+ * Gets the radius of a body's circle or track wall collider.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the collider radius, or 0 for polygon colliders
+ */
+double body_get_collider_radius(body_t *body);
+
+/**
+ * Gets the track of a body made with body_init_track_walls().
+ *
+ * @param body a pointer to a track wall body
+ * @return the track the body collides as
+ */
+track_t *body_get_track(body_t *body);
+
+/**
+ * Gets how far a track wall body has moved since it was created, i.e. the
+ * vector to add to the track's coordinates to get scene coordinates.
+ *
+ * @param body a pointer to a track wall body
+ * @return the offset of the track in the scene
+ */
+vector_t body_get_track_offset(body_t *body);
+
 /**
  * Return the info associated with a body.
  *
@@ -118,6 +219,34 @@ void *body_get_info(body_t *body);
  */
 void body_set_color(body_t *body, rgb_color_t *col);
 
+/**
+ * Makes a body collide as a circle around its centroid instead of as its
+ * polygon. Circles are cheaper to test and slide along walls smoothly.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param radius the radius of the circle
+ */
+void body_set_circle_collider(body_t *body, double radius);
+
+/**
+ * Makes a body kinematic, or makes it dynamic again.
+ * A kinematic body is moved only by whoever owns it: body_tick() leaves it
+ * where it is and collisions with it are skipped, so it costs almost nothing
+ * to simulate. Bodies are dynamic when they are created.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param kinematic whether the body should be kinematic
+ */
+void body_set_kinematic(body_t *body, bool kinematic);
+
+/**
+ * Returns whether a body is kinematic; see body_set_kinematic().
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return whether the body is kinematic
+ */
+bool body_is_kinematic(body_t *body);
+
 /**
  * Translates a body to a new position.
  * The position is specified by the position of the body's center of mass.
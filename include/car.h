@@ -5,7 +5,10 @@
 #include "body.h"
 #include "checkpoints.h"
 #include "list.h"
+#include "minimap.h"
 #include "power_up.h"
+#include "scene.h"
+#include "slot_map.h"
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -23,13 +26,18 @@ typedef struct ghost_info ghost_info_t;
 
 typedef enum { EASY_AI, MEDIUM_AI, HARD_AI, GHOST } villain_type_t;
 
+/**
+ * A car's item and the effects acting on it. Each effect lasts until the
+ * scene time (see scene_get_time()) stored in its `_until` field, so nothing
+ * needs to count them down every tick.
+ */
 typedef struct power_up_info {
   size_t power_up;
-  double immune;
-  double stun;
-  double reverse;
-  double fast;
-  body_t *shell;
+  double immune_until;
+  double stun_until;
+  double reverse_until;
+  double fast_until;
+  handle_t shell; // in the race's pool of shells
 } power_up_info_t;
 
 /**
@@ -105,6 +113,18 @@ double car_get_acceleration(body_t *car);
  */
 double car_get_top_speed(body_t *car);
 
+/**
+ * Registers every car's collisions with every checkpoint as a single group
+ * collision, updating the checkpoint state of whichever car crossed.
+ * Each car must already have its own checkpoint state.
+ *
+ * @param scene the scene containing the bodies
+ * @param cars the cars in the race
+ * @param checkpoints the checkpoints shared by all of the cars
+ */
+void create_checkpoint_collisions(scene_t *scene, list_t *cars,
+                                  list_t *checkpoints);
+
 /**
  * Function to call in main that returns a body to the last
  * checkpoint if it accidentally leaves the track
@@ -112,17 +132,18 @@ double car_get_top_speed(body_t *car);
 void car_respawn(body_t *car);
 
 /**
- * A function that initializes a car body with the given type.
+ * A function that initializes a car body with the given type, allocated from
+ * an arena (see body_init_in_arena()).
  * Returns a pointer to the initialized car body.
  */
-body_t *make_car(car_type_t type);
+body_t *make_car(arena_t *arena, car_type_t type);
 
 /**
  * A function that initializes a image asset from the given car body.
- * Choses the image based on the car type.
+ * Choses the image based on the car type, loaded through `cache`.
  * Returns a pointer to the initialized image asset.
  */
-asset_t *make_car_image(body_t *car);
+asset_t *make_car_image(asset_cache_t *cache, body_t *car);
 
 /**
  * A function that returns the filepath for a car of a given type
@@ -130,16 +151,16 @@ asset_t *make_car_image(body_t *car);
 const char *get_car_img_path(car_type_t type);
 
 /**
- * A function that takes in a car an returns a mini version of it
- * for the mini-map.
- * Returns a pointer to the initialized image asset.
+ * A function that returns the minimap marker of the player's car, given the
+ * car type, with its image loaded through `cache`.
  */
-asset_t *make_mini_car(car_type_t type);
+minimap_marker_t make_mini_car_marker(asset_cache_t *cache, car_type_t type);
 
 /**
- * A function that returns the body for the mini villain asset, given the
- * villain type.
+ * A function that returns the minimap marker of a villain, given the villain
+ * type, with its image loaded through `cache`.
  */
-asset_t *make_mini_villain(villain_type_t type);
+minimap_marker_t make_mini_villain_marker(asset_cache_t *cache,
+                                          villain_type_t type);
 
 #endif // #ifndef __CAR_H__
\ No newline at end of file
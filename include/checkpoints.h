@@ -4,6 +4,7 @@
 #include "asset.h"
 #include "body.h"
 #include "list.h"
+#include "track.h"
 #include "vector.h"
 
 typedef struct checkpoint_state checkpoint_state_t;
@@ -11,13 +12,13 @@ typedef struct checkpoint_state checkpoint_state_t;
 typedef struct checkpoint_info checkpoint_info_t;
 
 /**
- * Function to create a list of checkpoints between the given in_wall and
- * out_wall Requires that in_wall and out_wall are the same length
- * Accepts a start state which indicates the start and finish line.
- * Accepts an offset for the start index relative to the list
+ * Function to create a list of checkpoints from a track's gates.
+ * Gate 0 is the start and finish line and the rest follow in race order.
+ * The checkpoint bodies are allocated from an arena (see
+ * body_init_in_arena()); the list itself is not.
  */
-list_t *make_checkpoints(list_t *in_wall, list_t *out_wall, vector_t start_i,
-                         vector_t start_o, size_t start_offset);
+list_t *make_checkpoints(arena_t *arena, const track_gate_t *gates,
+                         size_t num_gates);
 
 /**
  * Function to get the index of a checkpoint body
@@ -38,6 +39,7 @@ void reset_checkpoint_state(checkpoint_state_t *checkpoint_state);
 
 /**
  * Function to free the memory allocated for checkpoint state.
+ * The checkpoints are shared between every car's state, so they are not freed.
  */
 void checkpoint_state_free(checkpoint_state_t *checkpoint_state);
 
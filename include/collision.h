@@ -22,8 +22,99 @@ typedef struct {
   vector_t axis;
 } collision_info_t;
 
+/**
+ * Computes the collision between a convex polygon and a capsule, i.e. all of
+ * the points within `radius` of the segment from `a` to `b`.
+ * With a radius of 0 this is a plain line segment, and with `a` equal to `b`
+ * it is a circle.
+ *
+ * @param shape the vertices of the polygon in counterclockwise order
+ * @param a the start of the segment
+ * @param b the end of the segment
+ * @param radius the radius of the capsule
+ * @param depth if non-NULL, where to store how far the shapes overlap
+ * @return whether the shapes are colliding, and if so, the collision axis
+ *   pointing from the polygon towards the capsule
+ */
+collision_info_t find_collision_polygon_segment(vertex_span_t shape,
+                                                vector_t a, vector_t b,
+                                                double radius, double *depth);
+
+/**
+ * Computes the collision between a circle and a capsule.
+ * With `a` equal to `b` this is the collision between two circles.
+ *
+ * @param center the center of the circle
+ * @param circle_radius the radius of the circle
+ * @param a the start of the segment
+ * @param b the end of the segment
+ * @param radius the radius of the capsule
+ * @param depth if non-NULL, where to store how far the shapes overlap
+ * @return whether the shapes are colliding, and if so, the collision axis
+ *   pointing from the circle towards the capsule
+ */
+collision_info_t find_collision_circle_segment(vector_t center,
+                                               double circle_radius, vector_t a,
+                                               vector_t b, double radius,
+                                               double *depth);
+
+/**
+ * Casts a ray at a capsule, i.e. all of the points within `radius` of the
+ * segment from `a` to `b`. Only rays entering the capsule from outside hit it.
+ * Casting a circle of radius r is the same as casting a ray at a capsule
+ * whose radius is r larger.
+ *
+ * @param origin where the ray starts
+ * @param direction the unit direction of the ray
+ * @param max_distance how far the ray reaches
+ * @param a the start of the segment
+ * @param b the end of the segment
+ * @param radius the radius of the capsule
+ * @param distance where to store how far along the ray it hits the capsule
+ * @param normal where to store the unit normal of the capsule at the hit
+ * @return whether the ray hits the capsule within max_distance
+ */
+bool raycast_segment(vector_t origin, vector_t direction, double max_distance,
+                     vector_t a, vector_t b, double radius, double *distance,
+                     vector_t *normal);
+
+/** The most walls find_wall_collisions() reports for one body */
+#define WALL_COLLISIONS_MAX 8
+
+/**
+ * A wall of a track walls body that another body is touching.
+ */
+typedef struct {
+  /** The index of the wall in track_get_walls() */
+  size_t wall;
+  /**
+   * The collision axis, pointing from the body towards the wall. Walls are
+   * one-sided: this is always the wall's normal pointing out of the drivable
+   * area, so a body pushed into a wall is pushed back onto the track rather
+   * than out the other side.
+   */
+  vector_t axis;
+  /** How far the body overlaps the wall */
+  double depth;
+} wall_collision_t;
+
+/**
+ * Finds each wall of a track walls body that a polygon or circle body is
+ * touching. Only the walls in the grid cells under the body are tested.
+ * If the body touches more than WALL_COLLISIONS_MAX walls, the deepest are
+ * kept.
+ *
+ * @param body the polygon or circle body
+ * @param walls a body made with body_init_track_walls()
+ * @param collisions where to store the walls the body touches, once each
+ * @return the number of walls stored
+ */
+size_t find_wall_collisions(body_t *body, body_t *walls,
+                            wall_collision_t collisions[WALL_COLLISIONS_MAX]);
+
 /**
  * Computes the status of the collision between two bodies.
+ * Dispatches on the bodies' collider types; see collider_type_t.
  *
  * @param body1 the first body
  * @param body2 the second body
@@ -1,6 +1,7 @@
 #ifndef __COLOR_H__
 #define __COLOR_H__
 
+#include "rng.h"
 #include <stdbool.h>
 
 typedef struct color {
@@ -22,9 +23,10 @@ rgb_color_t *color_init(double red, double green, double blue);
 /**
  * Randomly generate rgb values for color of polygon.
  *
+ * @param rng the generator to draw the values from
  * @return a pointer to a color object with randomly generated rgb values
  */
-rgb_color_t *color_get_random();
+rgb_color_t *color_get_random(rng_t *rng);
 
 /**
  * Compare the rgb values of two color structs.
@@ -1,32 +1,43 @@
 #ifndef __FORCES_H__
 #define __FORCES_H__
 
+#include "arena.h"
 #include "collision.h"
 #include "scene.h"
 
 /**
- * A grouping of a force creator and its auxillary info.
+ * The state of a collision force creator, as returned by create_collision() and
+ * create_group_collision(). It lives as long as the force creator does.
  */
-typedef struct force_info force_info_t;
+typedef struct collision collision_t;
 
 /**
  * Initializes a force info type with params given
  * Takes ownership of the force creator and auxillary info
+ * @param arena: the arena to allocate the force info from
  * @param info: the auxillary info for the force
  * @param force: the force creator
  * @param bodies: the bodies the force acts on
+ * @param info_freer: if non-NULL, the function to free info with
  * @return the force info type
  */
-force_info_t *force_info_init(void *info, force_creator_t force,
-                              list_t *bodies);
+force_info_t *force_info_init(arena_t *arena, void *info, force_creator_t force,
+                              list_t *bodies, free_func_t info_freer);
 
 /**
- * Frees a force info type
- * Frees the force creator and auxillary info
+ * Frees the auxillary info and body list of a force info type. The force info
+ * itself lives until its arena is reset or freed.
  * @param force_info: the force info type to free returned by force_info_init
  */
 void force_info_free(force_info_t *force_info);
 
+/**
+ * Frees malloc'd auxillary info whose second field is a list of bodies, as
+ * passed to scene_add_bodies_force_creator(): frees the list and the info.
+ * @param aux: the auxillary info to free
+ */
+void body_aux_free(void *aux);
+
 /**
  * Gets the force creator from a force info type
  * @param f_inf: the force info type to get the force creator from
@@ -110,6 +121,9 @@ void create_drag(scene_t *scene, double gamma, body_t *body);
  * allowing different things to happen on a collision.
  * The handler is passed the bodies, the collision axis, and an auxiliary value.
  * It should only be called once while the bodies are still colliding.
+ * With a track walls body (see body_init_track_walls()), each wall the other
+ * body touches is a collision of its own, so reaching a second wall while
+ * still touching the first calls the handler again with its axis.
  *
  * @param scene the scene containing the bodies
  * @param body1 the first body
@@ -117,10 +131,60 @@ void create_drag(scene_t *scene, double gamma, body_t *body);
  * @param handler a function to call whenever the bodies collide
  * @param aux an auxiliary value to pass to the handler
  * @param force_const a constant to pass to the handler
+ * @return the collision, where body1 is slot 0 and body2 is slot 1
+ */
+collision_t *create_collision(scene_t *scene, body_t *body1, body_t *body2,
+                              collision_handler_t handler, void *aux,
+                              double force_const);
+
+/**
+ * Adds a single force creator to a scene that calls a collision handler for
+ * every colliding pair of bodies from one or two groups, like create_collision()
+ * does for a single pair.
+ * Each tick the bodies' bounding boxes are sorted and swept along the x axis,
+ * so only the pairs whose boxes overlap are tested with find_collision(),
+ * instead of registering a force creator for every possible pair.
+ * Like any other force creator, it is removed when any of its bodies is.
+ * Each pair has a single contact, so track walls bodies can't be in the
+ * groups; collide with them using create_collision().
+ *
+ * @param scene the scene containing the bodies
+ * @param group1 the first group of bodies; the list is copied
+ * @param group2 the second group of bodies, or NULL to collide the bodies in
+ *   group1 with each other. The handler's body1 is always from group1, and
+ *   within group1 it is the body that comes first in the list.
+ * @param handler a function to call whenever two of the bodies collide
+ * @param aux an auxiliary value to pass to the handler
+ * @param force_const a constant to pass to the handler
+ * @return the collision, where the bodies of group1 followed by those of
+ *   group2 are slots 0, 1, 2, ...
+ */
+collision_t *create_group_collision(scene_t *scene, list_t *group1,
+                                    list_t *group2, collision_handler_t handler,
+                                    void *aux, double force_const);
+
+/**
+ * Forgets which pairs including the body in a slot of a collision were
+ * colliding, so its next contact calls the collision handler again.
+ * Takes time proportional to the number of bodies in the collision.
+ *
+ * @param collision the collision, from create_collision() or
+ *   create_group_collision()
+ * @param slot the body's slot in the collision
+ */
+void collision_reset(collision_t *collision, size_t slot);
+
+/**
+ * Forgets which pairs including a body were colliding, for every collision
+ * force creator in the scene. A body that is reused, e.g. taken out of a pool,
+ * should be reset so its first contact calls the collision handler again.
+ * This searches every force creator in the scene; a body that is reset often
+ * should keep the collisions it is in and use collision_reset() instead.
+ *
+ * @param scene the scene containing the body
+ * @param body the body to reset
  */
-void create_collision(scene_t *scene, body_t *body1, body_t *body2,
-                      collision_handler_t handler, void *aux,
-                      double force_const);
+void reset_collisions(scene_t *scene, body_t *body);
 
 /**
  * Adds a force creator to a scene that destroys two bodies when they collide.
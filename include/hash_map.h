@@ -0,0 +1,159 @@
+#ifndef __HASH_MAP_H__
+#define __HASH_MAP_H__
+
+#include "list.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A hash table from keys to values, both pointers. It uses open addressing
+ * with linear probing, so a lookup usually reads a single cache line, and it
+ * grows to keep at most half of its slots full.
+ *
+ * The map does not copy or free its keys: each key must stay valid for as
+ * long as it is in the map, e.g. by pointing into the value or by being
+ * interned (see string_pool_t).
+ */
+typedef struct hash_map hash_map_t;
+
+/**
+ * A function that hashes a key. Equal keys must have equal hashes.
+ */
+typedef uint64_t (*hash_func_t)(const void *key);
+
+/**
+ * A function that decides whether two keys are equal.
+ */
+typedef bool (*equal_func_t)(const void *key1, const void *key2);
+
+/**
+ * A function called on each entry of a map by hash_map_for_each().
+ * Takes in the key, the value and the auxiliary value.
+ */
+typedef void (*hash_map_visitor_t)(const void *key, void *value, void *aux);
+
+/**
+ * Hashes a NUL-terminated string (FNV-1a).
+ */
+uint64_t hash_string(const void *key);
+
+/**
+ * Compares two NUL-terminated strings.
+ */
+bool string_equal(const void *key1, const void *key2);
+
+/**
+ * Hashes a pointer by its address, e.g. for keys that are bodies or interned
+ * strings.
+ */
+uint64_t hash_pointer(const void *key);
+
+/**
+ * Compares two pointers by address.
+ */
+bool pointer_equal(const void *key1, const void *key2);
+
+/**
+ * Allocates memory for an empty hash map with room for the given number of
+ * entries before it grows.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_size the number of entries to allocate space for
+ * @param hash the function to hash keys with
+ * @param equal the function to compare keys with
+ * @param freer if non-NULL, a function to call on the values still in the map
+ *   in hash_map_free()
+ * @return a pointer to the newly allocated map
+ */
+hash_map_t *hash_map_init(size_t initial_size, hash_func_t hash,
+                          equal_func_t equal, free_func_t freer);
+
+/**
+ * Releases the memory allocated for a hash map.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ */
+void hash_map_free(hash_map_t *map);
+
+/**
+ * Gets the number of entries in a hash map.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ * @return the number of entries
+ */
+size_t hash_map_size(hash_map_t *map);
+
+/**
+ * Looks up the value for a key.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ * @param key the key to look for
+ * @return the value, or NULL if the key is not in the map
+ */
+void *hash_map_get(hash_map_t *map, const void *key);
+
+/**
+ * Sets the value for a key, adding the key if it is not in the map.
+ * Asserts that the value is non-NULL.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ * @param key the key, which must stay valid while it is in the map
+ * @param value the value
+ * @return the value the key had before, which is not freed, or NULL if the
+ *   key was not in the map
+ */
+void *hash_map_put(hash_map_t *map, const void *key, void *value);
+
+/**
+ * Removes a key from a hash map, without freeing its value.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ * @param key the key to remove
+ * @return the value the key had, or NULL if it was not in the map
+ */
+void *hash_map_remove(hash_map_t *map, const void *key);
+
+/**
+ * Calls a function on every entry of a hash map, in no particular order.
+ * The visitor must not add or remove entries.
+ *
+ * @param map a pointer to a map returned from hash_map_init()
+ * @param visit the function to call
+ * @param aux an auxiliary value to pass to visit
+ */
+void hash_map_for_each(hash_map_t *map, hash_map_visitor_t visit, void *aux);
+
+/**
+ * A set of interned strings. Interning a string returns the pool's own copy
+ * of it, which is the same pointer for every equal string, so interned
+ * strings can be compared and hashed by address and used as map keys that
+ * outlive the caller's buffer.
+ */
+typedef struct string_pool string_pool_t;
+
+/**
+ * Allocates an empty string pool.
+ * Asserts that the required memory was allocated.
+ *
+ * @return a pointer to the newly allocated pool
+ */
+string_pool_t *string_pool_init(void);
+
+/**
+ * Releases a string pool and every string interned in it.
+ *
+ * @param pool a pointer to a pool returned from string_pool_init()
+ */
+void string_pool_free(string_pool_t *pool);
+
+/**
+ * Interns a string.
+ *
+ * @param pool a pointer to a pool returned from string_pool_init()
+ * @param string a NUL-terminated string
+ * @return the pool's copy of the string, valid until the pool is freed
+ */
+const char *string_intern(string_pool_t *pool, const char *string);
+
+#endif // #ifndef __HASH_MAP_H__
@@ -2,6 +2,7 @@
 #define __LIST_H__
 
 #include "vector.h"
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -17,6 +18,12 @@ typedef struct list list_t;
  */
 typedef void (*free_func_t)(void *);
 
+/**
+ * A function that decides whether list_remove_if() should remove an element.
+ * Takes in the element and the auxiliary value passed to list_remove_if().
+ */
+typedef bool (*list_predicate_t)(void *element, void *aux);
+
 /**
  * Allocates memory for a new list with space for the given number of elements.
  * The list is initially empty.
@@ -65,6 +72,47 @@ void *list_get(list_t *list, size_t index);
  */
 void *list_remove(list_t *list, size_t index);
 
+/**
+ * Removes the element at a given index in a list and returns it in constant
+ * time, by moving the last element into its place. The order of the
+ * remaining elements is not kept.
+ * Asserts that the index is valid, given the list's current size.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index an index in the list (the first element is at 0)
+ * @return the element at the given index in the list
+ */
+void *list_swap_remove(list_t *list, size_t index);
+
+/**
+ * Removes every element of a list that a predicate accepts, in a single pass
+ * that keeps the order of the remaining elements. If the list has a freer, it
+ * is called on each removed element.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param predicate returns true for the elements to remove
+ * @param aux an auxiliary value to pass to the predicate
+ * @return the number of elements removed
+ */
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux);
+
+/**
+ * Grows a list's capacity, if needed, so it can hold at least the given
+ * number of elements without resizing again.
+ * Asserts that the resize succeeded.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param capacity the number of elements to make room for
+ */
+void list_reserve(list_t *list, size_t capacity);
+
+/**
+ * Shrinks a list's capacity to its size, releasing the unused memory.
+ *
+ * @param list a pointer to a list returned from list_init()
+ */
+void list_shrink(list_t *list);
+
 /**
  * Appends an element to the end of a list.
  * If the list is filled to capacity, resizes the list to fit more elements
@@ -0,0 +1,70 @@
+#ifndef __MINIMAP_H__
+#define __MINIMAP_H__
+
+#include "sdl_wrapper.h"
+#include "vector.h"
+
+/**
+ * A small map of the track drawn in a fixed part of the scene, with a marker
+ * for each racer. Like the rest of the scene, it is scaled to fit the window.
+ *
+ * The picture of the track is drawn into a texture of the minimap's size in
+ * the window once, when the minimap is made, and again only if the renderer
+ * loses the texture's contents. Each frame only draws that texture and one
+ * sprite per marker, so the cost of the minimap only grows with the number of
+ * racers.
+ */
+typedef struct minimap minimap_t;
+
+/**
+ * How a racer is marked on the minimap.
+ */
+typedef struct {
+  /** The image of the marker, or NULL to draw nothing */
+  texture_region_t *image;
+  /** The width and height the image is drawn at, in scene units */
+  vector_t size;
+} minimap_marker_t;
+
+/**
+ * Makes a minimap by drawing a picture of the track into a new texture.
+ * The full-size picture is freed once it has been drawn.
+ *
+ * @param sdl the context the minimap is drawn in
+ * @param image_path the picture of the whole track; the path is copied
+ * @param min the bottom left corner of the area the picture covers
+ * @param max the top right corner of the area the picture covers
+ * @param box_min the bottom left corner of the minimap in the scene
+ * @param box_max the top right corner of the minimap in the scene
+ * @return the new minimap
+ */
+minimap_t *minimap_init(sdl_context_t *sdl, const char *image_path,
+                        vector_t min, vector_t max, vector_t box_min,
+                        vector_t box_max);
+
+/**
+ * Frees a minimap and its texture.
+ *
+ * @param map a minimap returned by minimap_init()
+ */
+void minimap_free(minimap_t *map);
+
+/**
+ * Draws the picture of the track. Markers go on top of it, so this is drawn
+ * first in each frame.
+ */
+void minimap_draw(minimap_t *map);
+
+/**
+ * Draws a marker on the minimap.
+ *
+ * @param map the minimap
+ * @param marker the marker to draw
+ * @param offset where the racer is, relative to the center of the area the
+ *   picture covers
+ * @param rotation the angle to rotate the marker by, counterclockwise
+ */
+void minimap_draw_marker(minimap_t *map, minimap_marker_t marker,
+                         vector_t offset, double rotation);
+
+#endif // #ifndef __MINIMAP_H__
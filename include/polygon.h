@@ -1,14 +1,30 @@
 #ifndef __POLYGON_H__
 #define __POLYGON_H__
 
+#include "arena.h"
 #include "color.h"
 #include "list.h"
 #include "vector.h"
 
+/**
+ * A polygon. Its vertices are stored contiguously, inside the polygon itself
+ * when there are few enough of them (as for a rectangle).
+ */
 typedef struct polygon polygon_t;
 
+/**
+ * A read-only view of the vertices of a polygon, in order.
+ * It is invalidated when the polygon is freed, and its contents change when
+ * the polygon is moved.
+ */
+typedef struct vertex_span {
+  const vector_t *data;
+  size_t size;
+} vertex_span_t;
+
 /**
  * Initialize a polygon object given a list of vertices.
+ * The vertices are copied into the polygon and the list is freed.
  *
  * @param points the list of vertices that make up the polygon
  * @param initial_position a vector representing the initial center position of
@@ -27,12 +43,53 @@ polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
                         double blue);
 
 /**
- * Return the list of vectors representing the vertices of the polygon.
+ * Acts like polygon_init(), but allocates the polygon from an arena. The
+ * arena owns it: polygon_free() releases nothing, and the polygon goes away
+ * when the arena is reset or freed.
+ *
+ * @param arena the arena to allocate the polygon from
+ */
+polygon_t *polygon_init_in_arena(arena_t *arena, list_t *points,
+                                 vector_t initial_velocity,
+                                 double rotation_speed, double red,
+                                 double green, double blue);
+
+/**
+ * Initializes a polygon at rest from a copy of an array of vertices, without
+ * building a list of them first.
+ *
+ * @param arena the arena to allocate the polygon from, as in
+ *   polygon_init_in_arena(), or NULL to allocate it like polygon_init()
+ * @param vertices the vertices that make up the polygon
+ * @param color the color of the polygon
+ * @return a polygon object pointer
+ */
+polygon_t *polygon_init_span(arena_t *arena, vertex_span_t vertices,
+                             rgb_color_t color);
+
+/**
+ * Initializes a rectangle at rest, writing its corners straight into the
+ * polygon's inline storage. The corners are in the same order as those of
+ * make_rectangle().
+ *
+ * @param arena the arena to allocate the polygon from, as in
+ *   polygon_init_in_arena(), or NULL to allocate it like polygon_init()
+ * @param center the center of the rectangle
+ * @param w the width of the rectangle
+ * @param h the height of the rectangle
+ * @param color the color of the rectangle
+ * @return a polygon object pointer
+ */
+polygon_t *polygon_init_rect(arena_t *arena, vector_t center, double w,
+                             double h, rgb_color_t color);
+
+/**
+ * Return the vertices of the polygon.
  *
  * @param polygon the list of vertices that make up the polygon
- * @return a list of vectors
+ * @return a view of the vertices
  */
-list_t *polygon_get_points(polygon_t *polygon);
+vertex_span_t polygon_get_vertices(polygon_t *polygon);
 
 /**
  * Translate and rotate the polygon then update velocity based on gravity.
@@ -84,6 +141,15 @@ void polygon_translate(polygon_t *polygon, vector_t translation);
  */
 void polygon_rotate(polygon_t *polygon, double angle, vector_t point);
 
+/**
+ * Computes the axis-aligned bounding box of a polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param min where to store the bottom left corner of the box
+ * @param max where to store the top right corner of the box
+ */
+void polygon_get_bounds(polygon_t *polygon, vector_t *min, vector_t *max);
+
 /**
  * Return the polygon's color.
  *
@@ -96,7 +162,8 @@ rgb_color_t *polygon_get_color(polygon_t *polygon);
  * Changes the color of the polygon.
  *
  * @param polygon a polygon_t struct
- * @param color a struct containing rgb values of the new color
+ * @param color a struct containing rgb values of the new color, which are
+ *   copied
  */
 void polygon_set_color(polygon_t *polygon, rgb_color_t *color);
 
@@ -150,6 +217,7 @@ vector_t *polygon_get_velocity(polygon_t *polygon);
 
 /**
  * Free memory allocated for object associated with a polygon.
+ * A polygon from polygon_init_in_arena() is left to its arena.
  *
  * @param polygon the list of vertices that make up the polygon
  */
@@ -4,6 +4,8 @@
 #include "asset.h"
 #include "body.h"
 #include "list.h"
+#include "scene.h"
+#include "slot_map.h"
 
 typedef enum {
   NONE,
@@ -15,15 +17,6 @@ typedef enum {
   FAKE
 } power_up_type_t;
 
-typedef struct shell_item_info shell_item_info_t;
-
-/**
- * Frees the info of a shell body
- *
- * @param info the information to free
- */
-void shell_info_free(shell_item_info_t *info);
-
 typedef struct box_item_info box_item_info_t;
 
 /**
@@ -36,53 +29,158 @@ void box_info_free(box_item_info_t *info);
 /**
  * Makes an asset to display the player's item.
  *
+ * @param cache the cache to load the image through
  * @param power the player's item
  * @return the asset
  */
-asset_t *item_asset(power_up_type_t power);
+asset_t *item_asset(asset_cache_t *cache, power_up_type_t power);
 
 /**
  * Makes a box asset with the given center.
  *
+ * @param cache the cache to load the image through
+ * @param arena the arena to allocate the box's body from (see
+ *   body_init_in_arena())
  * @param center the center for the box
  * @return the box asset
  */
-asset_t *make_box(vector_t center);
+asset_t *make_box(asset_cache_t *cache, arena_t *arena, vector_t center);
 
 /**
- * Updates the information of a box, and returns whether or not it should be
- * rendered
+ * Returns whether a box can be picked up, and so should be rendered. A box
+ * is hidden from when it is picked up until a scene timer respawns it.
+ *
  * @param box the box
- * @param dt the time ellapsed
  * @returns whether it should be rendered
  */
-bool update_box(asset_t *box, double dt);
+bool box_is_ready(asset_t *box);
 
 /**
- * Makes a shell asset with the given center and angular velocity.
+ * A fixed number of item bodies of one kind (shells, fake boxes or boost
+ * pads) and their assets, created with the race and recycled for its whole
+ * length, so using items allocates nothing.
+ *
+ * Every body stays in the scene. An unused one is parked: it is kinematic, so
+ * it is skipped by collisions and the AI, and it is not rendered. Since the
+ * bodies never change, each pool's collisions are registered once, with a
+ * group collision against every car.
  *
- * @param center the center for the shell
- * @param theta the angular position
+ * The items in use are kept in a slot map, so they can be iterated over
+ * without visiting the parked ones, and so a handle to an item stops
+ * resolving once it is released, even after its body is reused.
+ */
+typedef struct item_pool item_pool_t;
+
+/**
+ * Creates a pool of parked items and adds their bodies to a scene. The
+ * bodies are allocated from the scene's arena.
+ *
+ * @param scene the scene of the race
+ * @param cache the cache to load the images through
+ * @param type SHELL, FAKE (fake item boxes) or BOOST (boost pads)
+ * @param capacity the most items of the kind that can be out at once
+ * @return the pool
+ */
+item_pool_t *item_pool_init(scene_t *scene, asset_cache_t *cache,
+                            power_up_type_t type, size_t capacity);
+
+/**
+ * Removes a pool's bodies from the scene and destroys its assets.
+ *
+ * @param pool the pool
+ */
+void item_pool_free(item_pool_t *pool);
+
+/**
+ * Renders the items of a pool that are in use.
+ *
+ * @param pool the pool
+ */
+void item_pool_render(item_pool_t *pool);
+
+/**
+ * Looks up an item in use by its handle.
+ *
+ * @param pool the pool
+ * @param item a handle returned when the item was spawned
+ * @return the body of the item, or NULL if it has been released since
+ */
+body_t *item_pool_get(item_pool_t *pool, handle_t item);
+
+/**
+ * Returns whether an item from a pool is in use.
+ *
+ * @param item the body of the item
+ */
+bool item_is_active(body_t *item);
+
+/**
+ * Parks an item, returning it to its pool, and resets its collisions so it
+ * hits things afresh once reused. Does nothing if it is already parked.
+ *
+ * @param item the body of the item
+ */
+void item_release(body_t *item);
+
+/**
+ * Takes a shell from a pool and starts it circling a car.
+ * If every shell is in use, the oldest one is recycled.
+ *
+ * @param pool a pool of shells
+ * @param owner the car to circle
+ * @param theta the angular position around the car
  * @param ang_vel the angular velocity
- * @return the shell asset
+ * @return the handle of the shell, to store in the car's power up state
+ */
+handle_t spawn_shell(item_pool_t *pool, body_t *owner, double theta,
+                     double ang_vel);
+
+/**
+ * Releases a shell from the car it circles, so it flies off with its current
+ * velocity, bounces off the walls and can hit any car.
+ *
+ * @param shell the shell
  */
-asset_t *make_shell(vector_t center, double theta, double ang_vel);
+void fire_shell(body_t *shell);
 
 /**
- * Makes a boost asset with the car's center and direction.
+ * Takes a fake item box from a pool and places it.
+ * If every box is in use, the oldest one is recycled.
  *
+ * @param pool a pool of fake boxes
+ * @param center the center for the box
+ * @return the body of the box
+ */
+body_t *spawn_fake_box(item_pool_t *pool, vector_t center);
+
+/**
+ * Takes a boost pad from a pool and lays it under a car, facing the same way.
+ * If every pad is in use, the oldest one is recycled.
+ *
+ * @param pool a pool of boost pads
  * @param car the car placing the boost
- * @return the boost asset
+ * @return the body of the boost pad
  */
-asset_t *make_boost(body_t *car);
+body_t *spawn_boost(item_pool_t *pool, body_t *car);
 
 /**
- * Checks if the car has a shell currently rotating around it
+ * Gets the shell currently rotating around the car, if any
+ * (the shell in its power up state is still in use and circling it).
  *
+ * @param shells the pool the car's shell was taken from
+ * @param car the car
+ * @return the body of the shell, or NULL if it has none
+ */
+body_t *car_get_shell(item_pool_t *shells, body_t *car);
+
+/**
+ * Checks if the car has a shell currently rotating around it.
+ *
+ * @param shells the pool the car's shell was taken from
  * @param car the car
  * @return true if it has a shell, false if it does not
  */
-bool car_has_shell(body_t *car);
+bool car_has_shell(item_pool_t *shells, body_t *car);
 
 /**
  * Returns the speed multiplier from mushrooms and boost pads
@@ -94,10 +192,11 @@ double get_speed_multiplier();
 /**
  * Updates the position of the shell rotating around the car, if any.
  *
+ * @param shells the pool the car's shell was taken from
  * @param car the car
  * @param dt time elapsed
  */
-void update_shell(body_t *car, double dt);
+void update_shell(item_pool_t *shells, body_t *car, double dt);
 
 /**
  * Flips the angular velocity of the shell
@@ -107,7 +206,18 @@ void update_shell(body_t *car, double dt);
 void flip_shell(body_t *shell);
 
 /**
- * Collision handler for the boxes. Gives the car (body1) an item.
+ * What the item boxes can give out: the power ups selected by the user, and
+ * the scene whose generator the item is drawn with and whose timers respawn
+ * the boxes.
+ */
+typedef struct box_rules {
+  bool *switches;
+  scene_t *scene;
+} box_rules_t;
+
+/**
+ * Collision handler for the boxes. Gives the car (body1) an item drawn with
+ * the box_rules_t passed as aux, and hides the box (body2) until it respawns.
  */
 void box_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                            void *aux, double force_const);
@@ -119,14 +229,26 @@ void box_collision_handler(body_t *body1, body_t *body2, vector_t axis,
  * @param scene the scene containing the bodies
  * @param body1 the first body, corresponding to the car
  * @param body2 the second body, corresponding to the power up box
- * @param switches the power ups selected by the user to include in the game
+ * @param rules the items to draw from; must outlive the force creator
  */
 void create_box_collision(scene_t *scene, body_t *body1, body_t *body2,
-                          bool *switches);
+                          box_rules_t *rules);
+
+/**
+ * Like create_box_collision(), but for every car against every box, using a
+ * single group collision.
+ *
+ * @param scene the scene containing the bodies
+ * @param cars the cars that can pick up items
+ * @param boxes the bodies of the power up boxes
+ * @param rules the items to draw from; must outlive the force creator
+ */
+void create_box_collisions(scene_t *scene, list_t *cars, list_t *boxes,
+                           box_rules_t *rules);
 
 /**
  * Collision handler for stun. Updates the stun attribute of the first body
- * (the car).
+ * (the car). The aux value is the scene, for its time.
  */
 void stun_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                             void *aux, double force_const);
@@ -138,14 +260,27 @@ void stun_collision_handler(body_t *body1, body_t *body2, vector_t axis,
  * @param scene the scene containing the bodies
  * @param body1 the first body; the body to be stunned
  * @param body2 the second body
- * @param remove a double indicating if the second body is a car (under 0),
- * shell (between 0 and 2), or a box (over 2)
+ * @param remove positive if the second body is an item to release when it
+ *   stuns a car, and negative if it is a car
  */
 void create_stun_collision(scene_t *scene, body_t *body1, body_t *body2,
                            double remove);
 
+/**
+ * Like create_stun_collision(), but for every car in a list against one body,
+ * using a single group collision.
+ *
+ * @param scene the scene containing the bodies
+ * @param cars the cars that can be stunned
+ * @param body the body that stuns them
+ * @param remove as for create_stun_collision()
+ */
+void create_stun_collisions(scene_t *scene, list_t *cars, body_t *body,
+                            double remove);
+
 /**
  * Collision handler for the boost panes. Gives the car (body1) a speed boost.
+ * The aux value is the scene, for its time.
  */
 void boost_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                              void *aux, double force_const);
@@ -161,7 +296,8 @@ void boost_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 void create_boost_collision(scene_t *scene, body_t *body1, body_t *body2);
 
 /**
- * Collision handler for the boost panes. Gives the car (body1) a speed boost.
+ * Collision handler for two cars. Stuns the second car if the first is
+ * immune, and otherwise bounces them. The aux value is the scene, for its time.
  */
 void car_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                            void *aux, double force_const);
@@ -179,29 +315,64 @@ void car_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 void create_car_collision(scene_t *scene, body_t *body1, body_t *body2);
 
 /**
- * Collision handler for the collision between two shells. Removes both bodies
- * and sets the body of their assets to NULL, to indicate they should no longer
- * be rendered.
+ * Like create_car_collision(), but for every pair of cars in a list, using a
+ * single group collision. The player's car should be first in the list, since
+ * only the first car of a pair can stun the other with a star.
+ *
+ * @param scene the scene containing the bodies
+ * @param cars the cars in the race
+ */
+void create_car_collisions(scene_t *scene, list_t *cars);
+
+/**
+ * Collision handler for the collision between two shells. Releases both.
  */
 void shell_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                              void *aux, double force_const);
 
 /**
- * Adds a force creator to a scene that resolves the collision between two
- * shells.
+ * Registers every collision of a pool of shells: shells stun the cars they
+ * hit (except the car a shell is circling), destroy each other, and bounce
+ * off the walls once fired.
  *
  * @param scene the scene containing the bodies
- * @param body1 the first body
- * @param body2 the second body
+ * @param shells a pool of shells
+ * @param cars the cars in the race
+ * @param walls the track walls
+ * @param elasticity the elasticity of the bounce off the walls
+ */
+void create_shell_collisions(scene_t *scene, item_pool_t *shells,
+                             list_t *cars, body_t *walls, double elasticity);
+
+/**
+ * Registers the collisions of a pool of fake item boxes, which stun the cars
+ * that hit them.
+ *
+ * @param scene the scene containing the bodies
+ * @param boxes a pool of fake boxes
+ * @param cars the cars in the race
+ */
+void create_fake_box_collisions(scene_t *scene, item_pool_t *boxes,
+                                list_t *cars);
+
+/**
+ * Registers the collisions of a pool of boost pads, which give a car driving
+ * over them a speed boost.
+ *
+ * @param scene the scene containing the bodies
+ * @param boosts a pool of boost pads
+ * @param cars the cars that can use the pads
  */
-void create_shell_collision(scene_t *scene, body_t *body1, body_t *body2);
+void create_boost_collisions(scene_t *scene, item_pool_t *boosts,
+                             list_t *cars);
 
 /**
  * Permutes the elements of an array
  *
+ * @param rng the generator to shuffle with
  * @param elements the array of elements
  * @param size the size of the array
  */
-void permute(size_t *elements, size_t size);
+void permute(rng_t *rng, size_t *elements, size_t size);
 
 #endif // #ifndef __POWER_UP_H__
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A small, fast pseudo-random number generator (xoshiro256**).
+ *
+ * Unlike rand(), each generator has its own state, so every simulation can
+ * own one and produce the same sequence on every machine and libc for a given
+ * seed. Generators are plain values; copying one forks the sequence.
+ */
+typedef struct rng {
+  uint64_t state[4];
+} rng_t;
+
+/**
+ * Returns a generator seeded from a single 64-bit value.
+ * Equal seeds always give equal sequences.
+ *
+ * @param seed any value, including 0
+ * @return the seeded generator
+ */
+rng_t rng_init(uint64_t seed);
+
+/**
+ * Returns the next 64 uniformly distributed random bits.
+ */
+uint64_t rng_next(rng_t *rng);
+
+/**
+ * Returns a uniformly distributed double in [0, 1).
+ */
+double rng_double(rng_t *rng);
+
+/**
+ * Returns a uniformly distributed integer in [0, bound), without the bias of
+ * taking the remainder of a random number. Asserts that bound is positive.
+ */
+size_t rng_below(rng_t *rng, size_t bound);
+
+#endif // #ifndef __RNG_H__
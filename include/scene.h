@@ -1,8 +1,10 @@
 #ifndef __SCENE_H__
 #define __SCENE_H__
 
+#include "arena.h"
 #include "body.h"
 #include "list.h"
+#include "rng.h"
 
 /**
  * A collection of bodies and force creators.
@@ -11,6 +13,32 @@
  */
 typedef struct scene scene_t;
 
+/**
+ * A grouping of a force creator and its auxillary info.
+ * See forces.h for its accessors.
+ */
+typedef struct force_info force_info_t;
+
+/**
+ * A function that decides which bodies a scene query should consider.
+ * Takes in the body and the auxiliary value passed to the query.
+ */
+typedef bool (*body_filter_t)(body_t *body, void *aux);
+
+/**
+ * The result of a raycast or shape cast.
+ */
+typedef struct {
+  /** The first body hit, or NULL if nothing was hit */
+  body_t *body;
+  /** How far along the cast the body was hit */
+  double distance;
+  /** Where the cast hit the body (the center of the cast shape, if any) */
+  vector_t point;
+  /** The unit normal of the body's surface at the hit */
+  vector_t normal;
+} scene_hit_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -18,8 +46,16 @@ typedef struct scene scene_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function to run when a timer expires.
+ * Takes in the auxiliary value the timer was added with.
+ */
+typedef void (*timer_callback_t)(void *aux);
+
 /**
  * Allocates memory for an empty scene.
+ * The scene's random number generator starts from a fixed seed; see
+ * scene_seed().
  * Makes a reasonable guess of the number of bodies to allocate space for.
  * Asserts that the required memory is successfully allocated.
  *
@@ -35,6 +71,31 @@ scene_t *scene_init(void);
  */
 void scene_free(scene_t *scene);
 
+/**
+ * Empties a scene so it can be reused, e.g. for the next race: frees all of
+ * its bodies, force creators and timers at once, without the per-body
+ * bookkeeping of removing them, and resets its time to 0 and its arena.
+ * Bodies allocated from the arena (see body_init_in_arena()) are released
+ * with it, so only their infos are freed one by one; any other body is freed
+ * on its own.
+ * The random number generator is left as it is.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_clear(scene_t *scene);
+
+/**
+ * Gets the scene's arena, for memory that should live as long as the bodies
+ * and force creators currently in the scene. Everything allocated from it is
+ * released together by scene_clear() or scene_free(), so it suits data that
+ * is built once per race, such as the race's bodies (see
+ * body_init_in_arena()) and the state of force creators.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the arena
+ */
+arena_t *scene_get_arena(scene_t *scene);
+
 /**
  * Gets the number of bodies in a given scene.
  *
@@ -43,6 +104,25 @@ void scene_free(scene_t *scene);
  */
 size_t scene_bodies(scene_t *scene);
 
+/**
+ * Reseeds the scene's random number generator.
+ * Two scenes built the same way and seeded with the same value play out
+ * identically.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param seed the seed passed to rng_init()
+ */
+void scene_seed(scene_t *scene, uint64_t seed);
+
+/**
+ * Returns the scene's random number generator, which everything random in the
+ * simulation (e.g. item boxes) should draw from instead of rand().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the generator, valid until scene_free()
+ */
+rng_t *scene_get_rng(scene_t *scene);
+
 /**
  * Gets the body at a given index in a scene.
  * Asserts that the index is valid.
@@ -53,6 +133,24 @@ size_t scene_bodies(scene_t *scene);
  */
 body_t *scene_get_body(scene_t *scene, size_t index);
 
+/**
+ * Gets the number of force creators in a given scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the number of force creators added and not yet removed
+ */
+size_t scene_force_creators(scene_t *scene);
+
+/**
+ * Gets the force creator at a given index in a scene.
+ * Asserts that the index is valid.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param index the index of the force creator in the scene (starting at 0)
+ * @return the force creator's info, valid until it is removed
+ */
+force_info_t *scene_get_force_creator(scene_t *scene, size_t index);
+
 /**
  * Adds a body to a scene.
  *
@@ -95,18 +193,78 @@ void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux);
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies);
 
+/**
+ * Like scene_add_bodies_force_creator(), but with a custom function to free
+ * the auxiliary value when the force creator is removed, e.g. for one
+ * allocated from the scene's arena.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param forcer a force creator function
+ * @param aux an auxiliary value to pass to forcer when it is called
+ * @param bodies the list of bodies affected by the force creator
+ * @param freer if non-NULL, a function to call on aux when the force creator
+ *   is removed
+ */
+void scene_add_bodies_force_creator_with_freer(scene_t *scene,
+                                               force_creator_t forcer,
+                                               void *aux, list_t *bodies,
+                                               free_func_t freer);
+
+/**
+ * Returns the total time the scene has been ticked for.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the sum of the dt passed to scene_tick()
+ */
+double scene_get_time(scene_t *scene);
+
+/**
+ * Schedules a callback to run once, during the scene_tick() that brings the
+ * scene's time at least `delay` past its current time.
+ * Timers expiring in the same tick run in order of expiry, and timers that
+ * expire together run in the order they were added. Pending timers are kept
+ * in a min-heap, so a tick only costs time for the timers that expire in it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param delay how long from now to run the callback; must not be negative
+ * @param body the body the timer belongs to, or NULL. Like a force creator,
+ *   the timer is dropped without running if the body is removed first.
+ * @param callback the function to run
+ * @param aux an auxiliary value to pass to the callback
+ */
+void scene_add_timer(scene_t *scene, double delay, body_t *body,
+                     timer_callback_t callback, void *aux);
+
 /**
  * Executes a tick of a given scene over a small time interval.
  * This requires executing all the force creators
  * and then ticking each body (see body_tick()).
  * If any bodies are marked for removal, they should be removed from the scene
- * and freed, along with any force creators acting on them.
+ * and freed, along with any force creators and timers acting on them.
+ * Finally, the scene's time advances by dt and the timers that have expired
+ * run.
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Ticks a scene over dt in as many equal steps as it takes for no body to move
+ * further than max_distance in one of them, judging by the speeds of the
+ * bodies that aren't kinematic at the start. Thin colliders such as track
+ * walls catch fast bodies this way even when a frame takes long, instead of
+ * being passed over between ticks. The number of steps is capped, so a very
+ * long frame may still move bodies further than max_distance in a step.
+ * Each step runs the force creators and moves the bodies; the removed bodies
+ * are freed, the time advances and the timers run once, at the end.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param dt the time elapsed since the last tick, in seconds
+ * @param max_distance how far a body may move in one step; must be positive
+ */
+void scene_tick_bounded(scene_t *scene, double dt, double max_distance);
+
 /**
  * Shifts all the bodies in a given scene to fix the centroid of a given body
  * to be a given vector.
@@ -117,4 +275,54 @@ void scene_tick(scene_t *scene, double dt);
  */
 void scene_center_body(scene_t *scene, body_t *body, vector_t center);
 
+/**
+ * Finds the first body hit by a ray.
+ * Bodies whose bounds the ray doesn't cross are skipped using the scene's
+ * spatial index, which is rebuilt the first time the scene is queried after
+ * scene_tick() or scene_center_body(). Rays starting inside a polygon don't
+ * hit it.
+ *
+ * @param scene the scene to query
+ * @param origin where the ray starts
+ * @param direction the direction of the ray; need not be a unit vector
+ * @param max_distance how far the ray reaches
+ * @param filter if non-NULL, only bodies it returns true for can be hit
+ * @param aux an auxiliary value to pass to the filter
+ * @return the closest hit; its body is NULL if nothing was hit
+ */
+scene_hit_t scene_raycast(scene_t *scene, vector_t origin, vector_t direction,
+                          double max_distance, body_filter_t filter,
+                          void *aux);
+
+/**
+ * Finds the first body hit by a circle swept along a ray.
+ * Acts like scene_raycast() with bodies grown by the radius of the circle.
+ *
+ * @param scene the scene to query
+ * @param origin where the center of the circle starts
+ * @param radius the radius of the circle
+ * @param direction the direction to sweep the circle in
+ * @param max_distance how far to sweep the circle
+ * @param filter if non-NULL, only bodies it returns true for can be hit
+ * @param aux an auxiliary value to pass to the filter
+ * @return the closest hit; its body is NULL if nothing was hit
+ */
+scene_hit_t scene_shape_cast(scene_t *scene, vector_t origin, double radius,
+                             vector_t direction, double max_distance,
+                             body_filter_t filter, void *aux);
+
+/**
+ * Finds every body colliding with a shape, according to find_collision().
+ * The shape doesn't need to be in the scene, and is never reported itself.
+ *
+ * @param scene the scene to query
+ * @param shape a body with the shape to test
+ * @param filter if non-NULL, only bodies it returns true for are reported
+ * @param aux an auxiliary value to pass to the filter
+ * @param results a list to add the colliding bodies to
+ * @return the number of bodies added to results
+ */
+size_t scene_overlap(scene_t *scene, body_t *shape, body_filter_t filter,
+                     void *aux, list_t *results);
+
 #endif // #ifndef __SCENE_H__
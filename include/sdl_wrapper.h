@@ -5,7 +5,6 @@
 #include "list.h"
 #include "polygon.h"
 #include "scene.h"
-#include "state.h"
 #include "vector.h"
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
@@ -58,72 +57,264 @@ typedef enum { MOUSE_CLICKED } mouse_event_type_t;
  */
 typedef void (*mouse_handler_t)(void *state, double x, double y);
 
+/**
+ * A window together with its renderer, the mapping from scene coordinates to
+ * pixels, the input handlers and the frame clock.
+ * Every SDL function below takes the context it acts on, so nothing in the
+ * wrapper is global.
+ */
+typedef struct sdl_context sdl_context_t;
+
 /**
  * Initializes the SDL window and renderer.
- * Must be called once before any of the other SDL functions.
+ * Must be called before any of the other SDL functions.
+ *
+ * The drawing functions record each frame into a list of renderer calls,
+ * which sdl_show() then makes in order.
  *
  * @param min the x and y coordinates of the bottom left of the scene
  * @param max the x and y coordinates of the top right of the scene
+ * @return the context of the new window
  */
-void sdl_init(vector_t min, vector_t max);
+sdl_context_t *sdl_init(vector_t min, vector_t max);
+
+/**
+ * Destroys the window and renderer of a context and frees it.
+ *
+ * @param sdl a context returned from sdl_init()
+ */
+void sdl_free(sdl_context_t *sdl);
 
 /**
  * Processes all SDL events and returns whether the window has been closed.
  * This function must be called in order to handle keypresses.
  *
+ * @param sdl the context to process the events of
+ * @param state the state passed to the key and click handlers
  * @return true if the window was closed, false otherwise
  */
-bool sdl_is_done(void *state);
+bool sdl_is_done(sdl_context_t *sdl, void *state);
 
 /**
  * Clears the screen. Should be called before drawing polygons in each frame.
  */
-void sdl_clear(void);
+void sdl_clear(sdl_context_t *sdl);
 
 /**
  * Draws a polygon from the given list of vertices and a color.
  *
+ * @param sdl the context to draw in
  * @param poly a struct representing the polygon
  * @param color the color used to fill in the polygon
  */
-void sdl_draw_polygon(polygon_t *poly, rgb_color_t color);
+void sdl_draw_polygon(sdl_context_t *sdl, polygon_t *poly, rgb_color_t color);
 
 /**
  * Displays the rendered frame on the SDL window.
  * Must be called after drawing the polygons in order to show them.
+ * On native builds this only waits for the previous frame to be presented,
+ * not this one.
+ */
+void sdl_show(sdl_context_t *sdl);
+
+/**
+ * A rectangle of a texture that is drawn as one image, e.g. an image packed
+ * into an atlas texture by sdl_pack_images().
  */
-void sdl_show(void);
+typedef struct {
+  /** The texture, or NULL if the image couldn't be loaded */
+  SDL_Texture *texture;
+  /** The pixels of the image in the texture */
+  SDL_Rect source;
+} texture_region_t;
 
 /**
  * Loads the image found in the given file location as an SDL_Texture.
  *
+ * @param sdl the context whose renderer the texture is for
  * @param path the file path to the image
  * @return the loaded image
  */
-SDL_Texture *sdl_load_image(const char *path);
+SDL_Texture *sdl_load_image(sdl_context_t *sdl, const char *path);
+
+/**
+ * Gets the size of a texture made by one of the functions in this file,
+ * without a round trip to the renderer.
+ *
+ * @param sdl the context whose renderer the texture is for
+ * @param texture the texture, which must not have been destroyed
+ * @return the width and height of the texture in pixels
+ */
+vector_t sdl_get_texture_size(sdl_context_t *sdl, SDL_Texture *texture);
+
+/**
+ * Destroys a texture made by one of the functions in this file, once the
+ * frames already drawn with it have been presented.
+ *
+ * @param sdl the context whose renderer the texture is for
+ * @param texture the texture to destroy
+ */
+void sdl_destroy_texture(sdl_context_t *sdl, SDL_Texture *texture);
+
+/**
+ * Loads images and packs them into as few atlas textures as possible, so
+ * that sprites drawn from them can share a batch (see sdl_draw_sprite()).
+ * Images that are missing or too large to pack are left out, with a NULL
+ * texture in their region.
+ *
+ * @param sdl the context whose renderer the textures are for
+ * @param paths the file paths to the images
+ * @param count the number of images
+ * @param regions where to store the region of each image, in order
+ * @param pages a list to add the atlas textures to; the caller must destroy
+ *   them after the regions are no longer drawn
+ */
+void sdl_pack_images(sdl_context_t *sdl, const char *const *paths,
+                     size_t count, texture_region_t *regions, list_t *pages);
+
+/**
+ * Counters for the sprites drawn in one frame, for profiling.
+ */
+typedef struct {
+  /** The number of sprites drawn */
+  size_t sprites;
+  /** The number of sprites skipped because they were entirely off screen */
+  size_t culled;
+  /**
+   * The number of SDL_RenderGeometry() calls the sprites were drawn with,
+   * together with the text drawn by sdl_draw_text()
+   */
+  size_t draw_calls;
+  /** The number of vertices sent to the renderer */
+  size_t vertices;
+} sprite_stats_t;
+
+/**
+ * Queues a textured quad to be drawn. Consecutive sprites from the same
+ * texture are sent to the renderer together, when a sprite from another
+ * texture or anything other than a sprite is drawn, or the frame is shown.
+ * Sprites entirely outside of the window are skipped.
+ *
+ * @param sdl the context to draw in
+ * @param texture the texture to draw from
+ * @param source the part of the texture to draw, or NULL for all of it
+ * @param destination where to draw the sprite in the window, before rotating
+ * @param theta the angle to rotate the sprite by about its center,
+ *   counterclockwise on the screen
+ */
+void sdl_draw_sprite(sdl_context_t *sdl, SDL_Texture *texture,
+                     const SDL_Rect *source, SDL_Rect destination,
+                     double theta);
+
+/**
+ * Records any queued sprites into the frame. The functions in this file flush
+ * the sprites themselves whenever the order of drawing requires it.
+ *
+ * @param sdl the context to draw in
+ */
+void sdl_flush_sprites(sdl_context_t *sdl);
+
+/**
+ * Returns the sprite counters of the last frame shown with sdl_show().
+ */
+sprite_stats_t sdl_get_sprite_stats(sdl_context_t *sdl);
+
+/**
+ * Makes a new transparent texture and draws into it instead of the window,
+ * until sdl_finish_render_target(). Sprites are drawn at pixel coordinates of
+ * the texture. Used to draw things that don't change once, then draw the
+ * texture each frame.
+ *
+ * @param sdl the context to draw with
+ * @param width the width of the texture in pixels
+ * @param height the height of the texture in pixels
+ * @return the texture, to free with sdl_destroy_texture()
+ */
+SDL_Texture *sdl_start_render_target(sdl_context_t *sdl, int width,
+                                     int height);
+
+/**
+ * Goes back to drawing in the window after sdl_start_render_target().
+ *
+ * @param sdl the context to draw with
+ */
+void sdl_finish_render_target(sdl_context_t *sdl);
+
+/**
+ * Gets a count of the times the renderer has lost the contents of the
+ * textures made by sdl_start_render_target() (SDL_RENDER_TARGETS_RESET),
+ * e.g. when a Direct3D window is resized. Whatever was drawn into them must be
+ * drawn again once the count changes.
+ *
+ * @param sdl the context to draw with
+ * @return the number of resets so far
+ */
+size_t sdl_get_target_resets(sdl_context_t *sdl);
 
 /**
  * Displays the image, centering it and scaling it to fill the screen.
+ * The image is drawn as a sprite.
+ * @param sdl the context to draw in
  * @param img the image to display
  * @param loc the upper coordinates value of the image
  * @param size the size of the image
  */
-void sdl_display_image(SDL_Texture *img, vector_t loc, vector_t size);
+void sdl_display_image(sdl_context_t *sdl, SDL_Texture *img, vector_t loc,
+                       vector_t size);
 
 /**
  * Displays the image, centering it and scaling it to fill the screen.
+ * @param sdl the context to draw in
  * @param img the image to display
  * @param bounding_box the image bounding box
  * @param theta the angle of the image
  * @param centroid the image centroid
  */
-void sdl_display_image_with_angle(SDL_Texture *img, SDL_Rect bounding_box,
-                                  double theta, vector_t centroid);
+void sdl_display_image_with_angle(sdl_context_t *sdl, SDL_Texture *img,
+                                  SDL_Rect bounding_box, double theta,
+                                  vector_t centroid);
 
 /**
- * Displays the rendered frame on the SDL window.
- * Must be called after drawing the polygons in order to show them.
+ * An image too large to keep in one texture, like a track background. It is
+ * split into square tiles, and only the tiles near the part of the image that
+ * is on screen are kept as textures; the rest stay in memory as pixels.
  */
+typedef struct tiled_image tiled_image_t;
+
+/**
+ * Loads an image to be drawn in tiles. No tile is uploaded until it is drawn.
+ *
+ * @param sdl the context the image is drawn in
+ * @param path the file path to the image
+ * @return the loaded image
+ */
+tiled_image_t *sdl_load_tiled_image(sdl_context_t *sdl, const char *path);
+
+/**
+ * Frees a tiled image and all of its resident tiles.
+ *
+ * @param image an image returned by sdl_load_tiled_image()
+ */
+void sdl_free_tiled_image(tiled_image_t *image);
+
+/**
+ * Draws the tiles of an image that are on screen, uploading any that aren't
+ * resident. Tiles the view will reach soon, judging by how the image moved
+ * since the last draw, are uploaded ahead of time, a few per frame. Once
+ * more tiles are resident than a fixed budget, the least recently used tiles
+ * not needed this frame are freed.
+ *
+ * @param sdl the context to draw in
+ * @param image the image to draw
+ * @param destination where the whole image would be drawn in the window
+ */
+void sdl_draw_tiled_image(sdl_context_t *sdl, tiled_image_t *image,
+                          SDL_Rect destination);
+
+/**
+ * Returns the number of tiles of an image that currently have a texture.
+ */
+size_t sdl_tiled_image_resident(tiled_image_t *image);
 
 /**
  * Loads the font found in the given file location as an TTF_Font
@@ -134,24 +325,94 @@ void sdl_display_image_with_angle(SDL_Texture *img, SDL_Rect bounding_box,
 TTF_Font *sdl_load_font(const char *path, size_t size);
 
 /**
- * Displays the message, in a rectangular box
+ * The glyphs of a font at one size, rendered into a single texture.
+ * Drawing text with an atlas copies glyphs out of the texture, so it does not
+ * rasterize or allocate anything. Only printable ASCII characters are in the
+ * atlas; any other character is drawn as '?'.
+ */
+typedef struct glyph_atlas glyph_atlas_t;
+
+/**
+ * Loads a font and renders its glyphs into an atlas for the renderer of a
+ * context. The atlas keeps the font open for sdl_draw_cached_text().
  *
- * @param font the font to display message in
- * @param message the message to be displayed
- * @param loc the upper coordinates value of the message
+ * @param sdl the context the atlas is drawn in
+ * @param path the file path to the font
+ * @param size the point size to render the glyphs at
+ * @return the new atlas
+ */
+glyph_atlas_t *sdl_load_glyph_atlas(sdl_context_t *sdl, const char *path,
+                                    size_t size);
+
+/**
+ * Frees a glyph atlas, its texture and font, and any cached text drawn with
+ * it.
+ *
+ * @param atlas an atlas returned by sdl_load_glyph_atlas()
+ */
+void sdl_free_glyph_atlas(glyph_atlas_t *atlas);
+
+/**
+ * Draws a line of text, as one textured quad per glyph submitted to the
+ * renderer in batches.
+ *
+ * @param sdl the context to draw in
+ * @param atlas the glyphs of the font to draw the text in
+ * @param text the text to draw
+ * @param loc the window position of the top left corner of the text
  * @param color the color used for the text
  */
-void sdl_display_message(TTF_Font *font, const char *message, vector_t loc,
-                         SDL_Color color);
+void sdl_draw_text(sdl_context_t *sdl, glyph_atlas_t *atlas, const char *text,
+                   vector_t loc, SDL_Color color);
+
+/**
+ * Counters for the text cache of a context (see sdl_draw_cached_text()).
+ * The hit rate is hits / (hits + misses).
+ */
+typedef struct {
+  /** The number of draws that reused a cached texture */
+  size_t hits;
+  /** The number of draws that had to render their text */
+  size_t misses;
+  /** The number of textures freed to stay within the byte budget */
+  size_t evictions;
+  /** The number of textures currently cached */
+  size_t entries;
+  /** The texture memory the cached textures use */
+  size_t bytes;
+} text_cache_stats_t;
+
+/**
+ * Draws a line of text that is the same from frame to frame, e.g. a label.
+ * The whole string is rendered to a texture the first time it is drawn with
+ * a given atlas and color, and later draws copy that texture in one call.
+ * The least recently drawn textures are freed once the cache is over its
+ * byte budget. Text that changes every frame should use sdl_draw_text().
+ *
+ * @param sdl the context to draw in
+ * @param atlas the font to draw the text in
+ * @param text the text to draw
+ * @param loc the window position of the top left corner of the text
+ * @param color the color used for the text
+ */
+void sdl_draw_cached_text(sdl_context_t *sdl, glyph_atlas_t *atlas,
+                          const char *text, vector_t loc, SDL_Color color);
+
+/**
+ * Returns the counters of the text cache of a context.
+ */
+text_cache_stats_t sdl_get_text_cache_stats(sdl_context_t *sdl);
+
 /**
  * Draws all bodies in a scene.
  * This internally calls sdl_clear(), sdl_draw_polygon(), and sdl_show(),
  * so those functions should not be called directly.
  *
+ * @param sdl the context to draw in
  * @param scene the scene to draw
  * @param aux an additional body to draw (can be NULL if no additional bodies)
  */
-void sdl_render_scene(scene_t *scene, void *aux);
+void sdl_render_scene(sdl_context_t *sdl, scene_t *scene, void *aux);
 
 /**
  * Registers a function to be called every time a key is pressed.
@@ -172,45 +433,84 @@ void sdl_render_scene(scene_t *scene, void *aux);
  *     }
  * }
  * int main(void) {
- *     sdl_on_key(on_key);
- *     while (!sdl_is_done());
+ *     sdl_context_t *sdl = sdl_init(min, max);
+ *     sdl_on_key(sdl, on_key);
+ *     while (!sdl_is_done(sdl, NULL));
  * }
  * ```
  *
+ * @param sdl the context whose key presses to handle
  * @param handler the function to call with each key press
  */
-void sdl_on_key(key_handler_t handler);
+void sdl_on_key(sdl_context_t *sdl, key_handler_t handler);
 
 /**
  * Registers a function to be called when the mouse is clicked
  *
+ * @param sdl the context whose clicks to handle
  * @param handler the function to call with each mouse press
  */
-void sdl_on_click(mouse_handler_t handler);
+void sdl_on_click(sdl_context_t *sdl, mouse_handler_t handler);
 
 /**
  * Gets the amount of time that has passed since the last time
- * this function was called, in seconds.
+ * this function was called on the context, in seconds.
  *
  * @return the number of seconds that have elapsed
  */
-double time_since_last_tick(void);
+double time_since_last_tick(sdl_context_t *sdl);
 
 /**
  * Gets the bounding box of a body
  *
+ * @param sdl the context whose window the box is in
  * @param body the body to get the bounding box of
  * @return the bounding box of body
  */
-SDL_Rect sdl_get_bounding_box(body_t *body);
+SDL_Rect sdl_get_bounding_box(sdl_context_t *sdl, body_t *body);
+
+/**
+ * Converts points from scene coordinates to window coordinates, rounded to
+ * whole pixels. The transform is cached and only recomputed after the window
+ * is resized, so converting a whole array costs one multiply-add per
+ * coordinate.
+ *
+ * @param sdl the context whose window the points are drawn in
+ * @param points the points in scene coordinates
+ * @param pixels where to store the points in window coordinates; must not
+ *   overlap `points`
+ * @param count the number of points
+ */
+void sdl_scene_to_window(sdl_context_t *sdl, const vector_t *restrict points,
+                         vector_t *restrict pixels, size_t count);
+
+/**
+ * Gets a count of the times the scene-to-window transform has changed, i.e.
+ * the window has been resized. Whatever was computed with
+ * sdl_scene_to_window() can be cached until the count changes.
+ *
+ * @param sdl the context whose window the scene is drawn in
+ * @return the number of changes so far
+ */
+size_t sdl_get_view_changes(sdl_context_t *sdl);
 
 /**
  * Updates the bounding box of a body
  *
+ * @param sdl the context whose window the box is in
  * @param body the body to get the bounding box of
  * @param body the previous bounding box
  * @return the next bounding box of body
  */
-SDL_Rect sdl_update_bounding_box_body(body_t *body, SDL_Rect bounding_box);
+SDL_Rect sdl_update_bounding_box_body(sdl_context_t *sdl, body_t *body,
+                                      SDL_Rect bounding_box);
+
+/**
+ * Returns the number of heap allocations the drawing functions made during
+ * the last frame shown with sdl_show(). Drawing the same things as the frame
+ * before allocates nothing, so this is 0 in steady state; it only counts up
+ * when scratch buffers grow or new text is cached.
+ */
+size_t sdl_get_frame_allocations(sdl_context_t *sdl);
 
 #endif // #ifndef __SDL_WRAPPER_H__
@@ -0,0 +1,105 @@
+#ifndef __SLOT_MAP_H__
+#define __SLOT_MAP_H__
+
+#include "list.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A reference to a value in a slot map.
+ * Each slot's generation is bumped whenever its value is removed, so a handle
+ * kept after its value is removed no longer finds anything, even once the
+ * slot is reused. A zero-initialized handle, (handle_t){0}, never refers to a
+ * value.
+ */
+typedef struct handle {
+  uint32_t index;
+  uint32_t generation;
+} handle_t;
+
+/**
+ * A set of pointers addressed by generational handles.
+ * Looking up, inserting and removing a value all take O(1) time, and the
+ * values are kept packed together, so iterating over them with
+ * slot_map_get_at() skips the removed ones for free.
+ */
+typedef struct slot_map slot_map_t;
+
+/**
+ * Allocates memory for an empty slot map with space for the given number of
+ * values. The map grows when more are inserted.
+ * Asserts that the required memory was allocated.
+ *
+ * @param initial_size the number of values to allocate space for
+ * @param freer if non-NULL, a function to call on the values still in the map
+ *   in slot_map_free()
+ * @return a pointer to the newly allocated slot map
+ */
+slot_map_t *slot_map_init(size_t initial_size, free_func_t freer);
+
+/**
+ * Releases the memory allocated for a slot map.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ */
+void slot_map_free(slot_map_t *map);
+
+/**
+ * Gets the number of values in a slot map.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @return the number of values in the map
+ */
+size_t slot_map_size(slot_map_t *map);
+
+/**
+ * Adds a value to a slot map. Asserts that the value is non-NULL.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @param value the value to add
+ * @return the handle of the value
+ */
+handle_t slot_map_insert(slot_map_t *map, void *value);
+
+/**
+ * Looks up the value a handle refers to.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @param handle a handle returned from slot_map_insert() on this map
+ * @return the value, or NULL if it has been removed
+ */
+void *slot_map_get(slot_map_t *map, handle_t handle);
+
+/**
+ * Removes the value a handle refers to and returns it, without freeing it.
+ * The last value in iteration order moves into its place.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @param handle a handle returned from slot_map_insert() on this map
+ * @return the value, or NULL if it had already been removed
+ */
+void *slot_map_remove(slot_map_t *map, handle_t handle);
+
+/**
+ * Gets a value by its position among the values in a slot map, to iterate
+ * over them. Removing a value changes the position of the last one, so remove
+ * values while iterating from the end.
+ * Asserts that the index is valid, given the map's current size.
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @param index an index less than slot_map_size()
+ * @return the value at that index
+ */
+void *slot_map_get_at(slot_map_t *map, size_t index);
+
+/**
+ * Gets the handle of the value at a position, as for slot_map_get_at().
+ *
+ * @param map a pointer to a slot map returned from slot_map_init()
+ * @param index an index less than slot_map_size()
+ * @return the handle of the value at that index
+ */
+handle_t slot_map_handle_at(slot_map_t *map, size_t index);
+
+#endif // #ifndef __SLOT_MAP_H__
@@ -35,3 +35,12 @@ bool emscripten_main(state_t *state);
  * @param state pointer to a state object with info about demo
  */
 void emscripten_free(state_t *state);
+
+/**
+ * Returns the SDL context the demo draws in, whose events are processed
+ * between ticks.
+ *
+ * @param state pointer to a state object with info about demo
+ * @return the context returned from sdl_init() in emscripten_init()
+ */
+sdl_context_t *emscripten_get_sdl(state_t *state);
@@ -0,0 +1,200 @@
+#ifndef __TRACK_H__
+#define __TRACK_H__
+
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A compiled race track.
+ *
+ * Tracks are produced offline by the track compiler (tools/track_compiler.c)
+ * from a text description and are loaded with a single read-only mmap. All of
+ * the geometry returned by the accessors below points directly into the
+ * mapping, so it must not be modified and is only valid until track_free().
+ */
+typedef struct track track_t;
+
+/** "KTRK" when read as a little-endian uint32_t. */
+#define TRACK_MAGIC 0x4B52544Bu
+
+/**
+ * The version of the on-disk format. Bump this whenever the layout of any of
+ * the structs below changes, so stale tracks are rejected at load time.
+ */
+#define TRACK_VERSION 1u
+
+/** The maximum length (including the terminator) of the background path. */
+#define TRACK_PATH_MAX 64
+
+/**
+ * A wall segment running from `a` to `b`.
+ * `normal` is the unit normal pointing from the wall into the drivable area.
+ */
+typedef struct {
+  vector_t a;
+  vector_t b;
+  vector_t normal;
+} track_wall_t;
+
+/**
+ * A checkpoint gate stretching across the track from the inside wall to the
+ * outside wall. Gate 0 is the start/finish line; the rest are in race order.
+ */
+typedef struct {
+  vector_t in;
+  vector_t out;
+} track_gate_t;
+
+/**
+ * A point on the track centerline, together with the distance travelled
+ * along the centerline from the start line to reach it.
+ */
+typedef struct {
+  vector_t point;
+  double distance;
+} track_path_point_t;
+
+/**
+ * The uniform grid the walls are bucketed into.
+ * Cell (col, row) covers [min.x + col * cell_size, min.x + (col+1) * cell_size)
+ * horizontally, and similarly vertically.
+ */
+typedef struct {
+  vector_t min;
+  double cell_size;
+  uint32_t cols;
+  uint32_t rows;
+} track_grid_t;
+
+/**
+ * The header at the start of every compiled track file.
+ * Every section is addressed by a byte offset from the start of the file and
+ * is aligned to 8 bytes.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t file_size;
+
+  char background_path[TRACK_PATH_MAX];
+  vector_t background_min;
+  vector_t background_max;
+
+  vector_t spawn;
+  double spawn_rotation;
+  double path_length;
+
+  uint32_t num_walls;
+  uint32_t walls_offset; // track_wall_t[num_walls]
+  uint32_t num_gates;
+  uint32_t gates_offset; // track_gate_t[num_gates]
+  uint32_t num_path;
+  uint32_t path_offset; // track_path_point_t[num_path]
+  uint32_t num_boxes;
+  uint32_t boxes_offset; // vector_t[num_boxes]
+
+  track_grid_t grid;
+  uint32_t cells_offset; // uint32_t[cols * rows + 1], start of each cell
+  uint32_t num_cell_walls;
+  uint32_t cell_walls_offset; // uint32_t[num_cell_walls], wall indices
+  uint32_t reserved;
+} track_header_t;
+
+/**
+ * Maps a compiled track file into memory and validates its header.
+ * Prints the reason and returns NULL if the file is missing, has the wrong
+ * magic number or version, or any section lies outside of the file.
+ *
+ * @param path the path to the compiled .trk file
+ * @return the loaded track, or NULL on failure
+ */
+track_t *track_load(const char *path);
+
+/**
+ * Unmaps a track. Every pointer obtained from the track becomes invalid.
+ *
+ * @param track a track returned by track_load()
+ */
+void track_free(track_t *track);
+
+/**
+ * Returns the path to the image drawn under the track.
+ */
+const char *track_get_background_path(track_t *track);
+
+/**
+ * Returns the bottom left and top right corners of the background image.
+ */
+void track_get_background_bounds(track_t *track, vector_t *min, vector_t *max);
+
+/**
+ * Returns the position the player's car starts the race at.
+ */
+vector_t track_get_spawn(track_t *track);
+
+/**
+ * Returns the rotation the cars start the race with.
+ */
+double track_get_spawn_rotation(track_t *track);
+
+/**
+ * Returns the wall segments and stores their number in `count`.
+ */
+const track_wall_t *track_get_walls(track_t *track, size_t *count);
+
+/**
+ * Returns the checkpoint gates and stores their number in `count`.
+ */
+const track_gate_t *track_get_gates(track_t *track, size_t *count);
+
+/**
+ * Returns the centerline and stores its number of points in `count`.
+ * The centerline has one point per gate, in the same order.
+ */
+const track_path_point_t *track_get_path(track_t *track, size_t *count);
+
+/**
+ * Returns the length of one lap along the centerline, including the closing
+ * segment from the last point back to the start line.
+ */
+double track_get_path_length(track_t *track);
+
+/**
+ * Returns the item box spawn positions and stores their number in `count`.
+ */
+const vector_t *track_get_boxes(track_t *track, size_t *count);
+
+/**
+ * Returns the layout of the wall grid.
+ */
+track_grid_t track_get_grid(track_t *track);
+
+/**
+ * Returns the indices of the walls overlapping a grid cell, and stores their
+ * number in `count`. Asserts that the cell is inside the grid.
+ *
+ * @param track the track
+ * @param col the column of the cell
+ * @param row the row of the cell
+ * @param count where to store the number of walls in the cell
+ * @return the indices into track_get_walls() of the walls in the cell
+ */
+const uint32_t *track_get_cell_walls(track_t *track, size_t col, size_t row,
+                                     size_t *count);
+
+/**
+ * Finds the range of grid cells overlapping a box in track coordinates.
+ *
+ * @param track the track
+ * @param min the bottom left corner of the box
+ * @param max the top right corner of the box
+ * @param lo where to store the lowest (col, row) overlapping the box
+ * @param hi where to store the highest (col, row) overlapping the box
+ * @return false if the box is entirely outside of the grid
+ */
+bool track_get_cell_range(track_t *track, vector_t min, vector_t max,
+                          size_t lo[2], size_t hi[2]);
+
+#endif // #ifndef __TRACK_H__
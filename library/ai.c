@@ -0,0 +1,385 @@
+#include "ai.h"
+#include "checkpoints.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const double AI_EASY_SPEED = 250;
+const double AI_MEDIUM_SPEED = 300;
+const double AI_HARD_SPEED = 350;
+const double AI_PATH_TOLERANCE = 0.2;
+// The ghost's speed times the player's best lap time
+const double AI_GHOST_SCALE = 29875.0;
+
+const size_t INITIAL_AI_CARS = 4;
+// Cars closer than this to the player are steered every tick
+const double AI_NEAR_DISTANCE = 800;
+// Cars further than this are moved along the track path without physics
+const double AI_FAR_DISTANCE = 1600;
+// How far a car has to come back inside a threshold before it switches back,
+// so cars on a threshold don't flip between levels every tick
+const double AI_LOD_HYSTERESIS = 100;
+// How often cars between the near and far distances are steered
+const double AI_MID_STEER_INTERVAL = 0.1;
+// How far from the centerline a far car may drive
+const double AI_MAX_LATERAL = 50;
+// The angles (relative to the car's heading) and length of the feeler rays
+// near cars use to avoid walls and other cars
+const double AI_FEELER_ANGLES[] = {-0.6, -0.3, 0, 0.3, 0.6};
+const double AI_FEELER_LENGTH = 150;
+// How far a car turns away from an obstacle right in front of a feeler
+const double AI_AVOID_TURN = 0.3;
+
+typedef struct ai_car {
+  body_t *body;
+  ai_lod_t lod;
+  double steer_timer;
+  // Only used while the car is far away
+  size_t segment;  // the path point the car last passed
+  double progress; // distance along the path since the start line
+  double lateral;  // signed distance from the centerline
+} ai_car_t;
+
+struct ai {
+  list_t *cars;
+  ai_car_t *states;
+  size_t capacity;
+  double path_tolerance;
+  double stun_rot_speed;
+  scene_t *scene;
+  track_t *track;
+  body_t *anchor;
+  list_t *checkpoints;
+};
+
+ai_tuning_t ai_default_tuning(void) {
+  return (ai_tuning_t){.easy_speed = AI_EASY_SPEED,
+                       .medium_speed = AI_MEDIUM_SPEED,
+                       .hard_speed = AI_HARD_SPEED,
+                       .path_tolerance = AI_PATH_TOLERANCE};
+}
+
+double ai_villain_speed(ai_tuning_t tuning, villain_type_t type,
+                        double best_time) {
+  switch (type) {
+  case EASY_AI:
+    return tuning.easy_speed;
+  case MEDIUM_AI:
+    return tuning.medium_speed;
+  case HARD_AI:
+    return tuning.hard_speed;
+  case GHOST:
+    return AI_GHOST_SCALE / best_time;
+  }
+  assert(false && "Invalid villain type");
+  return 0;
+}
+
+ai_t *ai_init(double path_tolerance, double stun_rot_speed) {
+  ai_t *ai = malloc(sizeof(ai_t));
+  assert(ai != NULL);
+  ai->cars = list_init(INITIAL_AI_CARS, NULL);
+  ai->capacity = INITIAL_AI_CARS;
+  ai->states = malloc(ai->capacity * sizeof(ai_car_t));
+  assert(ai->states != NULL);
+  ai->path_tolerance = path_tolerance;
+  ai->stun_rot_speed = stun_rot_speed;
+  ai->scene = NULL;
+  ai->track = NULL;
+  ai->anchor = NULL;
+  ai->checkpoints = NULL;
+  return ai;
+}
+
+void ai_free(ai_t *ai) {
+  list_free(ai->cars);
+  free(ai->states);
+  free(ai);
+}
+
+void ai_set_track(ai_t *ai, scene_t *scene, track_t *track, body_t *anchor,
+                  list_t *checkpoints) {
+  size_t num_path;
+  track_get_path(track, &num_path);
+  assert(list_size(checkpoints) == num_path);
+  ai->scene = scene;
+  ai->track = track;
+  ai->anchor = anchor;
+  ai->checkpoints = checkpoints;
+}
+
+void ai_add_car(ai_t *ai, body_t *car) {
+  assert(car_get_checkpoint_state(car) != NULL);
+  size_t idx = list_size(ai->cars);
+  if (idx == ai->capacity) {
+    ai->capacity *= 2;
+    ai->states = realloc(ai->states, ai->capacity * sizeof(ai_car_t));
+    assert(ai->states != NULL);
+  }
+  ai->states[idx] = (ai_car_t){.body = car, .lod = AI_LOD_NEAR};
+  list_add(ai->cars, car);
+}
+
+size_t ai_num_cars(ai_t *ai) { return list_size(ai->cars); }
+
+body_t *ai_get_car(ai_t *ai, size_t idx) { return list_get(ai->cars, idx); }
+
+list_t *ai_get_cars(ai_t *ai) { return ai->cars; }
+
+ai_lod_t ai_get_lod(ai_t *ai, size_t idx) {
+  assert(idx < list_size(ai->cars));
+  return ai->states[idx].lod;
+}
+
+size_t ai_count_lod(ai_t *ai, ai_lod_t lod) {
+  size_t count = 0;
+  for (size_t i = 0; i < list_size(ai->cars); i++) {
+    count += ai->states[i].lod == lod;
+  }
+  return count;
+}
+
+/**
+ * Spins a car while it is stunned. Stuns are timed in scene time, so this
+ * needs the scene from ai_set_track().
+ */
+static void spin_if_stunned(ai_t *ai, body_t *car, double dt) {
+  if (ai->scene != NULL &&
+      scene_get_time(ai->scene) < car_get_powerup_state(car).stun_until) {
+    body_set_rotation(car, body_get_rotation(car) + dt * ai->stun_rot_speed);
+  }
+}
+
+/**
+ * Drives a car forwards at its top speed.
+ */
+static void drive(body_t *car) {
+  double theta = body_get_rotation(car);
+  vector_t direction = {sin(theta), -cos(theta)};
+  body_set_velocity(car, vec_multiply(car_get_top_speed(car), direction));
+}
+
+/**
+ * Points a car at its next checkpoint once it is roughly facing it.
+ */
+static void steer(ai_t *ai, body_t *car) {
+  double theta = body_get_rotation(car);
+  vector_t direction = {.x = sin(theta), .y = -cos(theta)};
+  vector_t right_way =
+      get_right_way_from_position(car_get_checkpoint_state(car), car);
+  double dot_prod = vec_dot(direction, right_way);
+  if (dot_prod > ai->path_tolerance) {
+    theta = theta + atan2(right_way.y, right_way.x) -
+            atan2(direction.y, direction.x);
+    body_set_rotation(car, theta);
+  }
+}
+
+/**
+ * Feelers only see the walls and other moving bodies, not the car casting
+ * them, the background or other infinite-mass scenery.
+ */
+static bool is_obstacle(body_t *body, void *aux) {
+  if (body_get_collider_type(body) == COLLIDER_TRACK_WALLS) {
+    return true;
+  }
+  return body != aux && body_get_mass(body) != INFINITY &&
+         !body_is_kinematic(body);
+}
+
+/**
+ * Turns a car away from walls and cars in front of it.
+ * Each feeler that hits something turns the car away from its side, more so
+ * the closer the hit. A hit straight ahead turns the car towards whichever
+ * side has more room.
+ */
+static void avoid(ai_t *ai, body_t *car) {
+  size_t num_feelers = sizeof(AI_FEELER_ANGLES) / sizeof(*AI_FEELER_ANGLES);
+  double theta = body_get_rotation(car);
+  vector_t origin = body_get_centroid(car);
+  double turn = 0;
+  double ahead = 0;
+  for (size_t i = 0; i < num_feelers; i++) {
+    double angle = theta + AI_FEELER_ANGLES[i];
+    vector_t direction = {sin(angle), -cos(angle)};
+    scene_hit_t hit = scene_raycast(ai->scene, origin, direction,
+                                    AI_FEELER_LENGTH, is_obstacle, car);
+    if (hit.body == NULL) {
+      continue;
+    }
+    double closeness = 1 - hit.distance / AI_FEELER_LENGTH;
+    if (AI_FEELER_ANGLES[i] == 0) {
+      ahead = closeness;
+    } else {
+      turn += AI_FEELER_ANGLES[i] > 0 ? -closeness : closeness;
+    }
+  }
+  turn += turn >= 0 ? ahead : -ahead;
+  body_set_rotation(car, theta + AI_AVOID_TURN * turn);
+}
+
+/**
+ * Counts a lap for a car once it crosses the finish line.
+ */
+static void update_laps(body_t *car) {
+  checkpoint_state_t *checkpoint_state = car_get_checkpoint_state(car);
+  if (get_lap_over(checkpoint_state)) {
+    reset_checkpoint_state(checkpoint_state);
+    car_set_laps_done(car, car_get_laps_done(car) + 1);
+  }
+}
+
+/**
+ * Returns the start of a segment of the path and its unit direction.
+ * Segment i runs from path point i to path point i + 1, and the last segment
+ * closes the loop back to the start line.
+ */
+static vector_t path_segment(ai_t *ai, size_t segment, vector_t *direction,
+                             double *length) {
+  size_t num_path;
+  const track_path_point_t *path = track_get_path(ai->track, &num_path);
+  size_t next = (segment + 1) % num_path;
+  double end = next == 0 ? track_get_path_length(ai->track)
+                         : path[next].distance;
+  vector_t delta = vec_subtract(path[next].point, path[segment].point);
+  *length = end - path[segment].distance;
+  *direction = vec_multiply(1 / vec_get_length(delta), delta);
+  return path[segment].point;
+}
+
+/**
+ * Takes a car off the physics simulation, working out how far along the
+ * path it is from the last checkpoint it crossed.
+ */
+static void enter_far(ai_t *ai, ai_car_t *state) {
+  size_t num_path;
+  const track_path_point_t *path = track_get_path(ai->track, &num_path);
+  state->segment =
+      get_current_checkpoint(car_get_checkpoint_state(state->body));
+  vector_t direction;
+  double length;
+  vector_t start = path_segment(ai, state->segment, &direction, &length);
+  vector_t position = vec_subtract(body_get_centroid(state->body),
+                                   body_get_track_offset(ai->anchor));
+  vector_t relative = vec_subtract(position, start);
+  double along = fmin(fmax(vec_dot(relative, direction), 0), length);
+  vector_t normal = {-direction.y, direction.x};
+  state->progress = path[state->segment].distance + along;
+  state->lateral = fmin(fmax(vec_dot(relative, normal), -AI_MAX_LATERAL),
+                        AI_MAX_LATERAL);
+  body_set_kinematic(state->body, true);
+}
+
+/**
+ * Hands a far car back to the physics simulation, moving at its top speed in
+ * the direction it is facing.
+ */
+static void leave_far(ai_car_t *state) {
+  body_set_kinematic(state->body, false);
+  drive(state->body);
+  state->steer_timer = 0;
+}
+
+/**
+ * Moves a far car along the path at its top speed, crossing checkpoints as
+ * it passes their path points.
+ */
+static void move_far(ai_t *ai, ai_car_t *state, double dt) {
+  size_t num_path;
+  const track_path_point_t *path = track_get_path(ai->track, &num_path);
+  double lap = track_get_path_length(ai->track);
+  body_t *car = state->body;
+  state->progress += car_get_top_speed(car) * dt;
+  while (true) {
+    size_t next = (state->segment + 1) % num_path;
+    double end = next == 0 ? lap : path[next].distance;
+    if (state->progress < end) {
+      break;
+    }
+    if (next == 0) {
+      state->progress -= lap;
+    }
+    state->segment = next;
+    checkpoint_collision(car, list_get(ai->checkpoints, next), VEC_ZERO,
+                         car_get_checkpoint_state(car), 0);
+  }
+  vector_t direction;
+  double length;
+  vector_t start = path_segment(ai, state->segment, &direction, &length);
+  vector_t normal = {-direction.y, direction.x};
+  vector_t along =
+      vec_multiply(state->progress - path[state->segment].distance, direction);
+  vector_t position =
+      vec_add(vec_add(start, along), vec_multiply(state->lateral, normal));
+  body_set_centroid(car, vec_add(position, body_get_track_offset(ai->anchor)));
+  body_set_rotation(car, atan2(direction.x, -direction.y));
+  body_set_velocity(car, vec_multiply(car_get_top_speed(car), direction));
+}
+
+/**
+ * Picks the level of detail of a car from its distance to the player.
+ */
+static ai_lod_t choose_lod(ai_t *ai, ai_car_t *state, body_t *player) {
+  if (player == NULL) {
+    return AI_LOD_NEAR;
+  }
+  double distance = vec_get_length(
+      vec_subtract(body_get_centroid(state->body), body_get_centroid(player)));
+  // Cars are only moved along the path if there is one to move them along
+  double far = ai->track == NULL ? INFINITY : AI_FAR_DISTANCE;
+  double near = AI_NEAR_DISTANCE;
+  if (state->lod == AI_LOD_FAR) {
+    far -= AI_LOD_HYSTERESIS;
+  }
+  if (state->lod != AI_LOD_NEAR) {
+    near -= AI_LOD_HYSTERESIS;
+  }
+  if (distance > far) {
+    return AI_LOD_FAR;
+  }
+  if (distance > near) {
+    return AI_LOD_MID;
+  }
+  return AI_LOD_NEAR;
+}
+
+void ai_tick(ai_t *ai, body_t *player, double dt) {
+  size_t num_cars = list_size(ai->cars);
+  for (size_t i = 0; i < num_cars; i++) {
+    ai_car_t *state = &ai->states[i];
+    body_t *car = state->body;
+    spin_if_stunned(ai, car, dt);
+    ai_lod_t lod = choose_lod(ai, state, player);
+    if (lod == AI_LOD_FAR && state->lod != AI_LOD_FAR) {
+      enter_far(ai, state);
+    } else if (lod != AI_LOD_FAR && state->lod == AI_LOD_FAR) {
+      leave_far(state);
+    }
+    state->lod = lod;
+
+    switch (lod) {
+    case AI_LOD_NEAR: {
+      steer(ai, car);
+      if (ai->scene != NULL) {
+        avoid(ai, car);
+      }
+      drive(car);
+      break;
+    }
+    case AI_LOD_MID: {
+      state->steer_timer -= dt;
+      if (state->steer_timer <= 0) {
+        steer(ai, car);
+        state->steer_timer = AI_MID_STEER_INTERVAL;
+      }
+      drive(car);
+      break;
+    }
+    case AI_LOD_FAR: {
+      move_far(ai, state, dt);
+      break;
+    }
+    }
+    update_laps(car);
+  }
+}
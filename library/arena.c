@@ -0,0 +1,85 @@
+#include "arena.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+typedef struct chunk {
+  struct chunk *next;
+  size_t size;
+  size_t used;
+  max_align_t data[]; // so the data is aligned for any type
+} chunk_t;
+
+struct arena {
+  chunk_t *first;
+  chunk_t *current; // the chunk being allocated from; later ones are free
+  size_t chunk_size;
+  size_t used; // in the chunks before the current one
+};
+
+/**
+ * Rounds a size up to the alignment of every type.
+ */
+static size_t align_size(size_t size) {
+  size_t align = _Alignof(max_align_t);
+  return (size + align - 1) / align * align;
+}
+
+static chunk_t *chunk_init(size_t size) {
+  chunk_t *chunk = malloc(sizeof(chunk_t) + size);
+  assert(chunk != NULL);
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
+
+arena_t *arena_init(size_t chunk_size) {
+  assert(chunk_size > 0);
+  arena_t *arena = malloc(sizeof(arena_t));
+  assert(arena != NULL);
+  arena->chunk_size = align_size(chunk_size);
+  arena->first = chunk_init(arena->chunk_size);
+  arena->current = arena->first;
+  arena->used = 0;
+  return arena;
+}
+
+void arena_free(arena_t *arena) {
+  chunk_t *chunk = arena->first;
+  while (chunk != NULL) {
+    chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena);
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  size = align_size(size);
+  chunk_t *chunk = arena->current;
+  while (chunk->size - chunk->used < size) {
+    if (chunk->next == NULL) {
+      size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+      chunk->next = chunk_init(chunk_size);
+    }
+    // The rest of a chunk that is too small is left unused until the reset
+    arena->used += chunk->size;
+    chunk = chunk->next;
+    chunk->used = 0;
+  }
+  arena->current = chunk;
+  void *memory = (char *)chunk->data + chunk->used;
+  chunk->used += size;
+  return memory;
+}
+
+void arena_reset(arena_t *arena) {
+  arena->current = arena->first;
+  arena->first->used = 0;
+  arena->used = 0;
+}
+
+size_t arena_used(arena_t *arena) {
+  return arena->used + arena->current->used;
+}
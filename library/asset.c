@@ -7,18 +7,21 @@
 typedef struct asset {
   asset_type_t type;
   SDL_Rect bounding_box;
+  sdl_context_t *sdl; // where the asset is rendered
 } asset_t;
 
 typedef struct text_asset {
   asset_t base;
-  TTF_Font *font;
+  glyph_atlas_t *atlas;
   const char *text;
   rgb_color_t color;
+  bool is_dynamic;
 } text_asset_t;
 
 typedef struct image_asset {
   asset_t base;
-  SDL_Texture *texture;
+  const texture_region_t *region;
+  tiled_image_t *tiles; // drawn instead of the region if non-NULL
   body_t *body;
   bool is_rotated;
 } image_asset_t;
@@ -34,12 +37,14 @@ typedef struct button_asset {
 /**
  * Allocates memory for an asset with the given parameters.
  *
+ * @param sdl the context the asset is rendered in
  * @param ty the type of the asset
  * @param bounding_box the bounding box containing the location and dimensions
  * of the asset when it is rendered
  * @return a pointer to the newly allocated asset
  */
-static asset_t *asset_init(asset_type_t ty, SDL_Rect bounding_box) {
+static asset_t *asset_init(sdl_context_t *sdl, asset_type_t ty,
+                           SDL_Rect bounding_box) {
   asset_t *new;
   switch (ty) {
   case ASSET_IMAGE: {
@@ -61,42 +66,75 @@ static asset_t *asset_init(asset_type_t ty, SDL_Rect bounding_box) {
   assert(new != NULL);
   new->type = ty;
   new->bounding_box = bounding_box;
+  new->sdl = sdl;
   return new;
 }
 
 asset_type_t asset_get_type(asset_t *asset) { return asset->type; }
 
-asset_t *asset_make_image(const char *filepath, SDL_Rect bounding_box) {
-  image_asset_t *image = (image_asset_t *)asset_init(ASSET_IMAGE, bounding_box);
+asset_t *asset_make_image(asset_cache_t *cache, const char *filepath,
+                          SDL_Rect bounding_box) {
+  image_asset_t *image = (image_asset_t *)asset_init(
+      asset_cache_get_sdl(cache), ASSET_IMAGE, bounding_box);
   image->body = NULL;
-  image->texture = asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
+  image->region = asset_cache_obj_get_or_create(cache, ASSET_IMAGE, filepath);
+  image->tiles = NULL;
   image->is_rotated = false;
   return (asset_t *)image;
 }
 
-asset_t *asset_make_image_with_body(const char *filepath, body_t *body) {
-  image_asset_t *image =
-      (image_asset_t *)asset_init(ASSET_IMAGE, sdl_get_bounding_box(body));
+asset_t *asset_make_image_with_body(asset_cache_t *cache, const char *filepath,
+                                    body_t *body) {
+  sdl_context_t *sdl = asset_cache_get_sdl(cache);
+  image_asset_t *image = (image_asset_t *)asset_init(
+      sdl, ASSET_IMAGE, sdl_get_bounding_box(sdl, body));
+  image->body = body;
+  image->region = asset_cache_obj_get_or_create(cache, ASSET_IMAGE, filepath);
+  image->tiles = NULL;
+  image->is_rotated = false;
+  return (asset_t *)image;
+}
+
+asset_t *asset_make_tiled_image_with_body(asset_cache_t *cache,
+                                          const char *filepath, body_t *body) {
+  sdl_context_t *sdl = asset_cache_get_sdl(cache);
+  image_asset_t *image = (image_asset_t *)asset_init(
+      sdl, ASSET_IMAGE, sdl_get_bounding_box(sdl, body));
   image->body = body;
-  image->texture = asset_cache_obj_get_or_create(ASSET_IMAGE, filepath);
+  image->region = NULL;
+  image->tiles =
+      asset_cache_obj_get_or_create(cache, ASSET_TILED_IMAGE, filepath);
   image->is_rotated = false;
   return (asset_t *)image;
 }
 
-asset_t *asset_make_rotatable_image_with_body(const char *filepath,
+asset_t *asset_make_rotatable_image_with_body(asset_cache_t *cache,
+                                              const char *filepath,
                                               body_t *body) {
   image_asset_t *image =
-      (image_asset_t *)asset_make_image_with_body(filepath, body);
+      (image_asset_t *)asset_make_image_with_body(cache, filepath, body);
   image->is_rotated = true;
   return (asset_t *)image;
 }
 
-asset_t *asset_make_text(const char *filepath, SDL_Rect bounding_box,
-                         const char *text, rgb_color_t color) {
-  text_asset_t *asset = (text_asset_t *)asset_init(ASSET_FONT, bounding_box);
+asset_t *asset_make_text(asset_cache_t *cache, const char *filepath,
+                         SDL_Rect bounding_box, const char *text,
+                         rgb_color_t color) {
+  text_asset_t *asset = (text_asset_t *)asset_init(asset_cache_get_sdl(cache),
+                                                   ASSET_FONT, bounding_box);
   asset->text = text;
   asset->color = color;
-  asset->font = asset_cache_obj_get_or_create(ASSET_FONT, filepath);
+  asset->atlas = asset_cache_obj_get_or_create(cache, ASSET_FONT, filepath);
+  asset->is_dynamic = false;
+  return (asset_t *)asset;
+}
+
+asset_t *asset_make_dynamic_text(asset_cache_t *cache, const char *filepath,
+                                 SDL_Rect bounding_box, const char *text,
+                                 rgb_color_t color) {
+  text_asset_t *asset = (text_asset_t *)asset_make_text(
+      cache, filepath, bounding_box, text, color);
+  asset->is_dynamic = true;
   return (asset_t *)asset;
 }
 
@@ -104,8 +142,12 @@ asset_t *asset_make_button(SDL_Rect bounding_box, asset_t *image_asset,
                            asset_t *text_asset, button_handler_t handler) {
   assert(image_asset == NULL || image_asset->type == ASSET_IMAGE);
   assert(text_asset == NULL || text_asset->type == ASSET_FONT);
+  assert(image_asset != NULL || text_asset != NULL);
+  // A button is drawn wherever its image and text are
+  sdl_context_t *sdl =
+      image_asset != NULL ? image_asset->sdl : text_asset->sdl;
   button_asset_t *asset =
-      (button_asset_t *)asset_init(ASSET_BUTTON, bounding_box);
+      (button_asset_t *)asset_init(sdl, ASSET_BUTTON, bounding_box);
   asset->text_asset = (text_asset_t *)text_asset;
   asset->image_asset = (image_asset_t *)image_asset;
   asset->handler = handler;
@@ -132,25 +174,24 @@ void asset_rotate(asset_t *asset, double angle) { ; }
 void asset_render(asset_t *asset) {
   // add a case for button assets.
   vector_t loc = {.x = asset->bounding_box.x, .y = asset->bounding_box.y};
-  vector_t size = {.x = asset->bounding_box.w, .y = asset->bounding_box.h};
   switch (asset->type) {
   case ASSET_IMAGE: {
     image_asset_t *image = (image_asset_t *)asset;
-    if (image->body != NULL) {
-      if (image->is_rotated) {
-        SDL_Rect bounding_box =
-            sdl_update_bounding_box_body(image->body, asset->bounding_box);
-        sdl_display_image_with_angle(image->texture, bounding_box,
-                                     body_get_rotation(image->body),
-                                     body_get_centroid(image->body));
-      } else {
-        SDL_Rect bounding_box = sdl_get_bounding_box(image->body);
-        loc = (vector_t){.x = bounding_box.x, .y = bounding_box.y};
-        size = (vector_t){.x = bounding_box.w, .y = bounding_box.h};
-        sdl_display_image(image->texture, loc, size);
-      }
+    SDL_Rect bounding_box = asset->bounding_box;
+    double theta = 0;
+    if (image->body != NULL && image->is_rotated) {
+      bounding_box = sdl_update_bounding_box_body(asset->sdl, image->body,
+                                                  asset->bounding_box);
+      theta = body_get_rotation(image->body);
+    } else if (image->body != NULL) {
+      bounding_box = sdl_get_bounding_box(asset->sdl, image->body);
+    }
+    if (image->tiles != NULL) {
+      sdl_draw_tiled_image(asset->sdl, image->tiles, bounding_box);
     } else {
-      sdl_display_image(image->texture, loc, size);
+      // The region may be a part of an atlas shared with other images
+      sdl_draw_sprite(asset->sdl, image->region->texture,
+                      &image->region->source, bounding_box, theta);
     }
     break;
   }
@@ -158,7 +199,11 @@ void asset_render(asset_t *asset) {
     text_asset_t *text = (text_asset_t *)asset;
     SDL_Color color = {
         .r = text->color.r, .g = text->color.g, .b = text->color.b, .a = 255};
-    sdl_display_message(text->font, text->text, loc, color);
+    if (text->is_dynamic) {
+      sdl_draw_text(asset->sdl, text->atlas, text->text, loc, color);
+    } else {
+      sdl_draw_cached_text(asset->sdl, text->atlas, text->text, loc, color);
+    }
     break;
   }
   case ASSET_BUTTON: {
@@ -4,93 +4,157 @@
 
 #include "asset.h"
 #include "asset_cache.h"
+#include "hash_map.h"
 #include "list.h"
 #include "sdl_wrapper.h"
 
-static list_t *ASSET_CACHE;
-
 const size_t FONT_SIZE = 18;
 const size_t INITIAL_CAPACITY = 5;
 
 typedef struct {
+  sdl_context_t *sdl;
   asset_type_t type;
   const char *filepath;
   void *obj;
+  /** Whether the obj is a texture_region_t in one of the cache's pages */
+  bool is_packed;
 } entry_t;
 
+struct asset_cache {
+  sdl_context_t *sdl;
+  string_pool_t *paths;
+  hash_map_t *entries; // interned filepath -> entry_t
+  list_t *buttons;     // asset_t, kept apart so lookups never see them
+  list_t *pages;       // SDL_Texture, the atlases of the packed images
+};
+
 static void asset_cache_free_entry(entry_t *entry) {
   switch (entry->type) {
   case ASSET_IMAGE: {
-    SDL_DestroyTexture(entry->obj);
+    texture_region_t *region = entry->obj;
+    if (!entry->is_packed && region->texture != NULL) {
+      sdl_destroy_texture(entry->sdl, region->texture);
+    }
+    free(region);
     break;
   }
   case ASSET_FONT: {
-    TTF_CloseFont(entry->obj);
+    sdl_free_glyph_atlas(entry->obj);
     break;
   }
-  case ASSET_BUTTON: {
-    asset_destroy(entry->obj);
+  case ASSET_TILED_IMAGE: {
+    sdl_free_tiled_image(entry->obj);
     break;
   }
   default: {
     abort();
   }
   }
+  free(entry);
+}
+
+asset_cache_t *asset_cache_init(sdl_context_t *sdl) {
+  asset_cache_t *cache = malloc(sizeof(asset_cache_t));
+  assert(cache != NULL);
+  cache->sdl = sdl;
+  cache->paths = string_pool_init();
+  cache->entries = hash_map_init(INITIAL_CAPACITY, hash_string, string_equal,
+                                 (free_func_t)asset_cache_free_entry);
+  cache->buttons = list_init(INITIAL_CAPACITY, (free_func_t)asset_destroy);
+  cache->pages = list_init(1, NULL);
+  return cache;
 }
 
-void asset_cache_init() {
-  ASSET_CACHE =
-      list_init(INITIAL_CAPACITY, (free_func_t)asset_cache_free_entry);
+void asset_cache_destroy(asset_cache_t *cache) {
+  list_free(cache->buttons);
+  hash_map_free(cache->entries);
+  for (size_t i = 0; i < list_size(cache->pages); i++) {
+    sdl_destroy_texture(cache->sdl, list_get(cache->pages, i));
+  }
+  list_free(cache->pages);
+  string_pool_free(cache->paths);
+  free(cache);
 }
 
-void asset_cache_destroy() { list_free(ASSET_CACHE); }
+sdl_context_t *asset_cache_get_sdl(asset_cache_t *cache) { return cache->sdl; }
 
-void *asset_cache_obj_get_or_create(asset_type_t ty, const char *filepath) {
-  for (size_t i = 0; i < list_size(ASSET_CACHE); i++) {
-    entry_t *entry = list_get(ASSET_CACHE, i);
-    if (entry->filepath == NULL) {
-      continue;
-    } else if (strcmp(entry->filepath, filepath) == 0) {
-      assert(ty == entry->type);
-      return entry->obj;
-    }
+void *asset_cache_obj_get_or_create(asset_cache_t *cache, asset_type_t ty,
+                                    const char *filepath) {
+  entry_t *entry = hash_map_get(cache->entries, filepath);
+  if (entry != NULL) {
+    assert(ty == entry->type);
+    return entry->obj;
   }
-  entry_t *entry = malloc(sizeof(entry_t));
+  entry = malloc(sizeof(entry_t));
   assert(entry != NULL);
+  entry->sdl = cache->sdl;
   entry->type = ty;
-  entry->filepath = filepath;
+  // The caller's string may not outlive the entry, so key it by our own copy
+  entry->filepath = string_intern(cache->paths, filepath);
+  entry->is_packed = false;
   switch (ty) {
   case ASSET_IMAGE: {
-    entry->obj = sdl_load_image(filepath);
+    texture_region_t *region = malloc(sizeof(texture_region_t));
+    assert(region != NULL);
+    region->texture = sdl_load_image(cache->sdl, filepath);
+    region->source = (SDL_Rect){.x = 0, .y = 0, .w = 0, .h = 0};
+    if (region->texture != NULL) {
+      vector_t size = sdl_get_texture_size(cache->sdl, region->texture);
+      region->source.w = size.x;
+      region->source.h = size.y;
+    }
+    entry->obj = region;
     break;
   }
   case ASSET_FONT: {
-    entry->obj = sdl_load_font(filepath, FONT_SIZE);
+    entry->obj = sdl_load_glyph_atlas(cache->sdl, filepath, FONT_SIZE);
+    break;
+  }
+  case ASSET_TILED_IMAGE: {
+    entry->obj = sdl_load_tiled_image(cache->sdl, filepath);
     break;
   }
   default: {
     assert(false && "Attempted to pass invalid type to Asset");
   }
   }
-  list_add(ASSET_CACHE, entry);
+  hash_map_put(cache->entries, entry->filepath, entry);
   return entry->obj;
 }
 
-void asset_cache_register_button(asset_t *button) {
-  assert(button != NULL);
-  entry_t *entry = malloc(sizeof(entry_t));
-  assert(entry != NULL);
-  entry->type = ASSET_BUTTON;
-  entry->filepath = NULL;
-  entry->obj = button;
-  list_add(ASSET_CACHE, entry);
+void asset_cache_pack_images(asset_cache_t *cache, const char *const *paths,
+                             size_t count) {
+  texture_region_t *regions = malloc(count * sizeof(texture_region_t));
+  assert(regions != NULL);
+  sdl_pack_images(cache->sdl, paths, count, regions, cache->pages);
+  for (size_t i = 0; i < count; i++) {
+    if (regions[i].texture == NULL ||
+        hash_map_get(cache->entries, paths[i]) != NULL) {
+      continue; // loaded on its own when it is first used
+    }
+    entry_t *entry = malloc(sizeof(entry_t));
+    assert(entry != NULL);
+    entry->sdl = cache->sdl;
+    entry->type = ASSET_IMAGE;
+    entry->filepath = string_intern(cache->paths, paths[i]);
+    entry->is_packed = true;
+    texture_region_t *region = malloc(sizeof(texture_region_t));
+    assert(region != NULL);
+    *region = regions[i];
+    entry->obj = region;
+    hash_map_put(cache->entries, entry->filepath, entry);
+  }
+  free(regions);
 }
 
-void asset_cache_handle_buttons(state_t *state, double x, double y) {
-  for (size_t i = 0; i < list_size(ASSET_CACHE); i++) {
-    entry_t *entry = list_get(ASSET_CACHE, i);
-    if (entry->type == ASSET_BUTTON) {
-      asset_on_button_click(entry->obj, state, x, y);
-    }
+void asset_cache_register_button(asset_cache_t *cache, asset_t *button) {
+  assert(button != NULL && asset_get_type(button) == ASSET_BUTTON);
+  list_add(cache->buttons, button);
+}
+
+void asset_cache_handle_buttons(asset_cache_t *cache, state_t *state, double x,
+                                double y) {
+  for (size_t i = 0; i < list_size(cache->buttons); i++) {
+    asset_on_button_click(list_get(cache->buttons, i), state, x, y);
   }
 }
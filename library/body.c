@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -13,41 +14,123 @@ struct body {
   vector_t force;
   vector_t impulse;
   bool removed;
+  bool kinematic;
   double rotation;
 
+  collider_type_t collider;
+  double collider_radius;
+  track_t *track;
+  vector_t track_origin;
+
   void *info;
   free_func_t info_freer;
+  bool in_arena; // whether the body and its polygon belong to an arena
 };
 
-body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
-                            void *info, free_func_t info_freer) {
+/**
+ * Allocates a body around its polygon, from an arena or from malloc if it is
+ * NULL. The polygon must come from the same place.
+ */
+static body_t *body_init_around(arena_t *arena, polygon_t *poly, double mass,
+                                void *info, free_func_t info_freer) {
   assert(mass >= 0);
-  body_t *body = malloc(sizeof(body_t));
-  assert(body != NULL);
-  body->poly = polygon_init(shape, VEC_ZERO, 0, color.r, color.g, color.b);
+  body_t *body;
+  if (arena != NULL) {
+    body = arena_alloc(arena, sizeof(body_t));
+  } else {
+    body = malloc(sizeof(body_t));
+    assert(body != NULL);
+  }
+  body->poly = poly;
   body->mass = mass;
   body->force = VEC_ZERO;
   body->impulse = VEC_ZERO;
   body->removed = false;
+  body->kinematic = false;
   body->rotation = 0;
+  body->collider = COLLIDER_POLYGON;
+  body->collider_radius = 0;
+  body->track = NULL;
+  body->track_origin = VEC_ZERO;
   body->info = info;
   body->info_freer = info_freer;
+  body->in_arena = arena != NULL;
+  return body;
+}
+
+body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
+                            void *info, free_func_t info_freer) {
+  polygon_t *poly = polygon_init(shape, VEC_ZERO, 0, color.r, color.g, color.b);
+  return body_init_around(NULL, poly, mass, info, info_freer);
+}
+
+body_t *body_init_in_arena(arena_t *arena, list_t *shape, double mass,
+                           rgb_color_t color, void *info,
+                           free_func_t info_freer) {
+  polygon_t *poly = polygon_init_in_arena(arena, shape, VEC_ZERO, 0, color.r,
+                                          color.g, color.b);
+  return body_init_around(arena, poly, mass, info, info_freer);
+}
+
+body_t *body_init_span(arena_t *arena, vertex_span_t shape, double mass,
+                       rgb_color_t color, void *info, free_func_t info_freer) {
+  polygon_t *poly = polygon_init_span(arena, shape, color);
+  return body_init_around(arena, poly, mass, info, info_freer);
+}
+
+body_t *body_init_rect(arena_t *arena, vector_t center, double w, double h,
+                       double mass, rgb_color_t color, void *info,
+                       free_func_t info_freer) {
+  polygon_t *poly = polygon_init_rect(arena, center, w, h, color);
+  return body_init_around(arena, poly, mass, info, info_freer);
+}
+
+body_t *body_init_track_walls(track_t *track, double radius,
+                              rgb_color_t color) {
+  assert(radius >= 0);
+  vector_t min, max;
+  track_get_background_bounds(track, &min, &max);
+  vector_t size = vec_subtract(max, min);
+  body_t *body = body_init_rect(NULL, vec_multiply(0.5, vec_add(min, max)),
+                                size.x, size.y, INFINITY, color, NULL, NULL);
+  body->collider = COLLIDER_TRACK_WALLS;
+  body->collider_radius = radius;
+  body->track = track;
+  body->track_origin = body_get_centroid(body);
   return body;
 }
 
 polygon_t *body_get_polygon(body_t *body) { return body->poly; }
 
+collider_type_t body_get_collider_type(body_t *body) { return body->collider; }
+
+double body_get_collider_radius(body_t *body) { return body->collider_radius; }
+
+track_t *body_get_track(body_t *body) {
+  assert(body->collider == COLLIDER_TRACK_WALLS);
+  return body->track;
+}
+
+vector_t body_get_track_offset(body_t *body) {
+  assert(body->collider == COLLIDER_TRACK_WALLS);
+  return vec_subtract(body_get_centroid(body), body->track_origin);
+}
+
+void body_set_circle_collider(body_t *body, double radius) {
+  assert(radius > 0);
+  body->collider = COLLIDER_CIRCLE;
+  body->collider_radius = radius;
+}
+
 void *body_get_info(body_t *body) { return body->info; }
 
 list_t *body_get_shape(body_t *body) {
-  list_t *points = polygon_get_points(body->poly);
-  list_t *shape = list_init(list_size(points), free);
-  for (size_t i = 0; i < list_size(points); i++) {
-    vector_t *point = list_get(points, i);
+  vertex_span_t points = polygon_get_vertices(body->poly);
+  list_t *shape = list_init(points.size, free);
+  for (size_t i = 0; i < points.size; i++) {
     vector_t *copy = malloc(sizeof(vector_t));
     assert(copy != NULL);
-    copy->x = point->x;
-    copy->y = point->y;
+    *copy = points.data[i];
     list_add(shape, copy);
   }
   return shape;
@@ -89,11 +172,13 @@ void body_set_rotation(body_t *body, double angle) {
 }
 
 void body_free(body_t *body) {
-  polygon_free(body->poly);
   if (body->info_freer != NULL) {
     body->info_freer(body->info);
   }
-  free(body);
+  if (!body->in_arena) {
+    polygon_free(body->poly);
+    free(body);
+  }
 }
 
 body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
@@ -101,6 +186,10 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
 }
 
 void body_tick(body_t *body, double dt) {
+  if (body->kinematic) {
+    body_reset(body);
+    return;
+  }
   vector_t old_vel = body_get_velocity(body);
   vector_t dv1 = vec_multiply(dt / body->mass, body->force);
   vector_t dv2 = vec_multiply(1 / body->mass, body->impulse);
@@ -124,6 +213,12 @@ void body_add_impulse(body_t *body, vector_t impulse) {
   body->impulse = vec_add(impulse, body->impulse);
 }
 
+void body_set_kinematic(body_t *body, bool kinematic) {
+  body->kinematic = kinematic;
+}
+
+bool body_is_kinematic(body_t *body) { return body->kinematic; }
+
 void body_remove(body_t *body) { body->removed = true; }
 
 bool body_is_removed(body_t *body) { return body->removed; }
@@ -1,7 +1,9 @@
 #include "car.h"
 #include "asset.h"
+#include "asset_cache.h"
 #include "body.h"
 #include "checkpoints.h"
+#include "forces.h"
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
@@ -17,7 +19,6 @@ const double MINI_AI_WIDTH = 23.0;
 const double MINI_AI_HEIGHT = 30.0;
 const double MINI_GHOST_WIDTH = 25.0;
 const double MINI_GHOST_HEIGHT = 25.0;
-const double MINI_CAR_MASS = 0.0;
 
 const char *F1_IMG = "assets/f1_car.png";
 const char *GOLF_CART_IMG = "assets/golf_cart.png";
@@ -63,7 +64,12 @@ car_info_t *make_car_info(car_type_t type, double friction, double top_speed,
   info->top_speed = top_speed;
   info->acceleration = acceleration;
   info->laps_done = 0;
-  info->power_up_state = (power_up_info_t){0, 0, 0, 0, 0};
+  info->power_up_state = (power_up_info_t){.power_up = NONE,
+                                           .immune_until = -INFINITY,
+                                           .stun_until = -INFINITY,
+                                           .reverse_until = -INFINITY,
+                                           .fast_until = -INFINITY,
+                                           .shell = {0}};
   info->checkpoint_state = NULL;
   return info;
 }
@@ -173,6 +179,22 @@ bool check_in_bounds(vector_t car_cent, vector_t in_1, vector_t in_2,
          y_min <= car_cent_rot.y && car_cent_rot.y <= y_max;
 }
 
+/**
+ * Passes a checkpoint collision on to the checkpoint state of the car.
+ */
+static void car_checkpoint_collision(body_t *car, body_t *checkpoint,
+                                     vector_t axis, void *aux,
+                                     double force_const) {
+  checkpoint_collision(car, checkpoint, axis, car_get_checkpoint_state(car),
+                       force_const);
+}
+
+void create_checkpoint_collisions(scene_t *scene, list_t *cars,
+                                  list_t *checkpoints) {
+  create_group_collision(scene, cars, checkpoints, car_checkpoint_collision,
+                         NULL, 0);
+}
+
 void car_respawn(body_t *car) {
   checkpoint_state_t *checkpoint_state = car_get_checkpoint_state(car);
   list_t *checkpoints = get_checkpoints(checkpoint_state);
@@ -180,13 +202,13 @@ void car_respawn(body_t *car) {
   size_t next = (curr + 1) % list_size(checkpoints);
   body_t *cpoint_1 = list_get(checkpoints, curr);
   body_t *cpoint_2 = list_get(checkpoints, next);
-  list_t *points_1 = polygon_get_points(body_get_polygon(cpoint_1));
-  list_t *points_2 = polygon_get_points(body_get_polygon(cpoint_2));
+  vertex_span_t points_1 = polygon_get_vertices(body_get_polygon(cpoint_1));
+  vertex_span_t points_2 = polygon_get_vertices(body_get_polygon(cpoint_2));
   vector_t car_cent = body_get_centroid(car);
-  vector_t in_1 = *(vector_t *)list_get(points_1, 0);
-  vector_t out_1 = *(vector_t *)list_get(points_1, 1);
-  vector_t in_2 = *(vector_t *)list_get(points_2, 0);
-  vector_t out_2 = *(vector_t *)list_get(points_2, 1);
+  vector_t in_1 = points_1.data[0];
+  vector_t out_1 = points_1.data[1];
+  vector_t in_2 = points_2.data[0];
+  vector_t out_2 = points_2.data[1];
   vector_t turn_direction = get_right_way(checkpoint_state);
   if (get_wrong_way(car, checkpoint_state) &&
       get_wrong_way_time(checkpoint_state) < WRONG_WAY_TIME_TOL) {
@@ -200,9 +222,7 @@ void car_respawn(body_t *car) {
     theta = theta + atan2(turn_direction.y, turn_direction.x) -
             atan2(car_dir.y, car_dir.x);
     body_set_rotation(car, theta);
-    body_set_centroid(
-        car, vec_multiply(0.5, vec_add(*(vector_t *)list_get(points_1, 1),
-                                       *(vector_t *)list_get(points_1, 0))));
+    body_set_centroid(car, vec_multiply(0.5, vec_add(out_1, in_1)));
   }
   if (get_wrong_way_time(checkpoint_state) >= WRONG_WAY_TIME_TOL) {
     printf("Stay On Track!!\n");
@@ -212,13 +232,11 @@ void car_respawn(body_t *car) {
     theta = theta + atan2(turn_direction.y, turn_direction.x) -
             atan2(car_dir.y, car_dir.x);
     body_set_rotation(car, theta);
-    body_set_centroid(
-        car, vec_multiply(0.5, vec_add(*(vector_t *)list_get(points_1, 1),
-                                       *(vector_t *)list_get(points_1, 0))));
+    body_set_centroid(car, vec_multiply(0.5, vec_add(out_1, in_1)));
   }
 }
 
-body_t *make_car(car_type_t type) {
+body_t *make_car(arena_t *arena, car_type_t type) {
   double mass = 0.0;
   double friction = 0.0;
   double acceleration = 0.0;
@@ -246,10 +264,9 @@ body_t *make_car(car_type_t type) {
     assert(false && "Invalid Car Type");
     break;
   }
-  list_t *shape = make_rectangle(VEC_ZERO, CAR_WIDTH, CAR_HEIGHT);
   car_info_t *info = make_car_info(type, friction, top_speed, acceleration);
-  body_t *car = body_init_with_info(shape, mass, get_blue(), info,
-                                    (free_func_t)free_car_info);
+  body_t *car = body_init_rect(arena, VEC_ZERO, CAR_WIDTH, CAR_HEIGHT, mass,
+                               get_blue(), info, (free_func_t)free_car_info);
   return car;
 }
 
@@ -266,36 +283,35 @@ const char *get_car_img_path(car_type_t type) {
   }
 }
 
-asset_t *make_car_image(body_t *car) {
+asset_t *make_car_image(asset_cache_t *cache, body_t *car) {
   const char *path = get_car_img_path(car_get_type(car));
-  return asset_make_rotatable_image_with_body(path, car);
+  return asset_make_rotatable_image_with_body(cache, path, car);
 }
 
-asset_t *make_mini_car(car_type_t car_type) {
+minimap_marker_t make_mini_car_marker(asset_cache_t *cache,
+                                      car_type_t car_type) {
   const char *path = get_car_img_path(car_type);
-  list_t *shape = make_rectangle(VEC_ZERO, MINI_CAR_WIDTH, MINI_CAR_HEIGHT);
-  body_t *mini_car = body_init(shape, MINI_CAR_MASS, get_blue());
-  return asset_make_rotatable_image_with_body(path, mini_car);
+  return (minimap_marker_t){
+      .image = asset_cache_obj_get_or_create(cache, ASSET_IMAGE, path),
+      .size = {.x = MINI_CAR_WIDTH, .y = MINI_CAR_HEIGHT}};
 }
 
-asset_t *make_mini_villain(villain_type_t type) {
+minimap_marker_t make_mini_villain_marker(asset_cache_t *cache,
+                                          villain_type_t type) {
   switch (type) {
   case EASY_AI:
   case MEDIUM_AI:
   case HARD_AI: {
-    list_t *shape = make_rectangle(VEC_ZERO, MINI_AI_WIDTH, MINI_AI_HEIGHT);
-    body_t *body = body_init(shape, MINI_CAR_MASS, get_blue());
-    return asset_make_rotatable_image_with_body(AI_IMG, body);
-    break;
+    return (minimap_marker_t){
+        .image = asset_cache_obj_get_or_create(cache, ASSET_IMAGE, AI_IMG),
+        .size = {.x = MINI_AI_WIDTH, .y = MINI_AI_HEIGHT}};
   }
   case GHOST: {
-    list_t *shape =
-        make_rectangle(VEC_ZERO, MINI_GHOST_WIDTH, MINI_GHOST_HEIGHT);
-    body_t *body = body_init(shape, MINI_CAR_MASS, get_blue());
-    return asset_make_rotatable_image_with_body(GHOST_IMG, body);
+    return (minimap_marker_t){
+        .image = asset_cache_obj_get_or_create(cache, ASSET_IMAGE, GHOST_IMG),
+        .size = {.x = MINI_GHOST_WIDTH, .y = MINI_GHOST_HEIGHT}};
   }
   default:
-    return NULL;
-    break;
+    return (minimap_marker_t){.image = NULL};
   }
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "checkpoints.h"
 #include "asset.h"
-#include "background.h"
 #include "body.h"
 #include <assert.h>
 #include <math.h>
@@ -30,55 +29,27 @@ typedef struct checkpoint_info {
  * Helper function to make a checkpoint given a vector representing
  * the point on inside wall, on outside wall and the index for the point
  */
-body_t *make_checkpoint(vector_t in_pos, vector_t out_pos, size_t idx) {
-  vector_t *in = malloc(sizeof(vector_t));
-  assert(in != NULL);
-  *in = in_pos;
-
-  vector_t *in_2 = malloc(sizeof(vector_t));
-  assert(in_2 != NULL);
-  *in_2 = vec_add(in_pos, CHECKPOINT_OFF);
-
-  vector_t *out = malloc(sizeof(vector_t));
-  assert(out != NULL);
-  *out = out_pos;
-
-  vector_t *out_2 = malloc(sizeof(vector_t));
-  assert(out_2 != NULL);
-  *out_2 = vec_add(out_pos, CHECKPOINT_OFF);
-
-  list_t *shape = list_init(4, free);
-  list_add(shape, in);
-  list_add(shape, out);
-  list_add(shape, out_2);
-  list_add(shape, in_2);
-
-  checkpoint_info_t *checkpoint_info = malloc(sizeof(checkpoint_info_t));
-  assert(checkpoint_info != NULL);
+body_t *make_checkpoint(arena_t *arena, vector_t in_pos, vector_t out_pos,
+                        size_t idx) {
+  vector_t shape[] = {in_pos, out_pos, vec_add(out_pos, CHECKPOINT_OFF),
+                      vec_add(in_pos, CHECKPOINT_OFF)};
+
+  checkpoint_info_t *checkpoint_info =
+      arena_alloc(arena, sizeof(checkpoint_info_t));
   checkpoint_info->idx = idx;
 
-  return body_init_with_info(shape, CHECKPOINT_MASS, CHECKPOINT_COLOR,
-                             checkpoint_info, free);
+  return body_init_span(arena, (vertex_span_t){.data = shape, .size = 4},
+                        CHECKPOINT_MASS, CHECKPOINT_COLOR, checkpoint_info,
+                        NULL);
 }
 
-list_t *make_checkpoints(list_t *in_wall, list_t *out_wall, vector_t start_i,
-                         vector_t start_o, size_t start_offset) {
-  assert(list_size(in_wall) == list_size(out_wall));
-  list_t *checkpoints = list_init(CHEKCPOINT_FREQ * list_size(in_wall),
+list_t *make_checkpoints(arena_t *arena, const track_gate_t *gates,
+                         size_t num_gates) {
+  list_t *checkpoints = list_init(CHEKCPOINT_FREQ * num_gates,
                                   NULL); // will be cleared in scene free
-
-  body_t *start = make_checkpoint(start_i, start_o, 0);
-  list_add(checkpoints, start);
-  size_t no_walls = list_size(in_wall);
-  size_t idx = 1;
-
-  for (size_t i = start_offset; i < no_walls + start_offset; i++, idx++) {
-    vector_t in = *(vector_t *)list_get(in_wall, i % no_walls);
-    vector_t out = *(vector_t *)list_get(out_wall, i % no_walls);
-    body_t *checkpoint = make_checkpoint(in, out, idx);
-    list_add(checkpoints, checkpoint);
+  for (size_t i = 0; i < num_gates; i++) {
+    list_add(checkpoints, make_checkpoint(arena, gates[i].in, gates[i].out, i));
   }
-
   return checkpoints;
 }
 
@@ -96,14 +67,12 @@ vector_t get_direction_vector(list_t *checkpoints, size_t idx1, size_t idx2) {
   idx2 = idx2 % list_size(checkpoints);
   body_t *cpoint_1 = list_get(checkpoints, idx1);
   body_t *cpoint_2 = list_get(checkpoints, idx2);
-  list_t *points_1 = polygon_get_points(body_get_polygon(cpoint_1));
-  list_t *points_2 = polygon_get_points(body_get_polygon(cpoint_2));
+  vertex_span_t points_1 = polygon_get_vertices(body_get_polygon(cpoint_1));
+  vertex_span_t points_2 = polygon_get_vertices(body_get_polygon(cpoint_2));
   vector_t vec_1_cent =
-      vec_multiply(0.5, vec_add(*(vector_t *)list_get(points_1, 0),
-                                *(vector_t *)list_get(points_1, 1)));
+      vec_multiply(0.5, vec_add(points_1.data[0], points_1.data[1]));
   vector_t vec_2_cent =
-      vec_multiply(0.5, vec_add(*(vector_t *)list_get(points_2, 0),
-                                *(vector_t *)list_get(points_2, 1)));
+      vec_multiply(0.5, vec_add(points_2.data[0], points_2.data[1]));
 
   vector_t way = vec_subtract(vec_2_cent, vec_1_cent);
   return vec_multiply(1 / vec_get_length(way), way);
@@ -129,7 +98,6 @@ void reset_checkpoint_state(checkpoint_state_t *checkpoint_state) {
 }
 
 void checkpoint_state_free(checkpoint_state_t *checkpoint_state) {
-  list_free(checkpoint_state->checkpoints);
   free(checkpoint_state);
 }
 
@@ -169,13 +137,12 @@ vector_t get_right_way(checkpoint_state_t *checkpoint_state) {
 
 vector_t get_right_way_from_position(checkpoint_state_t *checkpoint_state,
                                      body_t *car) {
-  list_t *next_points = polygon_get_points(
+  vertex_span_t next_points = polygon_get_vertices(
       body_get_polygon(list_get(checkpoint_state->checkpoints,
                                 (checkpoint_state->current + 1) %
                                     list_size(checkpoint_state->checkpoints))));
   vector_t next_p =
-      vec_multiply(0.5, vec_add(*(vector_t *)list_get(next_points, 0),
-                                *(vector_t *)list_get(next_points, 1)));
+      vec_multiply(0.5, vec_add(next_points.data[0], next_points.data[1]));
 
   vector_t right_way = vec_subtract(next_p, body_get_centroid(car));
   double magnitude = vec_get_length(right_way);
@@ -5,42 +5,21 @@
 #include <math.h>
 #include <stdlib.h>
 
-/**
- * Returns a list of vectors representing the edges of a shape.
- *
- * @param shape the list of vectors representing the vertices of a shape
- * @return a list of vectors representing the edges of the shape
- */
-static list_t *get_edges(list_t *shape) {
-  list_t *edges = list_init(list_size(shape), free);
-
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t *vec = malloc(sizeof(vector_t));
-    assert(vec);
-    *vec =
-        vec_subtract(*(vector_t *)list_get(shape, i % list_size(shape)),
-                     *(vector_t *)list_get(shape, (i + 1) % list_size(shape)));
-    list_add(edges, vec);
-  }
-
-  return edges;
-}
-
 /**
  * Returns a vector containing the maximum and minimum length projections given
  * a unit axis and shape.
  *
- * @param shape the list of vectors representing the vertices of a shape
+ * @param shape the vertices of a shape
  * @param unit_axis the unit axis to project eeach vertex on
  * @return a vector in the form (max, min) where `max` is the maximum projection
  * length and `min` is the minimum projection length.
  */
-static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
+static vector_t get_max_min_projections(vertex_span_t shape,
+                                        vector_t unit_axis) {
   double min = __DBL_MAX__;
   double max = -__DBL_MAX__;
-  for (size_t i = 0; i < list_size(shape); i++) {
-    vector_t *vertex = list_get(shape, i);
-    double proj = vec_dot(*vertex, unit_axis);
+  for (size_t i = 0; i < shape.size; i++) {
+    double proj = vec_dot(shape.data[i], unit_axis);
     if (proj < min) {
       min = proj;
     }
@@ -54,7 +33,7 @@ static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
 
 /**
  * Determines whether two convex polygons intersect.
- * The polygons are given as lists of vertices in counterclockwise order.
+ * The polygons are given as their vertices in counterclockwise order.
  * There is an edge between each pair of consecutive vertices,
  * and one between the first vertex and the last vertex.
  *
@@ -62,18 +41,19 @@ static vector_t get_max_min_projections(list_t *shape, vector_t unit_axis) {
  * @param shape2 the second shape
  * @return whether the shapes are colliding
  */
-static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
+static collision_info_t compare_collision(vertex_span_t shape1,
+                                          vertex_span_t shape2,
                                           double *min_overlap) {
-  list_t *edges1 = get_edges(shape1);
   collision_info_t collision = {.axis = VEC_ZERO, .collided = false};
-  for (size_t i = 0; i < list_size(edges1); i++) {
-    vector_t *sep_axis = list_get(edges1, i);
-    vector_t perp_axis = {.x = -1 * sep_axis->y, .y = sep_axis->x};
+  size_t n = shape1.size;
+  for (size_t i = 0; i < n; i++) {
+    vector_t sep_axis =
+        vec_subtract(shape1.data[i], shape1.data[i + 1 < n ? i + 1 : 0]);
+    vector_t perp_axis = {.x = -1 * sep_axis.y, .y = sep_axis.x};
     vector_t unit_axis = vec_multiply(1 / vec_get_length(perp_axis), perp_axis);
     vector_t proj_1 = get_max_min_projections(shape1, unit_axis);
     vector_t proj_2 = get_max_min_projections(shape2, unit_axis);
     if (proj_2.y >= proj_1.x || proj_2.x <= proj_1.y) {
-      list_free(edges1);
       return collision;
     } else {
       double overlap = fmin(proj_1.x, proj_2.x) - fmax(proj_1.y, proj_2.y);
@@ -85,14 +65,308 @@ static collision_info_t compare_collision(list_t *shape1, list_t *shape2,
   }
   // If we've reached this point, every pair of projections overlap, and thus
   // the polygons must collide.
-  list_free(edges1);
   collision.collided = true;
   return collision;
 }
 
-collision_info_t find_collision(body_t *body1, body_t *body2) {
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
+/**
+ * Projects a capsule onto `unit_axis` and, if it overlaps the projection of
+ * `shape`, records the overlap if it is the smallest seen so far.
+ * The recorded axis is flipped if needed to point from the shape towards the
+ * capsule.
+ *
+ * @return whether the projections overlap
+ */
+static bool overlaps_on_axis(vertex_span_t shape, vector_t a, vector_t b,
+                             double radius, vector_t unit_axis,
+                             double *min_overlap, vector_t *axis) {
+  vector_t proj_1 = get_max_min_projections(shape, unit_axis);
+  double proj_a = vec_dot(a, unit_axis);
+  double proj_b = vec_dot(b, unit_axis);
+  vector_t proj_2 = {.x = fmax(proj_a, proj_b) + radius,
+                     .y = fmin(proj_a, proj_b) - radius};
+  if (proj_2.y >= proj_1.x || proj_2.x <= proj_1.y) {
+    return false;
+  }
+  // How far the shape would have to move back or forward to separate. A thin
+  // segment can end up deep inside the shape, so this is not the width of the
+  // intersection of the projections.
+  double back = proj_1.x - proj_2.y;
+  double forward = proj_2.x - proj_1.y;
+  double overlap = fmin(back, forward);
+  if (overlap < *min_overlap) {
+    *min_overlap = overlap;
+    *axis = back <= forward ? unit_axis : vec_negate(unit_axis);
+  }
+  return true;
+}
+
+/**
+ * Returns the vertex of `shape` closest to `point`.
+ */
+static vector_t closest_vertex(vertex_span_t shape, vector_t point) {
+  vector_t closest = shape.data[0];
+  double min_dist = __DBL_MAX__;
+  for (size_t i = 0; i < shape.size; i++) {
+    double dist = vec_get_length(vec_subtract(shape.data[i], point));
+    if (dist < min_dist) {
+      min_dist = dist;
+      closest = shape.data[i];
+    }
+  }
+  return closest;
+}
+
+/**
+ * Returns the point on the segment from `a` to `b` closest to `point`.
+ */
+static vector_t closest_on_segment(vector_t a, vector_t b, vector_t point) {
+  vector_t ab = vec_subtract(b, a);
+  double len_sq = vec_dot(ab, ab);
+  if (len_sq == 0) {
+    return a;
+  }
+  double t = vec_dot(vec_subtract(point, a), ab) / len_sq;
+  return vec_add(a, vec_multiply(fmin(fmax(t, 0), 1), ab));
+}
+
+collision_info_t find_collision_polygon_segment(vertex_span_t shape,
+                                                vector_t a, vector_t b,
+                                                double radius, double *depth) {
+  collision_info_t collision = {.axis = VEC_ZERO, .collided = false};
+  double min_overlap = __DBL_MAX__;
+  size_t n = shape.size;
+  for (size_t i = 0; i < n; i++) {
+    vector_t edge =
+        vec_subtract(shape.data[i + 1 < n ? i + 1 : 0], shape.data[i]);
+    vector_t perp_axis = {.x = -edge.y, .y = edge.x};
+    vector_t unit_axis = vec_multiply(1 / vec_get_length(perp_axis), perp_axis);
+    if (!overlaps_on_axis(shape, a, b, radius, unit_axis, &min_overlap,
+                          &collision.axis)) {
+      return collision;
+    }
+  }
+  // The segment's own normal, and for the rounded ends of a capsule, the axes
+  // from each end to the nearest vertex.
+  vector_t candidates[3];
+  size_t num_candidates = 0;
+  vector_t ab = vec_subtract(b, a);
+  if (ab.x != 0 || ab.y != 0) {
+    candidates[num_candidates++] = (vector_t){.x = -ab.y, .y = ab.x};
+  }
+  if (radius > 0) {
+    candidates[num_candidates++] = vec_subtract(a, closest_vertex(shape, a));
+    candidates[num_candidates++] = vec_subtract(b, closest_vertex(shape, b));
+  }
+  for (size_t i = 0; i < num_candidates; i++) {
+    double length = vec_get_length(candidates[i]);
+    if (length == 0) {
+      continue;
+    }
+    vector_t unit_axis = vec_multiply(1 / length, candidates[i]);
+    if (!overlaps_on_axis(shape, a, b, radius, unit_axis, &min_overlap,
+                          &collision.axis)) {
+      return collision;
+    }
+  }
+  collision.collided = true;
+  if (depth != NULL) {
+    *depth = min_overlap;
+  }
+  return collision;
+}
+
+collision_info_t find_collision_circle_segment(vector_t center,
+                                               double circle_radius, vector_t a,
+                                               vector_t b, double radius,
+                                               double *depth) {
+  collision_info_t collision = {.axis = VEC_ZERO, .collided = false};
+  vector_t closest = closest_on_segment(a, b, center);
+  vector_t to_segment = vec_subtract(closest, center);
+  double dist = vec_get_length(to_segment);
+  if (dist >= circle_radius + radius) {
+    return collision;
+  }
+  collision.collided = true;
+  if (dist > 0) {
+    collision.axis = vec_multiply(1 / dist, to_segment);
+  } else {
+    // The center is on the segment, so any normal will do.
+    vector_t ab = vec_subtract(b, a);
+    double length = vec_get_length(ab);
+    collision.axis = length > 0 ? (vector_t){.x = -ab.y / length,
+                                             .y = ab.x / length}
+                                : (vector_t){.x = 1, .y = 0};
+  }
+  if (depth != NULL) {
+    *depth = circle_radius + radius - dist;
+  }
+  return collision;
+}
+
+/**
+ * Casts a ray at a circle, only counting hits from outside of the circle.
+ */
+static bool raycast_circle(vector_t origin, vector_t direction,
+                           double max_distance, vector_t center, double radius,
+                           double *distance, vector_t *normal) {
+  vector_t relative = vec_subtract(origin, center);
+  double b = vec_dot(relative, direction);
+  double c = vec_dot(relative, relative) - radius * radius;
+  double discriminant = b * b - c;
+  if (radius <= 0 || c < 0 || discriminant < 0) {
+    return false;
+  }
+  double t = -b - sqrt(discriminant);
+  if (t < 0 || t > max_distance) {
+    return false;
+  }
+  *distance = t;
+  vector_t hit = vec_add(origin, vec_multiply(t, direction));
+  *normal = vec_multiply(1 / radius, vec_subtract(hit, center));
+  return true;
+}
+
+bool raycast_segment(vector_t origin, vector_t direction, double max_distance,
+                     vector_t a, vector_t b, double radius, double *distance,
+                     vector_t *normal) {
+  bool hit = false;
+  double best = max_distance;
+  vector_t ab = vec_subtract(b, a);
+  double length = vec_get_length(ab);
+  if (length > 0) {
+    // The flat side of the capsule facing the ray
+    vector_t side = {-ab.y / length, ab.x / length};
+    double denom = vec_dot(direction, side);
+    if (denom > 0) {
+      side = vec_negate(side);
+      denom = -denom;
+    }
+    if (denom < 0) {
+      vector_t on_side = vec_add(a, vec_multiply(radius, side));
+      double t = vec_dot(vec_subtract(on_side, origin), side) / denom;
+      vector_t point = vec_add(origin, vec_multiply(t, direction));
+      double along = vec_dot(vec_subtract(point, on_side), ab) / length;
+      if (t >= 0 && t <= best && along >= 0 && along <= length) {
+        hit = true;
+        best = t;
+        *normal = side;
+      }
+    }
+  }
+  // The rounded ends
+  double t;
+  vector_t end_normal;
+  vector_t ends[] = {a, b};
+  for (size_t i = 0; i < (length > 0 ? 2 : 1); i++) {
+    if (raycast_circle(origin, direction, best, ends[i], radius, &t,
+                       &end_normal)) {
+      hit = true;
+      best = t;
+      *normal = end_normal;
+    }
+  }
+  if (hit) {
+    *distance = best;
+  }
+  return hit;
+}
+
+size_t find_wall_collisions(body_t *body, body_t *walls,
+                            wall_collision_t collisions[WALL_COLLISIONS_MAX]) {
+  track_t *track = body_get_track(walls);
+  vector_t offset = body_get_track_offset(walls);
+  double wall_radius = body_get_collider_radius(walls);
+  bool is_circle = body_get_collider_type(body) == COLLIDER_CIRCLE;
+  double body_radius = body_get_collider_radius(body);
+  vector_t center = body_get_centroid(body);
+  vertex_span_t points = polygon_get_vertices(body_get_polygon(body));
+
+  vector_t min, max;
+  if (is_circle) {
+    min = vec_subtract(center, (vector_t){body_radius, body_radius});
+    max = vec_add(center, (vector_t){body_radius, body_radius});
+  } else {
+    polygon_get_bounds(body_get_polygon(body), &min, &max);
+  }
+  vector_t margin = {wall_radius, wall_radius};
+  min = vec_subtract(vec_subtract(min, offset), margin);
+  max = vec_add(vec_subtract(max, offset), margin);
+  size_t lo[2], hi[2];
+  if (!track_get_cell_range(track, min, max, lo, hi)) {
+    return 0;
+  }
+
+  size_t num_walls;
+  const track_wall_t *track_walls = track_get_walls(track, &num_walls);
+  size_t num_collisions = 0;
+  for (size_t row = lo[1]; row <= hi[1]; row++) {
+    for (size_t col = lo[0]; col <= hi[0]; col++) {
+      size_t count;
+      const uint32_t *cell = track_get_cell_walls(track, col, row, &count);
+      for (size_t i = 0; i < count; i++) {
+        const track_wall_t *wall = &track_walls[cell[i]];
+        vector_t a = vec_add(wall->a, offset);
+        vector_t b = vec_add(wall->b, offset);
+        double depth;
+        collision_info_t hit =
+            is_circle ? find_collision_circle_segment(center, body_radius, a, b,
+                                                      wall_radius, &depth)
+                      : find_collision_polygon_segment(points, a, b,
+                                                       wall_radius, &depth);
+        if (!hit.collided) {
+          continue;
+        }
+        // A wall crossing several cells is found in each of them
+        bool is_found = false;
+        size_t shallowest = 0;
+        for (size_t j = 0; j < num_collisions; j++) {
+          is_found = is_found || collisions[j].wall == cell[i];
+          if (collisions[j].depth < collisions[shallowest].depth) {
+            shallowest = j;
+          }
+        }
+        if (is_found) {
+          continue;
+        }
+        wall_collision_t collision = {
+            .wall = cell[i], .axis = vec_negate(wall->normal), .depth = depth};
+        if (num_collisions < WALL_COLLISIONS_MAX) {
+          collisions[num_collisions++] = collision;
+        } else if (collisions[shallowest].depth < depth) {
+          collisions[shallowest] = collision;
+        }
+      }
+    }
+  }
+  return num_collisions;
+}
+
+/**
+ * Finds the deepest collision between a polygon or circle body and a track
+ * wall body.
+ */
+static collision_info_t find_collision_walls(body_t *body, body_t *walls) {
+  collision_info_t collision = {.axis = VEC_ZERO, .collided = false};
+  wall_collision_t collisions[WALL_COLLISIONS_MAX];
+  size_t count = find_wall_collisions(body, walls, collisions);
+  double max_depth = -__DBL_MAX__;
+  for (size_t i = 0; i < count; i++) {
+    if (collisions[i].depth > max_depth) {
+      max_depth = collisions[i].depth;
+      collision.collided = true;
+      collision.axis = collisions[i].axis;
+    }
+  }
+  return collision;
+}
+
+/**
+ * Computes the collision between two polygon colliders.
+ */
+static collision_info_t find_collision_polygons(body_t *body1, body_t *body2) {
+  vertex_span_t shape1 = polygon_get_vertices(body_get_polygon(body1));
+  vertex_span_t shape2 = polygon_get_vertices(body_get_polygon(body2));
 
   double c1_overlap = __DBL_MAX__;
   double c2_overlap = __DBL_MAX__;
@@ -100,9 +374,6 @@ collision_info_t find_collision(body_t *body1, body_t *body2) {
   collision_info_t collision1 = compare_collision(shape1, shape2, &c1_overlap);
   collision_info_t collision2 = compare_collision(shape2, shape1, &c2_overlap);
 
-  list_free(shape1);
-  list_free(shape2);
-
   if (!collision1.collided) {
     return collision1;
   }
@@ -116,3 +387,31 @@ collision_info_t find_collision(body_t *body1, body_t *body2) {
   }
   return collision2;
 }
+
+collision_info_t find_collision(body_t *body1, body_t *body2) {
+  collider_type_t type1 = body_get_collider_type(body1);
+  collider_type_t type2 = body_get_collider_type(body2);
+  // Only handle each unordered pair of collider types once.
+  if (type1 > type2) {
+    collision_info_t collision = find_collision(body2, body1);
+    collision.axis = vec_negate(collision.axis);
+    return collision;
+  }
+  assert(type1 != COLLIDER_TRACK_WALLS);
+  if (type2 == COLLIDER_TRACK_WALLS) {
+    return find_collision_walls(body1, body2);
+  }
+  if (type2 == COLLIDER_POLYGON) {
+    return find_collision_polygons(body1, body2);
+  }
+  vector_t center2 = body_get_centroid(body2);
+  double radius2 = body_get_collider_radius(body2);
+  if (type1 == COLLIDER_POLYGON) {
+    return find_collision_polygon_segment(
+        polygon_get_vertices(body_get_polygon(body1)), center2, center2,
+        radius2, NULL);
+  }
+  return find_collision_circle_segment(body_get_centroid(body1),
+                                       body_get_collider_radius(body1), center2,
+                                       center2, radius2, NULL);
+}
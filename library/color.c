@@ -21,14 +21,10 @@ rgb_color_t *color_init(double red, double green, double blue) {
   return color;
 }
 
-rgb_color_t *color_get_random() {
-  double r = (double)rand();
-  double g = (double)rand();
-  double b = (double)rand();
-
-  r = fmod(r, COLOR_MAX) / COLOR_MAX;
-  g = fmod(g, COLOR_MAX) / COLOR_MAX;
-  b = fmod(b, COLOR_MAX) / COLOR_MAX;
+rgb_color_t *color_get_random(rng_t *rng) {
+  double r = rng_below(rng, COLOR_MAX) / COLOR_MAX;
+  double g = rng_below(rng, COLOR_MAX) / COLOR_MAX;
+  double b = rng_below(rng, COLOR_MAX) / COLOR_MAX;
 
   r = (r + WHITE_MIX) / 2;
   g = (g + WHITE_MIX) / 2;
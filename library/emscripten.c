@@ -9,18 +9,23 @@
 #include <emscripten.h>
 #endif
 
-state_t *state;
-
-void loop() {
+/**
+ * Runs one frame of the demo.
+ *
+ * @param arg where the demo's state is kept between frames (a state_t **)
+ */
+void loop(void *arg) {
+  state_t **state_ptr = arg;
   // If needed, generate a pointer to our initial state
-  if (!state) {
-    state = emscripten_init();
+  if (!*state_ptr) {
+    *state_ptr = emscripten_init();
   }
+  state_t *state = *state_ptr;
 
   bool game_over = emscripten_main(state);
 
-  if (sdl_is_done((void *)state)) { // Once our demo exits...
-    emscripten_free(state);         // Free any state variables we've been using
+  if (sdl_is_done(emscripten_get_sdl(state), state)) { // Once our demo exits...
+    emscripten_free(state); // Free any state variables we've been using
 #ifdef __EMSCRIPTEN__ // Clean up emscripten environment (if we're using it)
     emscripten_cancel_main_loop();
     emscripten_force_exit(0);
@@ -34,12 +39,13 @@ void loop() {
 }
 
 int main() {
+  state_t *state = NULL;
 #ifdef __EMSCRIPTEN__
   // Set loop as the function emscripten calls to request a new frame
-  emscripten_set_main_loop_arg(loop, NULL, 0, 1);
+  emscripten_set_main_loop_arg(loop, &state, 0, 1);
 #else
   while (1) {
-    loop();
+    loop(&state);
   }
 #endif
 }
@@ -4,6 +4,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 const double MIN_DIST = 5;
 
@@ -16,19 +17,35 @@ typedef struct force_info {
   void *info;
   force_creator_t force_creator;
   list_t *bodies;
+  free_func_t info_freer;
 } force_info_t;
 
+/**
+ * The start of every collision aux: the force constant and body list that
+ * every aux in this file starts with, then how to forget the contacts of the
+ * body in a slot.
+ */
+struct collision {
+  double force_const;
+  list_t *bodies;
+  void (*reset)(collision_t *collision, size_t slot);
+};
+
 typedef struct collision_aux {
   double force_const;
   list_t *bodies;
+  void (*reset)(collision_t *collision, size_t slot);
   collision_handler_t handler;
   bool collided;
   void *aux; // aux (if allocated in memory) should be free'd by the caller
 } collision_aux_t;
 
-body_aux_t *body_aux_init(double force_const, list_t *bodies) {
-  body_aux_t *aux = malloc(sizeof(body_aux_t));
-  assert(aux);
+/**
+ * Allocates the aux of a force creator from the scene's arena.
+ */
+static body_aux_t *body_aux_init(scene_t *scene, double force_const,
+                                 list_t *bodies) {
+  body_aux_t *aux = arena_alloc(scene_get_arena(scene), sizeof(body_aux_t));
 
   aux->bodies = bodies;
   aux->force_const = force_const;
@@ -36,13 +53,14 @@ body_aux_t *body_aux_init(double force_const, list_t *bodies) {
   return aux;
 }
 
-force_info_t *force_info_init(void *info, force_creator_t force_creator,
-                              list_t *bodies) {
-  force_info_t *f_inf = malloc(sizeof(force_info_t));
-  assert(f_inf != NULL);
+force_info_t *force_info_init(arena_t *arena, void *info,
+                              force_creator_t force_creator, list_t *bodies,
+                              free_func_t info_freer) {
+  force_info_t *f_inf = arena_alloc(arena, sizeof(force_info_t));
   f_inf->force_creator = force_creator;
   f_inf->info = info;
   f_inf->bodies = bodies;
+  f_inf->info_freer = info_freer;
   return f_inf;
 }
 
@@ -51,10 +69,19 @@ void body_aux_free(void *aux) {
   free(aux);
 }
 
+/**
+ * Frees the body list of an aux allocated from a scene's arena. Every aux in
+ * this file starts with a force constant followed by the list.
+ */
+static void arena_aux_free(void *aux) {
+  list_free(((body_aux_t *)aux)->bodies);
+}
+
 void force_info_free(force_info_t *f_inf) {
-  body_aux_free(f_inf->info);
+  if (f_inf->info_freer != NULL) {
+    f_inf->info_freer(f_inf->info);
+  }
   list_free(f_inf->bodies);
-  free(f_inf);
 }
 
 force_creator_t f_info_get_f_creator(force_info_t *f_inf) {
@@ -65,14 +92,28 @@ list_t *f_info_get_bodies(force_info_t *f_inf) { return f_inf->bodies; }
 
 void *f_info_get_aux(force_info_t *f_inf) { return f_inf->info; }
 
-collision_aux_t *collision_aux_init(double force_const, list_t *bodies,
-                                    collision_handler_t handler, bool collided,
-                                    void *aux) {
-  collision_aux_t *collision_aux = malloc(sizeof(collision_aux_t));
-  assert(collision_aux);
+/**
+ * Forgets whether the pair of a collision aux was colliding. Either slot is
+ * the pair.
+ */
+static void pair_collision_reset(collision_t *collision, size_t slot) {
+  assert(slot < 2);
+  ((collision_aux_t *)collision)->collided = false;
+}
+
+/**
+ * Allocates the aux of a collision from the scene's arena.
+ */
+static collision_aux_t *collision_aux_init(scene_t *scene, double force_const,
+                                           list_t *bodies,
+                                           collision_handler_t handler,
+                                           bool collided, void *aux) {
+  collision_aux_t *collision_aux =
+      arena_alloc(scene_get_arena(scene), sizeof(collision_aux_t));
 
   collision_aux->force_const = force_const;
   collision_aux->bodies = bodies;
+  collision_aux->reset = pair_collision_reset;
   collision_aux->handler = handler;
   collision_aux->collided = collided;
   collision_aux->aux = aux;
@@ -116,9 +157,9 @@ void create_newtonian_gravity(scene_t *scene, double G, body_t *body1,
   list_add(bodies, body2);
   list_add(aux_bodies, body1);
   list_add(aux_bodies, body2);
-  body_aux_t *aux = body_aux_init(G, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)newtonian_gravity, aux,
-                                 bodies);
+  body_aux_t *aux = body_aux_init(scene, G, aux_bodies);
+  scene_add_bodies_force_creator_with_freer(
+      scene, (force_creator_t)newtonian_gravity, aux, bodies, arena_aux_free);
 }
 
 /**
@@ -148,9 +189,9 @@ void create_friction_surface(scene_t *scene, double mu, body_t *body1,
   list_add(bodies, surface);
   list_add(aux_bodies, body1);
   list_add(aux_bodies, surface);
-  body_aux_t *aux = body_aux_init(mu, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)friction_surface, aux,
-                                 bodies);
+  body_aux_t *aux = body_aux_init(scene, mu, aux_bodies);
+  scene_add_bodies_force_creator_with_freer(
+      scene, (force_creator_t)friction_surface, aux, bodies, arena_aux_free);
 }
 
 /**
@@ -183,9 +224,9 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
   list_t *aux_bodies = list_init(2, NULL);
   list_add(aux_bodies, body1);
   list_add(aux_bodies, body2);
-  body_aux_t *aux = body_aux_init(k, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)spring_force, aux,
-                                 bodies);
+  body_aux_t *aux = body_aux_init(scene, k, aux_bodies);
+  scene_add_bodies_force_creator_with_freer(
+      scene, (force_creator_t)spring_force, aux, bodies, arena_aux_free);
 }
 
 /**
@@ -208,9 +249,9 @@ void create_drag(scene_t *scene, double gamma, body_t *body) {
   list_t *aux_bodies = list_init(1, NULL);
   list_add(bodies, body);
   list_add(aux_bodies, body);
-  body_aux_t *aux = body_aux_init(gamma, aux_bodies);
-  scene_add_bodies_force_creator(scene, (force_creator_t)drag_force, aux,
-                                 bodies);
+  body_aux_t *aux = body_aux_init(scene, gamma, aux_bodies);
+  scene_add_bodies_force_creator_with_freer(
+      scene, (force_creator_t)drag_force, aux, bodies, arena_aux_free);
 }
 
 /**
@@ -229,7 +270,11 @@ static void collision_force_creator(void *collision_aux) {
   // Check for collision; if bodies collide, call collision_handler
   bool prev_collision = col_aux->collided;
 
-  collision_info_t info = find_collision(body1, body2);
+  // kinematic bodies are moved by their owner and don't collide
+  collision_info_t info = {.collided = false};
+  if (!body_is_kinematic(body1) && !body_is_kinematic(body2)) {
+    info = find_collision(body1, body2);
+  }
   // avoids registering impulse multiple times while bodies are still colliding
   if (info.collided && !prev_collision) {
     collision_handler_t handler = col_aux->handler;
@@ -241,9 +286,101 @@ static void collision_force_creator(void *collision_aux) {
   }
 }
 
-void create_collision(scene_t *scene, body_t *body1, body_t *body2,
-                      collision_handler_t handler, void *aux,
-                      double force_const) {
+/**
+ * The state of a collision with a track walls body. Every wall the other body
+ * touches is a contact of its own, so a body that reaches a second wall while
+ * still touching the first, e.g. in a corner, calls the handler for both.
+ */
+typedef struct wall_collision_aux {
+  double force_const;
+  list_t *bodies;
+  void (*reset)(collision_t *collision, size_t slot);
+  collision_handler_t handler;
+  void *aux;
+  size_t num_contacts;
+  size_t contacts[WALL_COLLISIONS_MAX]; // the walls touched last tick
+} wall_collision_aux_t;
+
+/**
+ * Forgets the walls the body of a walls collision was touching. Either slot
+ * is the pair.
+ */
+static void wall_collision_reset(collision_t *collision, size_t slot) {
+  assert(slot < 2);
+  ((wall_collision_aux_t *)collision)->num_contacts = 0;
+}
+
+/**
+ * The force creator for collisions with a track walls body. Calls the
+ * collision handler once for each wall the other body has just started
+ * touching, with that wall's axis.
+ */
+static void wall_collision_force_creator(void *wall_aux) {
+  wall_collision_aux_t *col_aux = wall_aux;
+  body_t *body1 = list_get(col_aux->bodies, 0);
+  body_t *body2 = list_get(col_aux->bodies, 1);
+  bool walls_first = body_get_collider_type(body1) == COLLIDER_TRACK_WALLS;
+  body_t *body = walls_first ? body2 : body1;
+  body_t *walls = walls_first ? body1 : body2;
+
+  // kinematic bodies are moved by their owner and don't collide
+  wall_collision_t collisions[WALL_COLLISIONS_MAX];
+  size_t count = 0;
+  if (!body_is_kinematic(body)) {
+    count = find_wall_collisions(body, walls, collisions);
+  }
+  for (size_t i = 0; i < count; i++) {
+    bool was_touching = false;
+    for (size_t j = 0; j < col_aux->num_contacts; j++) {
+      was_touching = was_touching || col_aux->contacts[j] == collisions[i].wall;
+    }
+    if (!was_touching) {
+      vector_t axis = collisions[i].axis;
+      col_aux->handler(body1, body2, walls_first ? vec_negate(axis) : axis,
+                       col_aux->aux, col_aux->force_const);
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    col_aux->contacts[i] = collisions[i].wall;
+  }
+  col_aux->num_contacts = count;
+}
+
+/**
+ * Adds a collision between a body and a track walls body, in either order.
+ */
+static collision_t *create_wall_collision(scene_t *scene, body_t *body1,
+                                          body_t *body2,
+                                          collision_handler_t handler,
+                                          void *aux, double force_const) {
+  list_t *bodies = list_init(2, NULL);
+  list_add(bodies, body1);
+  list_add(bodies, body2);
+
+  wall_collision_aux_t *wall_aux =
+      arena_alloc(scene_get_arena(scene), sizeof(wall_collision_aux_t));
+  wall_aux->force_const = force_const;
+  wall_aux->bodies = list_init(2, NULL);
+  list_add(wall_aux->bodies, body1);
+  list_add(wall_aux->bodies, body2);
+  wall_aux->reset = wall_collision_reset;
+  wall_aux->handler = handler;
+  wall_aux->aux = aux;
+  wall_aux->num_contacts = 0;
+
+  scene_add_bodies_force_creator_with_freer(
+      scene, wall_collision_force_creator, wall_aux, bodies, arena_aux_free);
+  return (collision_t *)wall_aux;
+}
+
+collision_t *create_collision(scene_t *scene, body_t *body1, body_t *body2,
+                              collision_handler_t handler, void *aux,
+                              double force_const) {
+  if (body_get_collider_type(body1) == COLLIDER_TRACK_WALLS ||
+      body_get_collider_type(body2) == COLLIDER_TRACK_WALLS) {
+    return create_wall_collision(scene, body1, body2, handler, aux,
+                                 force_const);
+  }
   list_t *bodies = list_init(2, NULL);
   list_add(bodies, body1);
   list_add(bodies, body2);
@@ -253,10 +390,181 @@ void create_collision(scene_t *scene, body_t *body1, body_t *body2,
   list_add(aux_bodies, body2);
 
   collision_aux_t *collision_aux =
-      collision_aux_init(force_const, aux_bodies, handler, false, aux);
+      collision_aux_init(scene, force_const, aux_bodies, handler, false, aux);
+
+  scene_add_bodies_force_creator_with_freer(
+      scene, collision_force_creator, collision_aux, bodies, arena_aux_free);
+  return (collision_t *)collision_aux;
+}
+
+/**
+ * The state of a group collision. The per-body arrays and the pair tables are
+ * allocated from the scene's arena in the same block as the struct.
+ */
+typedef struct group_collision_aux {
+  double force_const;
+  list_t *bodies; // group1 followed by group2
+  void (*reset)(collision_t *collision, size_t slot);
+  collision_handler_t handler;
+  void *aux;
+  size_t num_bodies;
+  size_t num_first; // the number of bodies in group1
+  bool within;      // whether the pairs are within group1
+  size_t *order;    // body indices sorted by the left edge of their bounds
+  vector_t *min;
+  vector_t *max;
+  bool *collided;  // num_bodies * num_bodies, pairs colliding last tick
+  bool *colliding; // the same, for this tick
+} group_collision_aux_t;
+
+/**
+ * Forgets the pairs of a group collision that include the body in a slot.
+ */
+static void group_collision_reset(collision_t *collision, size_t slot) {
+  group_collision_aux_t *group = (group_collision_aux_t *)collision;
+  size_t n = group->num_bodies;
+  assert(slot < n);
+  for (size_t j = 0; j < n; j++) {
+    group->collided[slot * n + j] = false;
+    group->collided[j * n + slot] = false;
+  }
+}
+
+/**
+ * Returns whether bodies i < j of a group collision should be tested.
+ */
+static bool group_pair_valid(group_collision_aux_t *group, size_t i, size_t j) {
+  return group->within || (i < group->num_first && j >= group->num_first);
+}
+
+/**
+ * The force creator for group collisions. Sorts the bodies by their bounding
+ * boxes, sweeps for overlapping pairs and runs the handler on each pair that
+ * has just started colliding.
+ */
+static void group_collision_force_creator(void *group_aux) {
+  group_collision_aux_t *group = group_aux;
+  size_t n = group->num_bodies;
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(group->bodies, i);
+    polygon_get_bounds(body_get_polygon(body), &group->min[i], &group->max[i]);
+  }
+  // The bodies barely move between ticks, so the order from the last tick is
+  // almost sorted and insertion sort runs in close to linear time.
+  for (size_t i = 1; i < n; i++) {
+    size_t idx = group->order[i];
+    size_t j = i;
+    while (j > 0 && group->min[group->order[j - 1]].x > group->min[idx].x) {
+      group->order[j] = group->order[j - 1];
+      j--;
+    }
+    group->order[j] = idx;
+  }
+
+  memset(group->colliding, 0, n * n * sizeof(bool));
+  for (size_t p = 0; p < n; p++) {
+    size_t a = group->order[p];
+    if (body_is_kinematic(list_get(group->bodies, a))) {
+      continue;
+    }
+    for (size_t q = p + 1; q < n; q++) {
+      size_t b = group->order[q];
+      if (group->min[b].x > group->max[a].x) {
+        break;
+      }
+      if (body_is_kinematic(list_get(group->bodies, b)) ||
+          group->min[b].y > group->max[a].y ||
+          group->min[a].y > group->max[b].y) {
+        continue;
+      }
+      size_t i = a < b ? a : b;
+      size_t j = a < b ? b : a;
+      if (!group_pair_valid(group, i, j)) {
+        continue;
+      }
+      body_t *body1 = list_get(group->bodies, i);
+      body_t *body2 = list_get(group->bodies, j);
+      collision_info_t info = find_collision(body1, body2);
+      if (!info.collided) {
+        continue;
+      }
+      group->colliding[i * n + j] = true;
+      // avoids registering impulse multiple times while bodies are still
+      // colliding
+      if (!group->collided[i * n + j]) {
+        group->handler(body1, body2, info.axis, group->aux,
+                       group->force_const);
+      }
+    }
+  }
+  bool *swap = group->collided;
+  group->collided = group->colliding;
+  group->colliding = swap;
+}
+
+collision_t *create_group_collision(scene_t *scene, list_t *group1,
+                                    list_t *group2, collision_handler_t handler,
+                                    void *aux, double force_const) {
+  size_t num_first = list_size(group1);
+  size_t n = num_first + (group2 == NULL ? 0 : list_size(group2));
+  list_t *bodies = list_init(n, NULL);
+  list_t *aux_bodies = list_init(n, NULL);
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = i < num_first ? list_get(group1, i)
+                                 : list_get(group2, i - num_first);
+    assert(body_get_collider_type(body) != COLLIDER_TRACK_WALLS);
+    list_add(bodies, body);
+    list_add(aux_bodies, body);
+  }
+
+  group_collision_aux_t *group =
+      arena_alloc(scene_get_arena(scene),
+                  sizeof(group_collision_aux_t) + n * sizeof(size_t) +
+                      2 * n * sizeof(vector_t) + 2 * n * n * sizeof(bool));
+  group->force_const = force_const;
+  group->bodies = aux_bodies;
+  group->reset = group_collision_reset;
+  group->handler = handler;
+  group->aux = aux;
+  group->num_bodies = n;
+  group->num_first = num_first;
+  group->within = group2 == NULL;
+  // vector_t first, since it has the strictest alignment
+  group->min = (vector_t *)(group + 1);
+  group->max = group->min + n;
+  group->order = (size_t *)(group->max + n);
+  group->collided = (bool *)(group->order + n);
+  group->colliding = group->collided + n * n;
+  for (size_t i = 0; i < n; i++) {
+    group->order[i] = i;
+  }
+  memset(group->collided, 0, n * n * sizeof(bool));
 
-  scene_add_bodies_force_creator(scene, collision_force_creator, collision_aux,
-                                 bodies);
+  scene_add_bodies_force_creator_with_freer(
+      scene, group_collision_force_creator, group, bodies, arena_aux_free);
+  return (collision_t *)group;
+}
+
+void collision_reset(collision_t *collision, size_t slot) {
+  collision->reset(collision, slot);
+}
+
+void reset_collisions(scene_t *scene, body_t *body) {
+  for (size_t i = 0; i < scene_force_creators(scene); i++) {
+    force_info_t *f_inf = scene_get_force_creator(scene, i);
+    force_creator_t forcer = f_info_get_f_creator(f_inf);
+    if (forcer != collision_force_creator &&
+        forcer != wall_collision_force_creator &&
+        forcer != group_collision_force_creator) {
+      continue;
+    }
+    collision_t *collision = f_info_get_aux(f_inf);
+    for (size_t slot = 0; slot < list_size(collision->bodies); slot++) {
+      if (list_get(collision->bodies, slot) == body) {
+        collision_reset(collision, slot);
+      }
+    }
+  }
 }
 
 /**
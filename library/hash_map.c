@@ -0,0 +1,207 @@
+#include "hash_map.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t MIN_SLOTS = 8;
+const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+const uint64_t FNV_PRIME = 0x100000001b3;
+
+/**
+ * A slot of the table. A slot is empty when its value is NULL.
+ */
+typedef struct slot {
+  const void *key;
+  void *value;
+  uint64_t hash;
+} slot_t;
+
+struct hash_map {
+  slot_t *slots;
+  size_t num_slots; // always a power of 2
+  size_t size;
+  hash_func_t hash;
+  equal_func_t equal;
+  free_func_t freer;
+};
+
+struct string_pool {
+  hash_map_t *strings; // each copy maps to itself
+};
+
+uint64_t hash_string(const void *key) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (const unsigned char *c = key; *c != '\0'; c++) {
+    hash = (hash ^ *c) * FNV_PRIME;
+  }
+  return hash;
+}
+
+bool string_equal(const void *key1, const void *key2) {
+  return strcmp(key1, key2) == 0;
+}
+
+uint64_t hash_pointer(const void *key) {
+  // The finalizer of splitmix64, so that aligned addresses spread out
+  uint64_t z = (uintptr_t)key;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+bool pointer_equal(const void *key1, const void *key2) { return key1 == key2; }
+
+/**
+ * Returns the smallest power of 2 number of slots that keeps `size` entries
+ * at most half full.
+ */
+static size_t slots_for(size_t size) {
+  size_t num_slots = MIN_SLOTS;
+  while (num_slots < 2 * size) {
+    num_slots *= 2;
+  }
+  return num_slots;
+}
+
+hash_map_t *hash_map_init(size_t initial_size, hash_func_t hash,
+                          equal_func_t equal, free_func_t freer) {
+  hash_map_t *map = malloc(sizeof(hash_map_t));
+  assert(map != NULL);
+  map->num_slots = slots_for(initial_size);
+  map->slots = calloc(map->num_slots, sizeof(slot_t));
+  assert(map->slots != NULL);
+  map->size = 0;
+  map->hash = hash;
+  map->equal = equal;
+  map->freer = freer;
+  return map;
+}
+
+void hash_map_free(hash_map_t *map) {
+  if (map->freer != NULL) {
+    for (size_t i = 0; i < map->num_slots; i++) {
+      if (map->slots[i].value != NULL) {
+        map->freer(map->slots[i].value);
+      }
+    }
+  }
+  free(map->slots);
+  free(map);
+}
+
+size_t hash_map_size(hash_map_t *map) { return map->size; }
+
+/**
+ * Returns the slot holding a key, or the empty slot where it would go.
+ */
+static slot_t *find_slot(hash_map_t *map, const void *key, uint64_t hash) {
+  size_t mask = map->num_slots - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    slot_t *slot = &map->slots[i];
+    if (slot->value == NULL ||
+        (slot->hash == hash && map->equal(slot->key, key))) {
+      return slot;
+    }
+  }
+}
+
+/**
+ * Doubles the number of slots and reinserts every entry.
+ */
+static void hash_map_grow(hash_map_t *map) {
+  slot_t *old_slots = map->slots;
+  size_t old_num_slots = map->num_slots;
+  map->num_slots *= 2;
+  map->slots = calloc(map->num_slots, sizeof(slot_t));
+  assert(map->slots != NULL);
+  size_t mask = map->num_slots - 1;
+  for (size_t i = 0; i < old_num_slots; i++) {
+    slot_t *old = &old_slots[i];
+    if (old->value == NULL) {
+      continue;
+    }
+    size_t j = old->hash & mask;
+    while (map->slots[j].value != NULL) {
+      j = (j + 1) & mask;
+    }
+    map->slots[j] = *old;
+  }
+  free(old_slots);
+}
+
+void *hash_map_get(hash_map_t *map, const void *key) {
+  return find_slot(map, key, map->hash(key))->value;
+}
+
+void *hash_map_put(hash_map_t *map, const void *key, void *value) {
+  assert(value != NULL);
+  uint64_t hash = map->hash(key);
+  slot_t *slot = find_slot(map, key, hash);
+  void *old = slot->value;
+  if (old == NULL) {
+    if (2 * (map->size + 1) > map->num_slots) {
+      hash_map_grow(map);
+      slot = find_slot(map, key, hash);
+    }
+    map->size++;
+  }
+  *slot = (slot_t){.key = key, .value = value, .hash = hash};
+  return old;
+}
+
+void *hash_map_remove(hash_map_t *map, const void *key) {
+  slot_t *slot = find_slot(map, key, map->hash(key));
+  void *value = slot->value;
+  if (value == NULL) {
+    return NULL;
+  }
+  // Shift later entries of the probe sequence back into the hole, so that
+  // lookups never need to skip over deleted slots
+  size_t mask = map->num_slots - 1;
+  size_t hole = slot - map->slots;
+  for (size_t i = (hole + 1) & mask; map->slots[i].value != NULL;
+       i = (i + 1) & mask) {
+    size_t home = map->slots[i].hash & mask;
+    // The entry can move back if its home is not in (hole, i], cyclically
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      map->slots[hole] = map->slots[i];
+      hole = i;
+    }
+  }
+  map->slots[hole] = (slot_t){.key = NULL, .value = NULL, .hash = 0};
+  map->size--;
+  return value;
+}
+
+void hash_map_for_each(hash_map_t *map, hash_map_visitor_t visit, void *aux) {
+  for (size_t i = 0; i < map->num_slots; i++) {
+    slot_t *slot = &map->slots[i];
+    if (slot->value != NULL) {
+      visit(slot->key, slot->value, aux);
+    }
+  }
+}
+
+string_pool_t *string_pool_init(void) {
+  string_pool_t *pool = malloc(sizeof(string_pool_t));
+  assert(pool != NULL);
+  pool->strings = hash_map_init(0, hash_string, string_equal, free);
+  return pool;
+}
+
+void string_pool_free(string_pool_t *pool) {
+  hash_map_free(pool->strings);
+  free(pool);
+}
+
+const char *string_intern(string_pool_t *pool, const char *string) {
+  char *interned = hash_map_get(pool->strings, string);
+  if (interned == NULL) {
+    size_t length = strlen(string);
+    interned = malloc(length + 1);
+    assert(interned != NULL);
+    memcpy(interned, string, length + 1);
+    hash_map_put(pool->strings, interned, interned);
+  }
+  return interned;
+}
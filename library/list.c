@@ -52,17 +52,59 @@ void *list_remove(list_t *list, size_t index) {
   return removed;
 }
 
+void *list_swap_remove(list_t *list, size_t index) {
+  assert(index < list->size);
+  void *removed = list->data[index];
+  list->size--;
+  list->data[index] = list->data[list->size];
+  list->data[list->size] = NULL;
+  return removed;
+}
+
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux) {
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    void *element = list->data[i];
+    if (!predicate(element, aux)) {
+      list->data[kept++] = element;
+    } else if (list->freer != NULL) {
+      list->freer(element);
+    }
+  }
+  size_t removed = list->size - kept;
+  for (size_t i = kept; i < list->size; i++) {
+    list->data[i] = NULL;
+  }
+  list->size = kept;
+  return removed;
+}
+
+/**
+ * Changes the capacity of a list, which must be at least its size.
+ */
+static void list_resize(list_t *list, size_t capacity) {
+  // realloc() may return NULL for a size of 0, so always keep one slot
+  list->capacity = capacity > 0 ? capacity : 1;
+  list->data = realloc(list->data, list->capacity * sizeof(void *));
+  assert(list->data != NULL);
+}
+
+void list_reserve(list_t *list, size_t capacity) {
+  if (capacity > list->capacity) {
+    list_resize(list, capacity);
+  }
+}
+
+void list_shrink(list_t *list) {
+  if (list->size < list->capacity) {
+    list_resize(list, list->size);
+  }
+}
+
 void list_add(list_t *list, void *value) {
   assert(value != NULL);
   if (list->size == list->capacity) {
-    void **old_data = list->data;
-    list->capacity = GROWTH_FACTOR * list->capacity + 1;
-    list->data = malloc(list->capacity * sizeof(void *));
-    assert(list->data != NULL);
-    for (size_t i = 0; i < list->size; i++) {
-      list->data[i] = old_data[i];
-    }
-    free(old_data);
+    list_resize(list, GROWTH_FACTOR * list->capacity + 1);
   }
   assert(list->size < list->capacity);
   list->data[list->size] = value;
@@ -0,0 +1,123 @@
+#include "minimap.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct minimap {
+  sdl_context_t *sdl;
+  /** The picture of the whole track, loaded again whenever it is drawn */
+  char *image_path;
+  /** The picture of the track, at about the size it is drawn at */
+  SDL_Texture *texture;
+  /** The corners of the minimap in the scene */
+  vector_t box_min;
+  vector_t box_max;
+  /** Units of the minimap per unit of distance on the track */
+  vector_t scale;
+  /**
+   * Where the minimap is in the window and how many pixels a unit of the scene
+   * spans, cached until sdl_get_view_changes() moves on from view_changes
+   */
+  SDL_Rect box;
+  double pixels_per_unit;
+  size_t view_changes;
+  /** The value of sdl_get_target_resets() when the texture was drawn */
+  size_t target_resets;
+};
+
+/** Maps the minimap's corners to the window */
+static void place_box(minimap_t *map) {
+  vector_t corners[2] = {{.x = map->box_min.x, .y = map->box_max.y},
+                         {.x = map->box_max.x, .y = map->box_min.y}};
+  vector_t pixels[2];
+  sdl_scene_to_window(map->sdl, corners, pixels, 2);
+  map->box = (SDL_Rect){.x = pixels[0].x,
+                        .y = pixels[0].y,
+                        .w = pixels[1].x - pixels[0].x,
+                        .h = pixels[1].y - pixels[0].y};
+  map->pixels_per_unit = map->box.w / (map->box_max.x - map->box_min.x);
+  map->view_changes = sdl_get_view_changes(map->sdl);
+}
+
+/** Maps the minimap's corners to the window again if it has been resized */
+static void update_box(minimap_t *map) {
+  if (sdl_get_view_changes(map->sdl) != map->view_changes) {
+    place_box(map);
+  }
+}
+
+/**
+ * Scales the picture down to the minimap's size in the window into a new
+ * texture, once instead of sampling all of it every frame.
+ */
+static void draw_texture(minimap_t *map) {
+  sdl_context_t *sdl = map->sdl;
+  if (map->texture != NULL) {
+    sdl_destroy_texture(sdl, map->texture);
+  }
+  SDL_Texture *picture = sdl_load_image(sdl, map->image_path);
+  map->texture = sdl_start_render_target(sdl, map->box.w, map->box.h);
+  SDL_Rect whole = {.x = 0, .y = 0, .w = map->box.w, .h = map->box.h};
+  sdl_draw_sprite(sdl, picture, NULL, whole, 0);
+  sdl_finish_render_target(sdl);
+  if (picture != NULL) {
+    sdl_destroy_texture(sdl, picture);
+  }
+  map->target_resets = sdl_get_target_resets(sdl);
+}
+
+minimap_t *minimap_init(sdl_context_t *sdl, const char *image_path,
+                        vector_t min, vector_t max, vector_t box_min,
+                        vector_t box_max) {
+  assert(min.x < max.x && min.y < max.y);
+  assert(box_min.x < box_max.x && box_min.y < box_max.y);
+  minimap_t *map = malloc(sizeof(minimap_t));
+  assert(map != NULL);
+  map->sdl = sdl;
+  map->image_path = malloc(strlen(image_path) + 1);
+  assert(map->image_path != NULL);
+  strcpy(map->image_path, image_path);
+  map->texture = NULL;
+  map->box_min = box_min;
+  map->box_max = box_max;
+  map->scale = (vector_t){.x = (box_max.x - box_min.x) / (max.x - min.x),
+                          .y = (box_max.y - box_min.y) / (max.y - min.y)};
+  place_box(map);
+  draw_texture(map);
+  return map;
+}
+
+void minimap_free(minimap_t *map) {
+  sdl_destroy_texture(map->sdl, map->texture);
+  free(map->image_path);
+  free(map);
+}
+
+void minimap_draw(minimap_t *map) {
+  update_box(map);
+  if (sdl_get_target_resets(map->sdl) != map->target_resets) {
+    draw_texture(map);
+  }
+  sdl_draw_sprite(map->sdl, map->texture, NULL, map->box, 0);
+}
+
+void minimap_draw_marker(minimap_t *map, minimap_marker_t marker,
+                         vector_t offset, double rotation) {
+  if (marker.image == NULL) {
+    return;
+  }
+  update_box(map);
+  vector_t center = {
+      .x = (map->box_min.x + map->box_max.x) / 2 + map->scale.x * offset.x,
+      .y = (map->box_min.y + map->box_max.y) / 2 + map->scale.y * offset.y};
+  vector_t pixel;
+  sdl_scene_to_window(map->sdl, &center, &pixel, 1);
+  vector_t size = vec_multiply(map->pixels_per_unit, marker.size);
+  SDL_Rect destination = {.x = round(pixel.x - size.x / 2),
+                          .y = round(pixel.y - size.y / 2),
+                          .w = round(size.x),
+                          .h = round(size.y)};
+  sdl_draw_sprite(map->sdl, marker.image->texture, &marker.image->source,
+                  destination, rotation);
+}
@@ -1,33 +1,119 @@
 #include "polygon.h"
+#include "arena.h"
 #include "color.h"
 #include "list.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Nearly every polygon is a rectangle, so up to this many vertices are stored
+// in the polygon itself rather than in a separate allocation
+#define INLINE_VERTICES 4
 
 typedef struct polygon {
-  list_t *vertices;
+  vector_t *vertices; // inline_vertices, or a separate array if there are more
+  size_t num_vertices;
   vector_t velocity;
   double rotation_speed;
-  rgb_color_t *color;
+  rgb_color_t color;
   vector_t centroid;
+  arena_t *arena; // the arena the polygon was allocated from, if any
+  vector_t inline_vertices[INLINE_VERTICES];
 } polygon_t;
 
+/**
+ * Allocates memory from an arena, or with malloc if it is NULL.
+ */
+static void *polygon_alloc(arena_t *arena, size_t size) {
+  if (arena != NULL) {
+    return arena_alloc(arena, size);
+  }
+  void *memory = malloc(size);
+  assert(memory != NULL);
+  return memory;
+}
+
+/**
+ * Allocates a polygon at rest with room for n vertices, from an arena or from
+ * malloc if it is NULL. The caller fills in the vertices, then the center.
+ */
+static polygon_t *polygon_alloc_vertices(arena_t *arena, size_t n,
+                                         rgb_color_t color) {
+  polygon_t *polygon = polygon_alloc(arena, sizeof(polygon_t));
+  polygon->num_vertices = n;
+  if (n <= INLINE_VERTICES) {
+    polygon->vertices = polygon->inline_vertices;
+  } else {
+    polygon->vertices = polygon_alloc(arena, n * sizeof(vector_t));
+  }
+  polygon->velocity = VEC_ZERO;
+  polygon->rotation_speed = 0;
+  polygon->color = color;
+  polygon->arena = arena;
+  return polygon;
+}
+
+/**
+ * Initializes a polygon in memory from an arena, or from malloc if it is NULL.
+ */
+static polygon_t *polygon_init_from(arena_t *arena, list_t *points,
+                                    vector_t initial_velocity,
+                                    double rotation_speed, double red,
+                                    double green, double blue) {
+  size_t n = list_size(points);
+  polygon_t *polygon =
+      polygon_alloc_vertices(arena, n, (rgb_color_t){red, green, blue});
+  for (size_t i = 0; i < n; i++) {
+    polygon->vertices[i] = *(vector_t *)list_get(points, i);
+  }
+  list_free(points);
+  polygon->velocity = initial_velocity;
+  polygon->rotation_speed = rotation_speed;
+  polygon_set_center(polygon, polygon_centroid(polygon));
+  return polygon;
+}
+
 polygon_t *polygon_init(list_t *points, vector_t initial_velocity,
                         double rotation_speed, double red, double green,
                         double blue) {
-  polygon_t *polygon = malloc(sizeof(polygon_t));
-  assert(polygon != NULL);
-  polygon->vertices = points;
-  polygon->velocity = initial_velocity;
-  polygon->rotation_speed = rotation_speed;
-  polygon->color = color_init(red, green, blue);
+  return polygon_init_from(NULL, points, initial_velocity, rotation_speed, red,
+                           green, blue);
+}
+
+polygon_t *polygon_init_in_arena(arena_t *arena, list_t *points,
+                                 vector_t initial_velocity,
+                                 double rotation_speed, double red,
+                                 double green, double blue) {
+  assert(arena != NULL);
+  return polygon_init_from(arena, points, initial_velocity, rotation_speed,
+                           red, green, blue);
+}
+
+polygon_t *polygon_init_span(arena_t *arena, vertex_span_t vertices,
+                             rgb_color_t color) {
+  polygon_t *polygon = polygon_alloc_vertices(arena, vertices.size, color);
+  memcpy(polygon->vertices, vertices.data, vertices.size * sizeof(vector_t));
   polygon_set_center(polygon, polygon_centroid(polygon));
   return polygon;
 }
 
-list_t *polygon_get_points(polygon_t *polygon) { return polygon->vertices; }
+polygon_t *polygon_init_rect(arena_t *arena, vector_t center, double w,
+                             double h, rgb_color_t color) {
+  polygon_t *polygon = polygon_alloc_vertices(arena, 4, color);
+  polygon->vertices[0] = (vector_t){center.x - w / 2, center.y - h / 2};
+  polygon->vertices[1] = (vector_t){center.x + w / 2, center.y - h / 2};
+  polygon->vertices[2] = (vector_t){center.x + w / 2, center.y + h / 2};
+  polygon->vertices[3] = (vector_t){center.x - w / 2, center.y + h / 2};
+  polygon_set_center(polygon, center);
+  return polygon;
+}
+
+vertex_span_t polygon_get_vertices(polygon_t *polygon) {
+  return (vertex_span_t){.data = polygon->vertices,
+                         .size = polygon->num_vertices};
+}
 
 void polygon_move(polygon_t *polygon, double time_elapsed) {
   vector_t translation = vec_multiply(time_elapsed, polygon->velocity);
@@ -40,8 +126,12 @@ void polygon_set_velocity(polygon_t *polygon, vector_t vel) {
 }
 
 void polygon_free(polygon_t *polygon) {
-  list_free(polygon->vertices);
-  color_free(polygon->color);
+  if (polygon->arena != NULL) {
+    return;
+  }
+  if (polygon->vertices != polygon->inline_vertices) {
+    free(polygon->vertices);
+  }
   free(polygon);
 }
 
@@ -51,66 +141,77 @@ vector_t *polygon_get_velocity(polygon_t *polygon) {
 
 double polygon_area(polygon_t *polygon) {
   double area = 0.0;
-  size_t len = list_size(polygon->vertices);
-  size_t next = 0;
+  const vector_t *vertices = polygon->vertices;
+  size_t len = polygon->num_vertices;
 
   for (size_t i = 0; i < len; i++) {
-    next = (i + 1) % len;
-    vector_t *current = list_get(polygon->vertices, i);
-    vector_t *next_vertex = list_get(polygon->vertices, next);
-    area += current->x * next_vertex->y;
-    area -= current->y * next_vertex->x;
+    vector_t current = vertices[i];
+    vector_t next_vertex = vertices[i + 1 < len ? i + 1 : 0];
+    area += current.x * next_vertex.y;
+    area -= current.y * next_vertex.x;
   }
   return fabs(area) / 2.0;
 }
 
 vector_t polygon_centroid(polygon_t *polygon) {
-  size_t len = list_size(polygon->vertices);
+  const vector_t *vertices = polygon->vertices;
+  size_t len = polygon->num_vertices;
   vector_t c = {0.0, 0.0};
   double area = polygon_area(polygon);
-  size_t next = 0;
-  vector_t *current;
-  vector_t *next_vertex;
 
   for (size_t i = 0; i < len; i++) {
-    next = (i + 1) % len;
-    current = list_get(polygon->vertices, i);
-    next_vertex = list_get(polygon->vertices, next);
-    double step = (current->x * next_vertex->y) - (next_vertex->x * current->y);
-    c.x += (current->x + next_vertex->x) * step;
-    c.y += (current->y + next_vertex->y) * step;
+    vector_t current = vertices[i];
+    vector_t next_vertex = vertices[i + 1 < len ? i + 1 : 0];
+    double step = (current.x * next_vertex.y) - (next_vertex.x * current.y);
+    c.x += (current.x + next_vertex.x) * step;
+    c.y += (current.y + next_vertex.y) * step;
   }
   return vec_multiply(1 / (6.0 * area), c);
 }
 
 void polygon_translate(polygon_t *polygon, vector_t translation) {
-  size_t len = list_size(polygon->vertices);
-  for (size_t i = 0; i < len; i++) {
-    vector_t *vertex = list_get(polygon->vertices, i);
-    vector_t trans = vec_add(*vertex, translation);
-    vertex->x = trans.x;
-    vertex->y = trans.y;
+  vector_t *vertices = polygon->vertices;
+  for (size_t i = 0; i < polygon->num_vertices; i++) {
+    vertices[i] = vec_add(vertices[i], translation);
   }
   polygon->centroid = vec_add(polygon->centroid, translation);
 }
 
+/**
+ * Rotates a point about the origin, given the cosine and sine of the angle.
+ */
+static vector_t rotate(vector_t v, double c, double s) {
+  return (vector_t){v.x * c - v.y * s, v.x * s + v.y * c};
+}
+
 void polygon_rotate(polygon_t *polygon, double angle, vector_t point) {
-  size_t len = list_size(polygon->vertices);
-  polygon_translate(polygon, vec_negate(point));
-  for (size_t i = 0; i < len; i++) {
-    vector_t *vertex = list_get(polygon->vertices, i);
-    vector_t rot = vec_rotate(*vertex, angle);
-    vertex->x = rot.x;
-    vertex->y = rot.y;
+  double c = cos(angle);
+  double s = sin(angle);
+  vector_t *vertices = polygon->vertices;
+  for (size_t i = 0; i < polygon->num_vertices; i++) {
+    vector_t relative = vec_subtract(vertices[i], point);
+    vertices[i] = vec_add(rotate(relative, c, s), point);
   }
-  polygon->centroid = vec_rotate(polygon->centroid, angle);
-  polygon_translate(polygon, point);
+  polygon->centroid =
+      vec_add(rotate(vec_subtract(polygon->centroid, point), c, s), point);
 }
 
-rgb_color_t *polygon_get_color(polygon_t *polygon) { return polygon->color; }
+void polygon_get_bounds(polygon_t *polygon, vector_t *min, vector_t *max) {
+  *min = (vector_t){__DBL_MAX__, __DBL_MAX__};
+  *max = (vector_t){-__DBL_MAX__, -__DBL_MAX__};
+  const vector_t *vertices = polygon->vertices;
+  for (size_t i = 0; i < polygon->num_vertices; i++) {
+    min->x = fmin(min->x, vertices[i].x);
+    min->y = fmin(min->y, vertices[i].y);
+    max->x = fmax(max->x, vertices[i].x);
+    max->y = fmax(max->y, vertices[i].y);
+  }
+}
+
+rgb_color_t *polygon_get_color(polygon_t *polygon) { return &polygon->color; }
 
 void polygon_set_color(polygon_t *polygon, rgb_color_t *color) {
-  polygon->color = color;
+  polygon->color = *color;
 }
 
 void polygon_set_center(polygon_t *polygon, vector_t centroid) {
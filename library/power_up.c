@@ -5,6 +5,7 @@
 #include "forces.h"
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 // 120 by 60
 const double BOX_SIZE = 30.0;
@@ -24,30 +25,58 @@ const double STUN_COOLDOWN = 2.0;
 const double STUN_DURATION = 3.0;
 const double BOOST_DURATION = 3.0;
 const double BOOST_SIZE = 60.0;
-double SPEED_MULTIPLIER = 1.5;
+const double SPEED_MULTIPLIER = 1.5;
 const double CAR_EL = 0.8;
+// The most collisions an item is in; shells are in three
+#define ITEM_COLLISIONS_MAX 4
 
-struct shell_item_info {
-  vector_t *vector;
+/**
+ * An item's slot in one of the collisions it is in.
+ */
+typedef struct item_collision {
+  collision_t *collision;
+  size_t slot;
+} item_collision_t;
+
+/**
+ * The info of a body from an item pool.
+ */
+typedef struct item_info {
+  item_pool_t *pool;
+  bool active;
+  handle_t handle;   // the item's handle in its pool, while it is active
+  uint64_t acquired; // when the item was last taken, to recycle the oldest
   asset_t *asset;
+  // Shells only: the car the shell is circling (NULL once fired), and its
+  // angular position and velocity around the car
+  body_t *owner;
+  double theta;
+  double ang_vel;
+  // The collisions the item is in, which are reset when it is released
+  size_t num_collisions;
+  item_collision_t collisions[ITEM_COLLISIONS_MAX];
+} item_info_t;
+
+struct item_pool {
+  power_up_type_t type;
+  scene_t *scene;
+  list_t *bodies;     // every item, for the group collisions
+  list_t *assets;     // owns the assets of every item
+  slot_map_t *active; // the bodies of the items in use
+  list_t *parked;     // the bodies of the rest, used as a stack
+  uint64_t acquired;  // the number of items taken so far
 };
 
 struct box_item_info {
-  double *time;
+  bool ready;
   asset_t *asset;
 };
 
-void shell_info_free(shell_item_info_t *info) {
-  free(info->vector); // asset must be destroyed somewhere else
-  free(info);
-}
-
 void box_info_free(box_item_info_t *info) {
-  free(info->time); // asset must be destroyed somewhere else
-  free(info);
+  free(info); // asset must be destroyed somewhere else
 }
 
-asset_t *item_asset(power_up_type_t power) {
+asset_t *item_asset(asset_cache_t *cache, power_up_type_t power) {
   const char *filepath = SHELL_PATH;
   switch (power) {
   case SHELL: {
@@ -78,97 +107,278 @@ asset_t *item_asset(power_up_type_t power) {
     break;
   }
   }
-  return asset_make_image(filepath, ITEM_BOUNDING_BOX);
+  return asset_make_image(cache, filepath, ITEM_BOUNDING_BOX);
 }
 
-asset_t *make_box(vector_t center) {
+asset_t *make_box(asset_cache_t *cache, arena_t *arena, vector_t center) {
   box_item_info_t *info = malloc(sizeof(box_item_info_t));
   assert(info != NULL);
-  info->time = malloc(sizeof(double));
-  assert(info->time != NULL);
-  *(info->time) = 0.0;
+  info->ready = true;
   info->asset = NULL;
-  list_t *points = make_rectangle(center, BOX_SIZE, BOX_SIZE);
-  body_t *body = body_init_with_info(points, INFINITY, get_blue(), info,
-                                     (free_func_t)box_info_free);
-  info->asset = asset_make_image_with_body(BOX_PATH, body);
+  body_t *body = body_init_rect(arena, center, BOX_SIZE, BOX_SIZE, INFINITY,
+                                get_blue(), info, (free_func_t)box_info_free);
+  info->asset = asset_make_image_with_body(cache, BOX_PATH, body);
   return info->asset;
 }
 
-bool update_box(asset_t *box, double dt) {
-  body_t *body = asset_get_body(box);
-  box_item_info_t *info = body_get_info(body);
-  *(info->time) -= dt;
-  return *(info->time) < 0;
+bool box_is_ready(asset_t *box) {
+  box_item_info_t *info = body_get_info(asset_get_body(box));
+  return info->ready;
 }
 
-asset_t *make_shell(vector_t center, double theta, double ang_vel) {
-  shell_item_info_t *info = malloc(sizeof(shell_item_info_t));
+/**
+ * Timer callback that makes a box available again after its cooldown.
+ */
+static void respawn_box(box_item_info_t *info) { info->ready = true; }
+
+/**
+ * Makes the body and asset of a parked item of the given type.
+ */
+static asset_t *make_item(item_pool_t *pool, asset_cache_t *cache,
+                          power_up_type_t type) {
+  item_info_t *info = malloc(sizeof(item_info_t));
   assert(info != NULL);
-  info->vector = malloc(sizeof(vector_t));
-  assert(info->vector != NULL);
-  *(info->vector) = (vector_t){theta, ang_vel};
-  info->asset = NULL;
-  list_t *points = make_rectangle(center, SHELL_SIZE, SHELL_SIZE);
-  body_t *body = body_init_with_info(points, SHELL_MASS, get_blue(), info,
-                                     (free_func_t)shell_info_free);
-  info->asset = asset_make_image_with_body(SHELL_PATH, body);
+  *info = (item_info_t){
+      .pool = pool, .active = false, .owner = NULL, .num_collisions = 0};
+  arena_t *arena = scene_get_arena(pool->scene);
+  body_t *body;
+  switch (type) {
+  case SHELL: {
+    body = body_init_rect(arena, VEC_ZERO, SHELL_SIZE, SHELL_SIZE, SHELL_MASS,
+                          get_blue(), info, free);
+    body_set_circle_collider(body, SHELL_SIZE / 2);
+    info->asset = asset_make_image_with_body(cache, SHELL_PATH, body);
+    break;
+  }
+  case FAKE: {
+    body = body_init_rect(arena, VEC_ZERO, BOX_SIZE, BOX_SIZE, INFINITY,
+                          get_blue(), info, free);
+    info->asset = asset_make_image_with_body(cache, BOX_PATH, body);
+    break;
+  }
+  case BOOST: {
+    body = body_init_rect(arena, VEC_ZERO, BOOST_SIZE, BOOST_SIZE, INFINITY,
+                          get_blue(), info, free);
+    info->asset = asset_make_rotatable_image_with_body(cache, BOOST_PATH, body);
+    break;
+  }
+  default:
+    assert(false && "only shells, fake boxes and boosts are pooled");
+  }
+  body_set_kinematic(body, true);
   return info->asset;
 }
 
-asset_t *make_boost(body_t *car) {
-  list_t *points =
-      make_rectangle(body_get_centroid(car), BOOST_SIZE, BOOST_SIZE);
-  body_t *body = body_init(points, INFINITY, get_blue());
-  asset_t *asset = asset_make_rotatable_image_with_body(BOOST_PATH, body);
-  body_set_rotation(body,
+item_pool_t *item_pool_init(scene_t *scene, asset_cache_t *cache,
+                            power_up_type_t type, size_t capacity) {
+  assert(capacity > 0);
+  item_pool_t *pool = malloc(sizeof(item_pool_t));
+  assert(pool != NULL);
+  pool->type = type;
+  pool->scene = scene;
+  pool->bodies = list_init(capacity, NULL);
+  pool->assets = list_init(capacity, (free_func_t)asset_destroy);
+  pool->active = slot_map_init(capacity, NULL);
+  pool->parked = list_init(capacity, NULL);
+  pool->acquired = 0;
+  for (size_t i = 0; i < capacity; i++) {
+    asset_t *asset = make_item(pool, cache, type);
+    list_add(pool->assets, asset);
+    list_add(pool->bodies, asset_get_body(asset));
+    list_add(pool->parked, asset_get_body(asset));
+    scene_add_body(scene, asset_get_body(asset));
+  }
+  return pool;
+}
+
+void item_pool_free(item_pool_t *pool) {
+  for (size_t i = 0; i < list_size(pool->bodies); i++) {
+    body_t *body = list_get(pool->bodies, i);
+    // Park the item so nothing touches it until the scene reaps it
+    item_release(body);
+    item_info_t *info = body_get_info(body);
+    info->pool = NULL;
+    body_remove(body);
+  }
+  list_free(pool->bodies);
+  list_free(pool->assets);
+  slot_map_free(pool->active);
+  list_free(pool->parked);
+  free(pool);
+}
+
+void item_pool_render(item_pool_t *pool) {
+  for (size_t i = 0; i < slot_map_size(pool->active); i++) {
+    item_info_t *info = body_get_info(slot_map_get_at(pool->active, i));
+    asset_render(info->asset);
+  }
+}
+
+body_t *item_pool_get(item_pool_t *pool, handle_t item) {
+  return slot_map_get(pool->active, item);
+}
+
+bool item_is_active(body_t *item) {
+  item_info_t *info = body_get_info(item);
+  return info->active;
+}
+
+void item_release(body_t *item) {
+  item_info_t *info = body_get_info(item);
+  if (!info->active) {
+    return;
+  }
+  slot_map_remove(info->pool->active, info->handle);
+  list_add(info->pool->parked, item);
+  info->active = false;
+  info->owner = NULL;
+  body_set_kinematic(item, true);
+  body_set_velocity(item, VEC_ZERO);
+  for (size_t i = 0; i < info->num_collisions; i++) {
+    collision_reset(info->collisions[i].collision, info->collisions[i].slot);
+  }
+}
+
+/**
+ * Records that an item is in a slot of a collision, so that releasing it only
+ * resets the collisions it is in.
+ */
+static void item_add_collision(body_t *item, collision_t *collision,
+                               size_t slot) {
+  item_info_t *info = body_get_info(item);
+  assert(info->num_collisions < ITEM_COLLISIONS_MAX);
+  info->collisions[info->num_collisions++] =
+      (item_collision_t){.collision = collision, .slot = slot};
+}
+
+/**
+ * Records the slots of every item of a pool in a group collision, where the
+ * pool's items start at slot `first`.
+ */
+static void pool_add_collision(item_pool_t *pool, collision_t *collision,
+                               size_t first) {
+  for (size_t i = 0; i < list_size(pool->bodies); i++) {
+    item_add_collision(list_get(pool->bodies, i), collision, first + i);
+  }
+}
+
+/**
+ * Takes a parked item from a pool, or recycles the oldest one in use if there
+ * are none, and resets it.
+ */
+static body_t *item_pool_acquire(item_pool_t *pool) {
+  if (list_size(pool->parked) == 0) {
+    body_t *oldest = NULL;
+    uint64_t oldest_acquired = UINT64_MAX;
+    for (size_t i = 0; i < slot_map_size(pool->active); i++) {
+      body_t *body = slot_map_get_at(pool->active, i);
+      item_info_t *info = body_get_info(body);
+      if (info->acquired < oldest_acquired) {
+        oldest = body;
+        oldest_acquired = info->acquired;
+      }
+    }
+    item_release(oldest);
+  }
+  body_t *item = list_remove(pool->parked, list_size(pool->parked) - 1);
+  item_info_t *info = body_get_info(item);
+  info->active = true;
+  info->handle = slot_map_insert(pool->active, item);
+  info->acquired = pool->acquired++;
+  body_set_kinematic(item, false);
+  body_set_rotation(item, 0);
+  body_reset(item);
+  return item;
+}
+
+/**
+ * Moves a shell to its angular position around the car it is circling, and
+ * gives it the matching velocity.
+ */
+static void place_shell(body_t *shell, body_t *car) {
+  item_info_t *info = body_get_info(shell);
+  vector_t offset = vec_rotate((vector_t){0, SHELL_DISTANCE}, info->theta);
+  body_set_centroid(shell, vec_add(body_get_centroid(car), offset));
+  vector_t vel = vec_rotate(offset, M_PI / 2);
+  vel = vec_multiply(info->ang_vel, vel);
+  body_set_velocity(shell, vec_add(vel, body_get_velocity(car)));
+}
+
+handle_t spawn_shell(item_pool_t *pool, body_t *owner, double theta,
+                     double ang_vel) {
+  assert(pool->type == SHELL);
+  body_t *shell = item_pool_acquire(pool);
+  item_info_t *info = body_get_info(shell);
+  info->owner = owner;
+  info->theta = theta;
+  info->ang_vel = ang_vel;
+  place_shell(shell, owner);
+  return info->handle;
+}
+
+void fire_shell(body_t *shell) {
+  item_info_t *info = body_get_info(shell);
+  info->owner = NULL;
+}
+
+body_t *spawn_fake_box(item_pool_t *pool, vector_t center) {
+  assert(pool->type == FAKE);
+  body_t *box = item_pool_acquire(pool);
+  body_set_centroid(box, center);
+  return box;
+}
+
+body_t *spawn_boost(item_pool_t *pool, body_t *car) {
+  assert(pool->type == BOOST);
+  body_t *boost = item_pool_acquire(pool);
+  body_set_centroid(boost, body_get_centroid(car));
+  body_set_rotation(boost,
                     body_get_rotation(car) - M_PI / 2); // car asset faces down
-  return asset;
-  ;
+  return boost;
 }
 
-bool car_has_shell(body_t *car) {
-  power_up_info_t info = car_get_powerup_state(car);
-  if (info.shell == NULL || body_is_removed(info.shell)) {
-    info.shell = NULL;
+body_t *car_get_shell(item_pool_t *shells, body_t *car) {
+  body_t *shell = item_pool_get(shells, car_get_powerup_state(car).shell);
+  if (shell == NULL) {
+    return NULL;
   }
-  return info.shell != NULL;
+  item_info_t *info = body_get_info(shell);
+  return info->owner == car ? shell : NULL;
+}
+
+bool car_has_shell(item_pool_t *shells, body_t *car) {
+  return car_get_shell(shells, car) != NULL;
 }
 
 double get_speed_multiplier() { return SPEED_MULTIPLIER; }
 
-void update_shell(body_t *car, double dt) {
-  if (car_has_shell(car)) {
-    body_t *shell = car_get_powerup_state(car).shell;
-    shell_item_info_t *info = body_get_info(shell);
-    vector_t *vec = info->vector;
-    vec->x += vec->y * dt; // theta += vdt
-    vector_t offset = vec_rotate((vector_t){0, SHELL_DISTANCE}, vec->x);
-    body_set_centroid(shell, vec_add(body_get_centroid(car), offset));
-    vector_t vel = vec_rotate(offset, M_PI / 2);
-    vel = vec_multiply(vec->y, vel);
-    body_set_velocity(shell, vec_add(vel, body_get_velocity(car)));
+void update_shell(item_pool_t *shells, body_t *car, double dt) {
+  body_t *shell = car_get_shell(shells, car);
+  if (shell != NULL) {
+    item_info_t *info = body_get_info(shell);
+    info->theta += info->ang_vel * dt;
+    place_shell(shell, car);
   }
 }
 
 void flip_shell(body_t *shell) {
-  shell_item_info_t *info = body_get_info(shell);
-  info->vector->y *= -1; // flipping angular velocity
+  item_info_t *info = body_get_info(shell);
+  info->ang_vel *= -1;
 }
 
 void box_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                            void *aux, double force_const) {
   box_item_info_t *box_info = body_get_info(body2);
-  double *time = box_info->time;
-  if (*time < 0.0) {
-    bool *switches = aux;
+  if (box_info->ready) {
+    box_rules_t *rules = aux;
+    bool *switches = rules->switches;
     size_t total = 0;
     for (size_t i = 0; i < POSSIBLE_ITEMS; i++) {
       if (switches[i]) {
         total++;
       }
     }
-    size_t count = rand() % total + 1;
+    size_t count = rng_below(scene_get_rng(rules->scene), total) + 1;
     power_up_type_t power = NONE;
     while (count > 0) {
       if (switches[power]) {
@@ -181,46 +391,65 @@ void box_collision_handler(body_t *body1, body_t *body2, vector_t axis,
       info.power_up = power;
       car_set_powerup_state(body1, info);
     }
-    *time = BOX_COOLDOWN;
+    box_info->ready = false;
+    scene_add_timer(rules->scene, BOX_COOLDOWN, body2,
+                    (timer_callback_t)respawn_box, box_info);
   }
 }
 
 void create_box_collision(scene_t *scene, body_t *body1, body_t *body2,
-                          bool *switches) {
+                          box_rules_t *rules) {
   create_collision(scene, body1, body2,
-                   (collision_handler_t)box_collision_handler, switches, 0);
+                   (collision_handler_t)box_collision_handler, rules, 0);
+}
+
+void create_box_collisions(scene_t *scene, list_t *cars, list_t *boxes,
+                           box_rules_t *rules) {
+  create_group_collision(scene, cars, boxes,
+                         (collision_handler_t)box_collision_handler, rules, 0);
 }
 
 void stun_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                             void *aux, double force_const) {
+  if (force_const > 0) {
+    item_info_t *item = body_get_info(body2);
+    if (item->owner == body1) {
+      return; // a shell doesn't hit the car it is circling
+    }
+  }
+  double now = scene_get_time(aux);
   power_up_info_t info = car_get_powerup_state(body1);
-  if (info.stun < -STUN_COOLDOWN && info.immune < 0) {
-    info.stun = STUN_DURATION;
+  if (now > info.stun_until + STUN_COOLDOWN && now >= info.immune_until) {
+    info.stun_until = now + STUN_DURATION;
     car_set_powerup_state(body1, info);
     body_set_velocity(body1, VEC_ZERO);
   }
   if (force_const > 0) {
-    if (force_const > 2) {
-      shell_item_info_t *shell_info = body_get_info(body2);
-      asset_set_body(shell_info->asset, NULL);
-    } else {
-      box_item_info_t *box_info = body_get_info(body2);
-      asset_set_body(box_info->asset, NULL);
-    }
-    body_remove(body2);
+    item_release(body2);
   }
 }
 
 void create_stun_collision(scene_t *scene, body_t *body1, body_t *body2,
                            double remove) {
   create_collision(scene, body1, body2,
-                   (collision_handler_t)stun_collision_handler, NULL, remove);
+                   (collision_handler_t)stun_collision_handler, scene, remove);
+}
+
+void create_stun_collisions(scene_t *scene, list_t *cars, body_t *body,
+                            double remove) {
+  list_t *bodies = list_init(1, NULL);
+  list_add(bodies, body);
+  create_group_collision(scene, cars, bodies,
+                         (collision_handler_t)stun_collision_handler, scene,
+                         remove);
+  list_free(bodies);
 }
 
 void boost_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                              void *aux, double force_const) {
+  double now = scene_get_time(aux);
   power_up_info_t info = car_get_powerup_state(body1);
-  info.fast = fmax(info.fast, BOOST_DURATION);
+  info.fast_until = fmax(info.fast_until, now + BOOST_DURATION);
   car_set_powerup_state(body1, info);
   vector_t vel = body_get_velocity(body1);
   if (vec_get_length(vel) == 0) {
@@ -235,14 +464,14 @@ void boost_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 
 void create_boost_collision(scene_t *scene, body_t *body1, body_t *body2) {
   create_collision(scene, body1, body2,
-                   (collision_handler_t)boost_collision_handler, NULL, 0);
+                   (collision_handler_t)boost_collision_handler, scene, 0);
 }
 
 void car_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                            void *aux, double force_const) {
   power_up_info_t info1 = car_get_powerup_state(body1);
-  if (info1.immune >= 0) {
-    stun_collision_handler(body2, body1, axis, NULL, -1.0);
+  if (scene_get_time(aux) < info1.immune_until) {
+    stun_collision_handler(body2, body1, axis, aux, -1.0);
   } else {
     physics_collision_handler(body1, body2, axis, NULL, force_const);
   }
@@ -250,30 +479,77 @@ void car_collision_handler(body_t *body1, body_t *body2, vector_t axis,
 
 void create_car_collision(scene_t *scene, body_t *body1, body_t *body2) {
   create_collision(scene, body1, body2,
-                   (collision_handler_t)car_collision_handler, NULL, CAR_EL);
+                   (collision_handler_t)car_collision_handler, scene, CAR_EL);
+}
+
+void create_car_collisions(scene_t *scene, list_t *cars) {
+  create_group_collision(scene, cars, NULL,
+                         (collision_handler_t)car_collision_handler, scene,
+                         CAR_EL);
 }
 
 void shell_collision_handler(body_t *body1, body_t *body2, vector_t axis,
                              void *aux, double force_const) {
-  shell_item_info_t *info1 = body_get_info(body1);
-  asset_set_body(info1->asset, NULL);
-  shell_item_info_t *info2 = body_get_info(body2);
-  asset_set_body(info2->asset, NULL);
-  body_remove(body1);
-  body_remove(body2);
+  item_release(body1);
+  item_release(body2);
 }
 
-void create_shell_collision(scene_t *scene, body_t *body1, body_t *body2) {
-  create_collision(scene, body1, body2,
-                   (collision_handler_t)shell_collision_handler, NULL, 0);
+/**
+ * Bounces a fired shell (body2) off the walls (body1). Shells circling a car
+ * pass through them.
+ */
+static void shell_wall_collision_handler(body_t *body1, body_t *body2,
+                                         vector_t axis, void *aux,
+                                         double force_const) {
+  item_info_t *info = body_get_info(body2);
+  if (info->owner == NULL) {
+    physics_collision_handler(body1, body2, axis, aux, force_const);
+  }
+}
+
+void create_shell_collisions(scene_t *scene, item_pool_t *shells,
+                             list_t *cars, body_t *walls, double elasticity) {
+  assert(shells->type == SHELL);
+  collision_t *stuns = create_group_collision(
+      scene, cars, shells->bodies, (collision_handler_t)stun_collision_handler,
+      scene, 1.0);
+  pool_add_collision(shells, stuns, list_size(cars));
+  collision_t *hits = create_group_collision(
+      scene, shells->bodies, NULL, (collision_handler_t)shell_collision_handler,
+      NULL, 0);
+  pool_add_collision(shells, hits, 0);
+  // Each wall a shell touches bounces it, which a group can't tell apart
+  for (size_t i = 0; i < list_size(shells->bodies); i++) {
+    body_t *shell = list_get(shells->bodies, i);
+    collision_t *bounces = create_collision(
+        scene, walls, shell, (collision_handler_t)shell_wall_collision_handler,
+        NULL, elasticity);
+    item_add_collision(shell, bounces, 1);
+  }
+}
+
+void create_fake_box_collisions(scene_t *scene, item_pool_t *boxes,
+                                list_t *cars) {
+  assert(boxes->type == FAKE);
+  collision_t *stuns = create_group_collision(
+      scene, cars, boxes->bodies, (collision_handler_t)stun_collision_handler,
+      scene, 1.0);
+  pool_add_collision(boxes, stuns, list_size(cars));
+}
+
+void create_boost_collisions(scene_t *scene, item_pool_t *boosts,
+                             list_t *cars) {
+  assert(boosts->type == BOOST);
+  collision_t *boosting = create_group_collision(
+      scene, cars, boosts->bodies, (collision_handler_t)boost_collision_handler,
+      scene, 0);
+  pool_add_collision(boosts, boosting, list_size(cars));
 }
 
-void permute(size_t *elements, size_t size) {
+void permute(rng_t *rng, size_t *elements, size_t size) {
   for (size_t i = size; i > 1; i--) {
-    size_t j = (size_t)(rand() % i);
+    size_t j = rng_below(rng, i);
     size_t aux = elements[j];
-    if (aux > 3)
-      printf("FUCKED UP %zu\n", j);
     elements[j] = elements[i - 1];
     elements[i - 1] = aux;
   }
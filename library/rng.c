@@ -0,0 +1,56 @@
+#include <assert.h>
+
+#include "rng.h"
+
+const uint64_t SPLITMIX_INCREMENT = 0x9e3779b97f4a7c15;
+
+/**
+ * Advances a splitmix64 state and returns its output. Used to spread a single
+ * seed over the whole xoshiro state, which must not be all zeros.
+ */
+static uint64_t splitmix64(uint64_t *x) {
+  uint64_t z = (*x += SPLITMIX_INCREMENT);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+rng_t rng_init(uint64_t seed) {
+  rng_t rng;
+  for (size_t i = 0; i < 4; i++) {
+    rng.state[i] = splitmix64(&seed);
+  }
+  return rng;
+}
+
+uint64_t rng_next(rng_t *rng) {
+  uint64_t *s = rng->state;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+double rng_double(rng_t *rng) {
+  // The top 53 bits fill the mantissa exactly
+  return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+size_t rng_below(rng_t *rng, size_t bound) {
+  assert(bound > 0);
+  // Reject the lowest (2^64 mod bound) values so every remainder is equally
+  // likely
+  uint64_t threshold = -(uint64_t)bound % bound;
+  uint64_t r;
+  do {
+    r = rng_next(rng);
+  } while (r < threshold);
+  return r % bound;
+}
@@ -1,48 +1,228 @@
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "collision.h"
 #include "forces.h"
 #include "scene.h"
 
 const double INITIAL_BODIES = 10;
 const size_t INITIAL_FORCES = 1;
+// Bodies wider or taller than this (e.g. the background and the walls) are
+// kept out of the sorted index and always checked
+const double LARGE_BODY_SIZE = 1000;
+const uint64_t SCENE_DEFAULT_SEED = 0;
+const size_t INITIAL_TIMERS = 8;
+const size_t ARENA_CHUNK_SIZE = 16384;
+// The most steps scene_tick_bounded() splits a tick into, so a long stall or a
+// runaway body can't make a tick cost more and more
+const size_t MAX_SUBSTEPS = 8;
+
+/**
+ * A body in the spatial index, with its bounds when the index was built.
+ */
+typedef struct index_entry {
+  body_t *body;
+  vector_t min;
+  vector_t max;
+} index_entry_t;
+
+/**
+ * A pending timer. `order` breaks ties between timers with the same deadline,
+ * so they run in the order they were added.
+ */
+typedef struct scene_timer {
+  double deadline;
+  uint64_t order;
+  body_t *body;
+  timer_callback_t callback;
+  void *aux;
+} scene_timer_t;
 
 struct scene {
   size_t num_bodies;
   list_t *bodies;
   list_t *force_creators;
+  arena_t *arena; // for the force creators and their state
+  rng_t rng;
+  double time;
+
+  // The pending timers, as a binary min-heap ordered by deadline
+  scene_timer_t *timers;
+  size_t num_timers;
+  size_t timer_capacity;
+  uint64_t timers_added;
+
+  // The spatial index: small bodies sorted by the left edge of their bounds,
+  // followed by the large bodies
+  index_entry_t *index;
+  size_t index_capacity;
+  size_t num_small;
+  size_t num_large;
+  bool index_valid;
 };
 
-void scene_tick(scene_t *scene, double dt) {
+/**
+ * Returns whether timer a should run before timer b.
+ */
+static bool timer_before(const scene_timer_t *a, const scene_timer_t *b) {
+  return a->deadline < b->deadline ||
+         (a->deadline == b->deadline && a->order < b->order);
+}
+
+static void timer_sift_up(scene_timer_t *heap, size_t i) {
+  scene_timer_t timer = heap[i];
+  while (i > 0 && timer_before(&timer, &heap[(i - 1) / 2])) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = timer;
+}
+
+static void timer_sift_down(scene_timer_t *heap, size_t size, size_t i) {
+  scene_timer_t timer = heap[i];
+  while (2 * i + 1 < size) {
+    size_t child = 2 * i + 1;
+    if (child + 1 < size && timer_before(&heap[child + 1], &heap[child])) {
+      child++;
+    }
+    if (!timer_before(&heap[child], &timer)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = timer;
+}
+
+/**
+ * Drops the pending timers that belong to removed bodies.
+ * Removals are rare, so this simply filters the heap and rebuilds it.
+ */
+static void drop_timers(scene_t *scene) {
+  size_t kept = 0;
+  for (size_t i = 0; i < scene->num_timers; i++) {
+    body_t *body = scene->timers[i].body;
+    if (body == NULL || !body_is_removed(body)) {
+      scene->timers[kept++] = scene->timers[i];
+    }
+  }
+  if (kept == scene->num_timers) {
+    return;
+  }
+  scene->num_timers = kept;
+  for (size_t i = kept / 2; i-- > 0;) {
+    timer_sift_down(scene->timers, kept, i);
+  }
+}
+
+/**
+ * Runs every timer whose deadline has passed, earliest first. A callback may
+ * add more timers, which run in this tick too if they are already due.
+ */
+static void run_timers(scene_t *scene) {
+  while (scene->num_timers > 0 && scene->timers[0].deadline <= scene->time) {
+    scene_timer_t timer = scene->timers[0];
+    scene->num_timers--;
+    if (scene->num_timers > 0) {
+      scene->timers[0] = scene->timers[scene->num_timers];
+      timer_sift_down(scene->timers, scene->num_timers, 0);
+    }
+    timer.callback(timer.aux);
+  }
+}
+
+static bool is_removed(void *body, void *aux) {
+  return body_is_removed(body);
+}
+
+/**
+ * Returns whether a force creator acts on a removed body.
+ */
+static bool acts_on_removed(void *f_inf, void *aux) {
+  list_t *force_bodies = f_info_get_bodies(f_inf);
+  for (size_t i = 0; i < list_size(force_bodies); i++) {
+    if (body_is_removed(list_get(force_bodies, i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Runs the force creators and moves the bodies over dt. If skip_removed is
+ * set, the force creators acting on bodies marked for removal are skipped, as
+ * they would have been removed already at the end of a whole tick.
+ * Returns whether any body is marked for removal.
+ */
+static bool step_bodies(scene_t *scene, double dt, bool skip_removed) {
   for (size_t i = 0; i < list_size(scene->force_creators); i++) {
     force_info_t *f_inf = list_get(scene->force_creators, i);
+    if (skip_removed && acts_on_removed(f_inf, NULL)) {
+      continue;
+    }
     f_info_get_f_creator(f_inf)(f_info_get_aux(f_inf));
   }
 
-  for (ssize_t i = 0; i < (ssize_t)scene->num_bodies; i++) {
+  bool any_removed = false;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
     body_t *body = list_get(scene->bodies, i);
     if (body_is_removed(body)) {
-      for (size_t j = 0; j < list_size(scene->force_creators); j++) {
-        force_info_t *f_inf = list_get(scene->force_creators, j);
-        list_t *force_bodies = f_info_get_bodies(f_inf);
-        for (size_t k = 0; k < list_size(force_bodies); k++) {
-          if (list_get(force_bodies, k) == body) {
-            list_remove(scene->force_creators, j);
-            force_info_free(f_inf);
-            j--; // decrement since we remove one force_info
-            break;
-          }
-        }
-      }
-      list_remove(scene->bodies, i);
-      body_free(body);
-      scene->num_bodies--;
-      i--; // decrement since we remove one body
+      any_removed = true;
     } else {
       body_tick(body, dt);
     }
   }
+  scene->index_valid = false;
+  return any_removed;
+}
+
+/**
+ * Ends a tick of length dt: frees the removed bodies along with the force
+ * creators and timers acting on them, then advances the time and runs the
+ * timers that have expired.
+ */
+static void finish_tick(scene_t *scene, double dt, bool any_removed) {
+  if (any_removed) {
+    // Each list is compacted in one pass. The force creators and timers go
+    // first, since they are checked against the bodies before those are freed.
+    // The memory of the force creators in the arena is kept.
+    list_remove_if(scene->force_creators, acts_on_removed, NULL);
+    drop_timers(scene);
+    list_remove_if(scene->bodies, is_removed, NULL);
+    scene->num_bodies = list_size(scene->bodies);
+  }
+  scene->time += dt;
+  run_timers(scene);
+}
+
+void scene_tick(scene_t *scene, double dt) {
+  finish_tick(scene, dt, step_bodies(scene, dt, false));
+}
+
+void scene_tick_bounded(scene_t *scene, double dt, double max_distance) {
+  assert(max_distance > 0);
+  // Kinematic bodies are moved by their owners, not by the steps
+  double max_speed = 0;
+  for (size_t i = 0; i < scene->num_bodies; i++) {
+    body_t *body = list_get(scene->bodies, i);
+    if (!body_is_kinematic(body) && !body_is_removed(body)) {
+      max_speed = fmax(max_speed, vec_get_length(body_get_velocity(body)));
+    }
+  }
+  double wanted = ceil(max_speed * dt / max_distance);
+  size_t steps = MAX_SUBSTEPS;
+  if (wanted <= 1) {
+    steps = 1;
+  } else if (wanted < MAX_SUBSTEPS) {
+    steps = wanted;
+  }
+  bool any_removed = false;
+  for (size_t i = 0; i < steps; i++) {
+    any_removed = step_bodies(scene, dt / steps, any_removed) || any_removed;
+  }
+  finish_tick(scene, dt, any_removed);
 }
 
 void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
@@ -52,7 +232,16 @@ void scene_add_force_creator(scene_t *scene, force_creator_t force_creator,
 
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
                                     void *aux, list_t *bodies) {
-  force_info_t *f_inf = force_info_init(aux, forcer, bodies);
+  scene_add_bodies_force_creator_with_freer(scene, forcer, aux, bodies,
+                                            body_aux_free);
+}
+
+void scene_add_bodies_force_creator_with_freer(scene_t *scene,
+                                               force_creator_t forcer,
+                                               void *aux, list_t *bodies,
+                                               free_func_t freer) {
+  force_info_t *f_inf =
+      force_info_init(scene->arena, aux, forcer, bodies, freer);
   list_add(scene->force_creators, f_inf);
 }
 
@@ -62,25 +251,95 @@ scene_t *scene_init(void) {
   scene->bodies = list_init(INITIAL_BODIES, (free_func_t)body_free);
   scene->force_creators =
       list_init(INITIAL_FORCES, (free_func_t)force_info_free);
+  scene->arena = arena_init(ARENA_CHUNK_SIZE);
   scene->num_bodies = 0;
+  scene->rng = rng_init(SCENE_DEFAULT_SEED);
+  scene->time = 0;
+  scene->timers = malloc(INITIAL_TIMERS * sizeof(scene_timer_t));
+  assert(scene->timers != NULL);
+  scene->num_timers = 0;
+  scene->timer_capacity = INITIAL_TIMERS;
+  scene->timers_added = 0;
+  scene->index = NULL;
+  scene->index_capacity = 0;
+  scene->num_small = 0;
+  scene->num_large = 0;
+  scene->index_valid = false;
   return scene;
 }
 
 void scene_free(scene_t *scene) {
   list_free(scene->bodies);
   list_free(scene->force_creators);
+  arena_free(scene->arena);
+  free(scene->index);
+  free(scene->timers);
   free(scene);
 }
 
+void scene_clear(scene_t *scene) {
+  size_t num_bodies = list_size(scene->bodies);
+  for (size_t i = num_bodies; i > 0; i--) {
+    body_free(list_remove(scene->bodies, i - 1));
+  }
+  size_t num_forces = list_size(scene->force_creators);
+  for (size_t i = num_forces; i > 0; i--) {
+    force_info_free(list_remove(scene->force_creators, i - 1));
+  }
+  arena_reset(scene->arena);
+  scene->num_bodies = 0;
+  scene->time = 0;
+  scene->num_timers = 0;
+  scene->index_valid = false;
+}
+
+arena_t *scene_get_arena(scene_t *scene) { return scene->arena; }
+
 size_t scene_bodies(scene_t *scene) { return list_size(scene->bodies); }
 
+void scene_seed(scene_t *scene, uint64_t seed) {
+  scene->rng = rng_init(seed);
+}
+
+rng_t *scene_get_rng(scene_t *scene) { return &scene->rng; }
+
+double scene_get_time(scene_t *scene) { return scene->time; }
+
+void scene_add_timer(scene_t *scene, double delay, body_t *body,
+                     timer_callback_t callback, void *aux) {
+  assert(delay >= 0);
+  if (scene->num_timers == scene->timer_capacity) {
+    scene->timer_capacity *= 2;
+    scene->timers =
+        realloc(scene->timers, scene->timer_capacity * sizeof(scene_timer_t));
+    assert(scene->timers != NULL);
+  }
+  scene->timers[scene->num_timers] =
+      (scene_timer_t){.deadline = scene->time + delay,
+                      .order = scene->timers_added++,
+                      .body = body,
+                      .callback = callback,
+                      .aux = aux};
+  timer_sift_up(scene->timers, scene->num_timers);
+  scene->num_timers++;
+}
+
 body_t *scene_get_body(scene_t *scene, size_t index) {
   return list_get(scene->bodies, index);
 }
 
+size_t scene_force_creators(scene_t *scene) {
+  return list_size(scene->force_creators);
+}
+
+force_info_t *scene_get_force_creator(scene_t *scene, size_t index) {
+  return list_get(scene->force_creators, index);
+}
+
 void scene_add_body(scene_t *scene, body_t *body) {
   scene->num_bodies++;
   list_add(scene->bodies, body);
+  scene->index_valid = false;
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
@@ -94,4 +353,263 @@ void scene_center_body(scene_t *scene, body_t *body, vector_t center) {
     body_t *curr = scene_get_body(scene, i);
     body_set_centroid(curr, vec_add(body_get_centroid(curr), shift));
   }
+  scene->index_valid = false;
+}
+
+static int compare_entries(const void *a, const void *b) {
+  double min_a = ((const index_entry_t *)a)->min.x;
+  double min_b = ((const index_entry_t *)b)->min.x;
+  return (min_a > min_b) - (min_a < min_b);
+}
+
+/**
+ * Rebuilds the spatial index from the current bounds of the bodies.
+ */
+static void scene_build_index(scene_t *scene) {
+  size_t size = list_size(scene->bodies);
+  if (scene->index_capacity < size) {
+    scene->index_capacity = size * 2;
+    scene->index =
+        realloc(scene->index, scene->index_capacity * sizeof(index_entry_t));
+    assert(scene->index != NULL);
+  }
+  // Small bodies fill the index from the front and large ones from the back,
+  // so the large ones end up right after the small ones
+  size_t small = 0;
+  size_t large = size;
+  for (size_t i = 0; i < size; i++) {
+    body_t *body = list_get(scene->bodies, i);
+    index_entry_t entry = {.body = body};
+    polygon_get_bounds(body_get_polygon(body), &entry.min, &entry.max);
+    if (entry.max.x - entry.min.x > LARGE_BODY_SIZE ||
+        entry.max.y - entry.min.y > LARGE_BODY_SIZE) {
+      scene->index[--large] = entry;
+    } else {
+      scene->index[small++] = entry;
+    }
+  }
+  qsort(scene->index, small, sizeof(index_entry_t), compare_entries);
+  scene->num_small = small;
+  scene->num_large = size - large;
+  scene->index_valid = true;
+}
+
+/**
+ * Calls `visit` on every body whose indexed bounds overlap a box, until it
+ * returns false.
+ */
+static void scene_query_box(scene_t *scene, vector_t min, vector_t max,
+                            bool (*visit)(body_t *body, void *aux),
+                            void *aux) {
+  if (!scene->index_valid) {
+    scene_build_index(scene);
+  }
+  // Small bodies can't start more than LARGE_BODY_SIZE to the left of the box
+  size_t lo = 0;
+  size_t hi = scene->num_small;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (scene->index[mid].min.x < min.x - LARGE_BODY_SIZE) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  size_t end = scene->num_small + scene->num_large;
+  for (size_t i = lo; i < end; i++) {
+    index_entry_t *entry = &scene->index[i];
+    if (i < scene->num_small && entry->min.x > max.x) {
+      i = scene->num_small - 1; // skip to the large bodies
+      continue;
+    }
+    if (entry->min.x > max.x || entry->max.x < min.x ||
+        entry->min.y > max.y || entry->max.y < min.y ||
+        body_is_removed(entry->body)) {
+      continue;
+    }
+    if (!visit(entry->body, aux)) {
+      return;
+    }
+  }
+}
+
+/**
+ * Returns whether a point is inside a convex polygon.
+ */
+static bool polygon_contains(vertex_span_t points, vector_t point) {
+  size_t n = points.size;
+  bool positive = false;
+  bool negative = false;
+  for (size_t i = 0; i < n; i++) {
+    vector_t a = points.data[i];
+    vector_t b = points.data[i + 1 < n ? i + 1 : 0];
+    double cross = vec_cross(vec_subtract(b, a), vec_subtract(point, a));
+    positive = positive || cross > 0;
+    negative = negative || cross < 0;
+  }
+  return !(positive && negative);
+}
+
+typedef struct cast {
+  vector_t origin;
+  vector_t direction;
+  double radius;
+  vector_t min;
+  vector_t max;
+  body_filter_t filter;
+  void *filter_aux;
+  scene_hit_t hit;
+} cast_t;
+
+/**
+ * Casts at a capsule, keeping the hit if it is the closest so far.
+ */
+static void cast_segment(cast_t *cast, body_t *body, vector_t a, vector_t b,
+                         double radius) {
+  double distance;
+  vector_t normal;
+  if (raycast_segment(cast->origin, cast->direction, cast->hit.distance, a, b,
+                      radius + cast->radius, &distance, &normal)) {
+    cast->hit.body = body;
+    cast->hit.distance = distance;
+    cast->hit.normal = normal;
+  }
+}
+
+/**
+ * Casts at the walls of a track wall body in the grid cells the cast passes.
+ */
+static void cast_walls(cast_t *cast, body_t *walls) {
+  track_t *track = body_get_track(walls);
+  vector_t offset = body_get_track_offset(walls);
+  double radius = body_get_collider_radius(walls);
+  vector_t margin = {radius, radius};
+  vector_t min = vec_subtract(vec_subtract(cast->min, offset), margin);
+  vector_t max = vec_add(vec_subtract(cast->max, offset), margin);
+  size_t lo[2], hi[2];
+  if (!track_get_cell_range(track, min, max, lo, hi)) {
+    return;
+  }
+  size_t num_walls;
+  const track_wall_t *track_walls = track_get_walls(track, &num_walls);
+  for (size_t row = lo[1]; row <= hi[1]; row++) {
+    for (size_t col = lo[0]; col <= hi[0]; col++) {
+      size_t count;
+      const uint32_t *cell = track_get_cell_walls(track, col, row, &count);
+      for (size_t i = 0; i < count; i++) {
+        const track_wall_t *wall = &track_walls[cell[i]];
+        cast_segment(cast, walls, vec_add(wall->a, offset),
+                     vec_add(wall->b, offset), radius);
+      }
+    }
+  }
+}
+
+/**
+ * Casts at a body from the index, depending on its collider type.
+ */
+static bool cast_body(body_t *body, void *aux) {
+  cast_t *cast = aux;
+  if (cast->filter != NULL && !cast->filter(body, cast->filter_aux)) {
+    return true;
+  }
+  switch (body_get_collider_type(body)) {
+  case COLLIDER_POLYGON: {
+    vertex_span_t points = polygon_get_vertices(body_get_polygon(body));
+    if (polygon_contains(points, cast->origin)) {
+      break;
+    }
+    size_t n = points.size;
+    for (size_t i = 0; i < n; i++) {
+      cast_segment(cast, body, points.data[i],
+                   points.data[i + 1 < n ? i + 1 : 0], 0);
+    }
+    break;
+  }
+  case COLLIDER_CIRCLE: {
+    vector_t center = body_get_centroid(body);
+    cast_segment(cast, body, center, center, body_get_collider_radius(body));
+    break;
+  }
+  case COLLIDER_TRACK_WALLS: {
+    cast_walls(cast, body);
+    break;
+  }
+  }
+  return true;
+}
+
+scene_hit_t scene_shape_cast(scene_t *scene, vector_t origin, double radius,
+                             vector_t direction, double max_distance,
+                             body_filter_t filter, void *aux) {
+  assert(radius >= 0 && max_distance >= 0);
+  double length = vec_get_length(direction);
+  assert(length > 0);
+  cast_t cast = {.origin = origin,
+                 .direction = vec_multiply(1 / length, direction),
+                 .radius = radius,
+                 .filter = filter,
+                 .filter_aux = aux,
+                 .hit = {.body = NULL, .distance = max_distance}};
+  vector_t end = vec_add(origin, vec_multiply(max_distance, cast.direction));
+  cast.min = (vector_t){fmin(origin.x, end.x) - radius,
+                        fmin(origin.y, end.y) - radius};
+  cast.max = (vector_t){fmax(origin.x, end.x) + radius,
+                        fmax(origin.y, end.y) + radius};
+  scene_query_box(scene, cast.min, cast.max, cast_body, &cast);
+  if (cast.hit.body != NULL) {
+    cast.hit.point =
+        vec_add(origin, vec_multiply(cast.hit.distance, cast.direction));
+  }
+  return cast.hit;
+}
+
+scene_hit_t scene_raycast(scene_t *scene, vector_t origin, vector_t direction,
+                          double max_distance, body_filter_t filter,
+                          void *aux) {
+  return scene_shape_cast(scene, origin, 0, direction, max_distance, filter,
+                          aux);
+}
+
+typedef struct overlap {
+  body_t *shape;
+  body_filter_t filter;
+  void *filter_aux;
+  list_t *results;
+  size_t count;
+} overlap_t;
+
+/**
+ * Adds a body from the index to the results if it collides with the shape.
+ */
+static bool overlap_body(body_t *body, void *aux) {
+  overlap_t *overlap = aux;
+  body_filter_t filter = overlap->filter;
+  if (body == overlap->shape ||
+      (filter != NULL && !filter(body, overlap->filter_aux))) {
+    return true;
+  }
+  // find_collision() can't test two track wall bodies against each other
+  if (body_get_collider_type(body) == COLLIDER_TRACK_WALLS &&
+      body_get_collider_type(overlap->shape) == COLLIDER_TRACK_WALLS) {
+    return true;
+  }
+  if (find_collision(overlap->shape, body).collided) {
+    list_add(overlap->results, body);
+    overlap->count++;
+  }
+  return true;
+}
+
+size_t scene_overlap(scene_t *scene, body_t *shape, body_filter_t filter,
+                     void *aux, list_t *results) {
+  overlap_t overlap = {.shape = shape,
+                       .filter = filter,
+                       .filter_aux = aux,
+                       .results = results,
+                       .count = 0};
+  vector_t min, max;
+  polygon_get_bounds(body_get_polygon(shape), &min, &max);
+  scene_query_box(scene, min, max, overlap_body, &overlap);
+  return overlap.count;
 }
\ No newline at end of file
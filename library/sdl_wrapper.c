@@ -1,86 +1,493 @@
 #include "sdl_wrapper.h"
-#include "asset_cache.h"
+#include "hash_map.h"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 #include <assert.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
 const int WINDOW_HEIGHT = 500;
 const double MS_PER_S = 1e3;
+const size_t ATLAS_COLUMNS = 16;
+const size_t TEXT_CACHE_INITIAL_SIZE = 32;
+const size_t TEXTURE_SIZES_INITIAL_SIZE = 64;
+/** The most bytes of texture memory the cached text textures may use */
+const size_t TEXT_CACHE_BUDGET = 4 << 20;
+const size_t BYTES_PER_PIXEL = 4;
+/** The width and height of the tiles of a tiled image, in image pixels */
+const size_t TILE_SIZE = 512;
+/** How many tiles may stay resident besides those needed in a frame */
+const size_t MAX_RESIDENT_TILES = 24;
+/** How many frames of camera motion ahead tiles are prefetched for */
+const double PREFETCH_FRAMES = 30;
+/** The most tiles prefetched in one frame, to spread out the uploads */
+const size_t MAX_PREFETCH_UPLOADS = 2;
+/** The width and height of the atlas textures made by sdl_pack_images() */
+const int ATLAS_PAGE_SIZE = 2048;
+/** The largest width or height of an image that is packed into an atlas */
+const int MAX_PACKED_SIZE = 1024;
+/** The gap left around packed images, so filtering can't bleed between them */
+const int ATLAS_PADDING = 1;
+
+/** The glyphs in an atlas are the printable ASCII characters */
+#define ATLAS_FIRST_GLYPH ' '
+#define ATLAS_NUM_GLYPHS ('~' - ' ' + 1)
+/** The most sprites sent to the renderer in one batch */
+#define SPRITE_BATCH_MAX 256
+
+typedef struct glyph {
+  /** Where the glyph is in the atlas texture */
+  SDL_Rect source;
+  /** How far to move right after drawing the glyph */
+  int advance;
+} glyph_t;
+
+struct glyph_atlas {
+  sdl_context_t *sdl;
+  /** Kept open to render whole strings for the text cache */
+  TTF_Font *font;
+  SDL_Texture *texture;
+  vector_t texture_size;
+  int height;
+  glyph_t glyphs[ATLAS_NUM_GLYPHS];
+};
+
+typedef struct tile {
+  /** The tile's texture, or NULL if it is not resident */
+  SDL_Texture *texture;
+  /** The last frame the tile was drawn or prefetched in */
+  uint64_t last_used;
+} tile_t;
+
+struct tiled_image {
+  sdl_context_t *sdl;
+  /** The whole image, in SDL_PIXELFORMAT_RGBA32, which tiles are cut from */
+  SDL_Surface *pixels;
+  size_t cols;
+  size_t rows;
+  tile_t *tiles; // cols * rows, by row
+  size_t num_resident;
+  uint64_t frame;
+  /** Where the image was drawn last frame, to tell where the view is going */
+  SDL_Rect last_destination;
+  bool has_last_destination;
+};
+
+/** An image being packed by sdl_pack_images() */
+typedef struct pack_item {
+  SDL_Surface *surface;
+  size_t index; // of the image in the paths passed in
+  size_t page;  // the atlas page the image was placed on, if placed
+  bool is_placed;
+} pack_item_t;
+
+/** What a cached text texture was rendered from */
+typedef struct text_key {
+  glyph_atlas_t *atlas;
+  const char *text;
+  SDL_Color color;
+} text_key_t;
+
+typedef struct text_entry {
+  text_key_t key; // owns its copy of the text
+  SDL_Texture *texture;
+  int w;
+  int h;
+  /** The neighbours of the entry in order of when they were last drawn */
+  struct text_entry *newer;
+  struct text_entry *older;
+} text_entry_t;
+
+/** The renderer calls a draw list can record */
+typedef enum {
+  DRAW_CLEAR,
+  DRAW_GEOMETRY,
+  DRAW_POLYGON,
+  DRAW_COPY,
+  DRAW_RECT,
+  DRAW_PRESENT,
+  DRAW_DESTROY,
+  DRAW_TARGET,
+} draw_type_t;
+
+typedef struct draw_command {
+  draw_type_t type;
+  /**
+   * What GEOMETRY and COPY draw with, what DESTROY destroys, and what TARGET
+   * draws into (NULL for the window)
+   */
+  SDL_Texture *texture;
+  /** What CLEAR, POLYGON and RECT draw in */
+  SDL_Color color;
+  /** Where COPY draws to, and what RECT outlines */
+  SDL_Rect rect;
+  /** The first vertex of GEOMETRY's quads, or the first point of POLYGON */
+  size_t first;
+  /** The number of quads or points */
+  size_t count;
+} draw_command_t;
 
 /**
- * The coordinate at the center of the screen.
- */
-vector_t center;
-/**
- * The coordinate difference from the center to the top right corner.
- */
-vector_t max_diff;
-/**
- * The SDL window where the scene is rendered.
- */
-SDL_Window *window;
-/**
- * The renderer used to draw the scene.
- */
-SDL_Renderer *renderer;
-/**
- * The keypress handler, or NULL if none has been configured.
+ * Everything drawn in a frame, recorded by the drawing functions and then
+ * played back by sdl_show(), which makes the renderer calls in order. The
+ * arrays are kept between frames, so recording doesn't allocate once they are
+ * big enough.
  */
-key_handler_t key_handler = NULL;
+typedef struct draw_list {
+  draw_command_t *commands;
+  size_t num_commands;
+  size_t commands_capacity;
+  SDL_Vertex *vertices; // 4 for each quad, in the order of sprite_indices
+  size_t num_vertices;
+  size_t vertices_capacity;
+  int16_t *points_x; // the screen coordinates of the polygons' vertices
+  int16_t *points_y;
+  size_t num_points;
+  size_t points_capacity;
+} draw_list_t;
+
+struct sdl_context {
+  /**
+   * The coordinate at the center of the screen.
+   */
+  vector_t center;
+  /**
+   * The coordinate difference from the center to the top right corner.
+   */
+  vector_t max_diff;
+  /**
+   * The size of the window, its center in pixels and the scaling factor from
+   * scene to pixel coordinates. They are cached until the window is resized,
+   * when view_valid is cleared, and view_changes counts the recomputations.
+   */
+  vector_t window_size;
+  vector_t window_center;
+  double scene_scale;
+  bool view_valid;
+  size_t view_changes;
+  /** The number of SDL_RENDER_TARGETS_RESET events so far */
+  size_t target_resets;
+  /**
+   * The size of the texture being drawn into between
+   * sdl_start_render_target() and sdl_finish_render_target().
+   */
+  vector_t target_size;
+  bool is_targeting;
+  /**
+   * The SDL window where the scene is rendered.
+   */
+  SDL_Window *window;
+  /**
+   * The renderer used to draw the scene.
+   */
+  SDL_Renderer *renderer;
+  /**
+   * The list the drawing functions are recording into.
+   */
+  draw_list_t recording;
+  /**
+   * The keypress handler, or NULL if none has been configured.
+   */
+  key_handler_t key_handler;
+  /**
+   * The click handler, or NULL if none has been configured.
+   */
+  mouse_handler_t mouse_handler;
+  /**
+   * SDL's timestamp when each key (by scancode) was last pressed, or 0 if it
+   * is not held. Used to mesasure how long a key has been held.
+   */
+  uint32_t key_start_timestamps[SDL_NUM_SCANCODES];
+  /**
+   * The value of clock() when time_since_last_tick() was last called.
+   * Initially 0.
+   */
+  clock_t last_clock;
+  /**
+   * Whole strings rendered by sdl_draw_cached_text(), from text_key_t to
+   * text_entry_t.
+   */
+  hash_map_t *text_cache;
+  /**
+   * The size of every texture made by this file that is still alive, from
+   * SDL_Texture * to a malloc'd vector_t, so drawing doesn't have to query
+   * SDL for it.
+   */
+  hash_map_t *texture_sizes;
+  /** The most and least recently drawn entries of text_cache */
+  text_entry_t *newest_text;
+  text_entry_t *oldest_text;
+  text_cache_stats_t text_stats;
+  /**
+   * Screen coordinates of the vertices of the polygon being drawn, kept
+   * between frames so drawing doesn't allocate once they are big enough.
+   */
+  vector_t *polygon_pixels;
+  size_t polygon_capacity;
+  /** Heap allocations by the drawing functions this frame and last frame */
+  size_t frame_allocations;
+  size_t last_frame_allocations;
+  /**
+   * Sprites drawn since the last flush, which all use sprite_texture, and the
+   * size of that texture. Their vertices start at batch_first in the
+   * recording list.
+   */
+  SDL_Texture *sprite_texture;
+  vector_t sprite_texture_size;
+  size_t num_sprites;
+  size_t batch_first;
+  /** Two triangles for each quad of a batch's vertices, filled in once */
+  int sprite_indices[6 * SPRITE_BATCH_MAX];
+  /** The counters of the frame being drawn and of the last shown frame */
+  sprite_stats_t sprite_stats;
+  sprite_stats_t last_sprite_stats;
+};
+
+static uint64_t hash_text_key(const void *key) {
+  const text_key_t *text_key = key;
+  SDL_Color color = text_key->color;
+  uint32_t rgba = color.r << 24 | color.g << 16 | color.b << 8 | color.a;
+  uint64_t hash = hash_string(text_key->text) ^ hash_pointer(text_key->atlas);
+  return hash ^ hash_pointer((void *)(uintptr_t)rgba);
+}
+
+static bool text_key_equal(const void *key1, const void *key2) {
+  const text_key_t *a = key1, *b = key2;
+  return a->atlas == b->atlas && a->color.r == b->color.r &&
+         a->color.g == b->color.g && a->color.b == b->color.b &&
+         a->color.a == b->color.a && strcmp(a->text, b->text) == 0;
+}
+
+/** Takes an entry out of the recency order */
+static void text_unlink(sdl_context_t *sdl, text_entry_t *entry) {
+  if (entry->newer != NULL) {
+    entry->newer->older = entry->older;
+  } else {
+    sdl->newest_text = entry->older;
+  }
+  if (entry->older != NULL) {
+    entry->older->newer = entry->newer;
+  } else {
+    sdl->oldest_text = entry->newer;
+  }
+}
+
+/** Puts an entry at the front of the recency order */
+static void text_push_newest(sdl_context_t *sdl, text_entry_t *entry) {
+  entry->newer = NULL;
+  entry->older = sdl->newest_text;
+  if (sdl->newest_text != NULL) {
+    sdl->newest_text->newer = entry;
+  } else {
+    sdl->oldest_text = entry;
+  }
+  sdl->newest_text = entry;
+}
+
 /**
- * SDL's timestamp when a key was last pressed or released.
- * Used to mesasure how long a key has been held.
+ * Allocates memory for the drawing functions, counting the allocation in the
+ * current frame. Asserts that the memory was allocated.
  */
-uint32_t key_start_timestamp;
+static void *draw_realloc(sdl_context_t *sdl, void *ptr, size_t size) {
+  void *allocated = realloc(ptr, size);
+  assert(allocated != NULL);
+  sdl->frame_allocations++;
+  return allocated;
+}
+
+/** Adds a command to the list being recorded */
+static draw_command_t *push_command(sdl_context_t *sdl, draw_type_t type) {
+  draw_list_t *list = &sdl->recording;
+  if (list->commands_capacity == list->num_commands) {
+    list->commands_capacity = 2 * list->num_commands + 1;
+    list->commands = draw_realloc(
+        sdl, list->commands, list->commands_capacity * sizeof(draw_command_t));
+  }
+  draw_command_t *command = &list->commands[list->num_commands++];
+  *command = (draw_command_t){.type = type};
+  return command;
+}
+
+/** Adds `count` vertices to the list being recorded and returns them */
+static SDL_Vertex *push_vertices(sdl_context_t *sdl, size_t count) {
+  draw_list_t *list = &sdl->recording;
+  if (list->vertices_capacity < list->num_vertices + count) {
+    list->vertices_capacity = 2 * (list->num_vertices + count);
+    list->vertices = draw_realloc(sdl, list->vertices,
+                                  list->vertices_capacity * sizeof(SDL_Vertex));
+  }
+  SDL_Vertex *vertices = &list->vertices[list->num_vertices];
+  list->num_vertices += count;
+  return vertices;
+}
+
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * Adds `count` polygon points to the list being recorded and returns the
+ * index of the first.
  */
-clock_t last_clock = 0;
+static size_t push_points(sdl_context_t *sdl, size_t count) {
+  draw_list_t *list = &sdl->recording;
+  if (list->points_capacity < list->num_points + count) {
+    list->points_capacity = 2 * (list->num_points + count);
+    list->points_x = draw_realloc(sdl, list->points_x,
+                                  list->points_capacity * sizeof(int16_t));
+    list->points_y = draw_realloc(sdl, list->points_y,
+                                  list->points_capacity * sizeof(int16_t));
+  }
+  size_t first = list->num_points;
+  list->num_points += count;
+  return first;
+}
+
+/** Makes the renderer calls recorded in a list, then empties it */
+static void draw_list_execute(sdl_context_t *sdl, draw_list_t *list) {
+  SDL_Renderer *renderer = sdl->renderer;
+  for (size_t i = 0; i < list->num_commands; i++) {
+    const draw_command_t *command = &list->commands[i];
+    SDL_Color color = command->color;
+    switch (command->type) {
+    case DRAW_CLEAR:
+      SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+      SDL_RenderClear(renderer);
+      break;
+    case DRAW_GEOMETRY:
+      SDL_RenderGeometry(renderer, command->texture,
+                         &list->vertices[command->first], 4 * command->count,
+                         sdl->sprite_indices, 6 * command->count);
+      break;
+    case DRAW_POLYGON:
+      filledPolygonRGBA(renderer, &list->points_x[command->first],
+                        &list->points_y[command->first], command->count,
+                        color.r, color.g, color.b, color.a);
+      break;
+    case DRAW_COPY:
+      SDL_RenderCopy(renderer, command->texture, NULL, &command->rect);
+      break;
+    case DRAW_RECT:
+      SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+      SDL_RenderDrawRect(renderer, &command->rect);
+      break;
+    case DRAW_PRESENT:
+      SDL_RenderPresent(renderer);
+      break;
+    case DRAW_DESTROY:
+      SDL_DestroyTexture(command->texture);
+      break;
+    case DRAW_TARGET:
+      SDL_SetRenderTarget(renderer, command->texture);
+      break;
+    }
+  }
+  list->num_commands = 0;
+  list->num_vertices = 0;
+  list->num_points = 0;
+}
+
+/** Records the size of a texture that was just created */
+static void remember_texture_size(sdl_context_t *sdl, SDL_Texture *texture,
+                                  int width, int height) {
+  vector_t *size = malloc(sizeof(vector_t));
+  assert(size != NULL);
+  *size = (vector_t){.x = width, .y = height};
+  hash_map_put(sdl->texture_sizes, texture, size);
+}
+
+/** Uploads a surface to a new texture */
+static SDL_Texture *create_texture(sdl_context_t *sdl, SDL_Surface *surface) {
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(sdl->renderer, surface);
+  // Atlases are packed with an alpha channel, so every texture is blended
+  if (texture != NULL) {
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    remember_texture_size(sdl, texture, surface->w, surface->h);
+  }
+  return texture;
+}
+
+vector_t sdl_get_texture_size(sdl_context_t *sdl, SDL_Texture *texture) {
+  vector_t *size = hash_map_get(sdl->texture_sizes, texture);
+  assert(size != NULL);
+  return *size;
+}
+
+void sdl_destroy_texture(sdl_context_t *sdl, SDL_Texture *texture) {
+  free(hash_map_remove(sdl->texture_sizes, texture));
+  // Lists recorded before now may still draw with the texture, so it is
+  // destroyed in order with them
+  sdl_flush_sprites(sdl);
+  push_command(sdl, DRAW_DESTROY)->texture = texture;
+}
 
-/** Computes the center of the window in pixel coordinates */
-vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
-  return vec_multiply(0.5, dimensions);
+static void text_entry_free(sdl_context_t *sdl, text_entry_t *entry) {
+  hash_map_remove(sdl->text_cache, &entry->key);
+  text_unlink(sdl, entry);
+  sdl->text_stats.bytes -= (size_t)entry->w * entry->h * BYTES_PER_PIXEL;
+  sdl->text_stats.entries--;
+  sdl_destroy_texture(sdl, entry->texture);
+  free((char *)entry->key.text);
+  free(entry);
 }
 
 /**
- * Computes the scaling factor between scene coordinates and pixel coordinates.
+ * Recomputes the window metrics and the scene scale if the window has been
+ * resized since they were cached.
  * The scene is scaled by the same factor in the x and y dimensions,
  * chosen to maximize the size of the scene while keeping it in the window.
  */
-double get_scene_scale(vector_t window_center) {
+static void update_view(sdl_context_t *sdl) {
+  if (sdl->view_valid) {
+    return;
+  }
+  int width, height;
+  SDL_GetWindowSize(sdl->window, &width, &height);
+  sdl->window_size = (vector_t){.x = width, .y = height};
+  sdl->window_center = vec_multiply(0.5, sdl->window_size);
   // Scale scene so it fits entirely in the window
-  double x_scale = window_center.x / max_diff.x,
-         y_scale = window_center.y / max_diff.y;
-  return x_scale < y_scale ? x_scale : y_scale;
+  double x_scale = sdl->window_center.x / sdl->max_diff.x,
+         y_scale = sdl->window_center.y / sdl->max_diff.y;
+  sdl->scene_scale = x_scale < y_scale ? x_scale : y_scale;
+  sdl->view_valid = true;
+  sdl->view_changes++;
+}
+
+/** Returns the size of the window in pixels */
+static vector_t get_window_size(sdl_context_t *sdl) {
+  update_view(sdl);
+  return sdl->window_size;
 }
 
 /** Maps a scene coordinate to a window coordinate */
-vector_t get_window_position(vector_t scene_pos, vector_t window_center) {
-  // Scale scene coordinates by the scaling factor
-  // and map the center of the scene to the center of the window
-  vector_t scene_center_offset = vec_subtract(scene_pos, center);
-  double scale = get_scene_scale(window_center);
-  vector_t pixel_center_offset = vec_multiply(scale, scene_center_offset);
-  vector_t pixel = {.x = round(window_center.x + pixel_center_offset.x),
-                    // Flip y axis since positive y is down on the screen
-                    .y = round(window_center.y - pixel_center_offset.y)};
+static vector_t get_window_position(sdl_context_t *sdl, vector_t scene_pos) {
+  vector_t pixel;
+  sdl_scene_to_window(sdl, &scene_pos, &pixel, 1);
   return pixel;
 }
 
+void sdl_scene_to_window(sdl_context_t *sdl, const vector_t *restrict points,
+                         vector_t *restrict pixels, size_t count) {
+  update_view(sdl);
+  // Hoisted out of the loop, which is then a straight multiply-add over the
+  // array that the compiler can vectorize
+  double scale = sdl->scene_scale;
+  vector_t center = sdl->center, window_center = sdl->window_center;
+  for (size_t i = 0; i < count; i++) {
+    // Scale scene coordinates by the scaling factor
+    // and map the center of the scene to the center of the window
+    pixels[i].x = round(window_center.x + scale * (points[i].x - center.x));
+    // Flip y axis since positive y is down on the screen
+    pixels[i].y = round(window_center.y - scale * (points[i].y - center.y));
+  }
+}
+
+size_t sdl_get_view_changes(sdl_context_t *sdl) {
+  update_view(sdl);
+  return sdl->view_changes;
+}
+
 /**
  * Converts an SDL key code to a char.
  * 7-bit ASCII characters are just returned
@@ -106,38 +513,79 @@ char get_keycode(SDL_Keycode key) {
   }
 }
 
-void sdl_init(vector_t min, vector_t max) {
+sdl_context_t *sdl_init(vector_t min, vector_t max) {
   // Check parameters
   assert(min.x < max.x);
   assert(min.y < max.y);
 
-  center = vec_multiply(0.5, vec_add(min, max));
-  max_diff = vec_subtract(max, center);
+  sdl_context_t *sdl = calloc(1, sizeof(sdl_context_t));
+  assert(sdl != NULL);
+  sdl->center = vec_multiply(0.5, vec_add(min, max));
+  sdl->max_diff = vec_subtract(max, sdl->center);
   SDL_Init(SDL_INIT_EVERYTHING);
-  window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
-                            SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
-                            SDL_WINDOW_RESIZABLE);
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+  sdl->window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
+                                 SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH,
+                                 WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE);
+  Uint32 flags = SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE;
+  sdl->renderer = SDL_CreateRenderer(sdl->window, -1, flags);
   TTF_Init();
+  sdl->text_cache = hash_map_init(TEXT_CACHE_INITIAL_SIZE, hash_text_key,
+                                  text_key_equal, NULL);
+  sdl->texture_sizes = hash_map_init(TEXTURE_SIZES_INITIAL_SIZE, hash_pointer,
+                                     pointer_equal, free);
+  for (int i = 0; i < SPRITE_BATCH_MAX; i++) {
+    int *triangles = &sdl->sprite_indices[6 * i];
+    triangles[0] = 4 * i;
+    triangles[1] = 4 * i + 1;
+    triangles[2] = 4 * i + 2;
+    triangles[3] = 4 * i;
+    triangles[4] = 4 * i + 2;
+    triangles[5] = 4 * i + 3;
+  }
+  return sdl;
 }
 
-uint32_t key_start_timestamps[SDL_NUM_SCANCODES];
+void sdl_free(sdl_context_t *sdl) {
+  while (sdl->oldest_text != NULL) {
+    text_entry_free(sdl, sdl->oldest_text);
+  }
+  hash_map_free(sdl->text_cache);
+  hash_map_free(sdl->texture_sizes);
+  // Destroy the textures freed since the last frame, then the renderer
+  draw_list_execute(sdl, &sdl->recording);
+  SDL_DestroyRenderer(sdl->renderer);
+  free(sdl->recording.commands);
+  free(sdl->recording.vertices);
+  free(sdl->recording.points_x);
+  free(sdl->recording.points_y);
+  free(sdl->polygon_pixels);
+  SDL_DestroyWindow(sdl->window);
+  free(sdl);
+}
 
-bool sdl_is_done(void *state) {
-  SDL_Event *event = malloc(sizeof(*event));
+bool sdl_is_done(sdl_context_t *sdl, void *state) {
+  SDL_Event event_storage;
+  SDL_Event *event = &event_storage;
   const Uint8 *keyboard = SDL_GetKeyboardState(NULL);
-  assert(event != NULL);
   while (SDL_PollEvent(event)) {
     switch (event->type) {
     case SDL_QUIT:
-      free(event);
       return true;
+    case SDL_WINDOWEVENT:
+      if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        sdl->view_valid = false;
+      }
+      break;
+    case SDL_RENDER_TARGETS_RESET:
+      sdl->target_resets++;
+      break;
     case SDL_KEYDOWN:
-      if (key_start_timestamps[event->key.keysym.sym] == 0) {
-        key_start_timestamps[event->key.keysym.sym] = event->key.timestamp;
+      if (sdl->key_start_timestamps[event->key.keysym.scancode] == 0) {
+        sdl->key_start_timestamps[event->key.keysym.scancode] =
+            event->key.timestamp;
       }
       uint32_t timestamp = event->key.timestamp;
-      if (key_handler == NULL) {
+      if (sdl->key_handler == NULL) {
         break;
       }
       if (get_keycode(event->key.keysym.sym) == '\0') {
@@ -147,152 +595,531 @@ bool sdl_is_done(void *state) {
         if (keyboard[i]) {
           char key = get_keycode(SDL_GetKeyFromScancode((SDL_Scancode)i));
           if (key != '\0') {
-            double held_time = (timestamp - key_start_timestamps[i]) / MS_PER_S;
-            key_handler(key, KEY_PRESSED, held_time, state);
+            double held_time =
+                (timestamp - sdl->key_start_timestamps[i]) / MS_PER_S;
+            sdl->key_handler(key, KEY_PRESSED, held_time, state);
           }
         }
       }
       break;
 
     case SDL_KEYUP:
-      if (key_handler == NULL) {
+      if (sdl->key_handler == NULL) {
         break;
       }
       char key = get_keycode(event->key.keysym.sym);
       if (key == '\0') {
         break;
       }
-      key_start_timestamps[event->key.keysym.sym] = 0;
+      sdl->key_start_timestamps[event->key.keysym.scancode] = 0;
       break;
     case SDL_MOUSEBUTTONDOWN: {
       SDL_MouseButtonEvent *click = (SDL_MouseButtonEvent *)event;
-      asset_cache_handle_buttons(state, click->x, click->y);
+      if (sdl->mouse_handler != NULL) {
+        sdl->mouse_handler(state, click->x, click->y);
+      }
       break;
     }
     }
   }
 
-  if (key_handler != NULL) {
+  if (sdl->key_handler != NULL) {
     uint32_t timestamp = SDL_GetTicks();
     for (size_t i = 0; i < SDL_NUM_SCANCODES; i++) {
-      if (key_start_timestamps[i]) {
+      if (sdl->key_start_timestamps[i]) {
         char key = get_keycode(SDL_GetKeyFromScancode((SDL_Scancode)i));
-        if (key != '\0' && key_start_timestamps[i]) {
-          double held_time = (timestamp - key_start_timestamps[i]) / MS_PER_S;
-          key_handler(key, KEY_PRESSED, held_time, state);
+        if (key != '\0' && sdl->key_start_timestamps[i]) {
+          double held_time =
+              (timestamp - sdl->key_start_timestamps[i]) / MS_PER_S;
+          sdl->key_handler(key, KEY_PRESSED, held_time, state);
         }
       }
     }
   }
 
-  free(event);
   return false;
 }
 
-void sdl_clear(void) {
-  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-  SDL_RenderClear(renderer);
+void sdl_clear(sdl_context_t *sdl) {
+  sdl_flush_sprites(sdl);
+  push_command(sdl, DRAW_CLEAR)->color =
+      (SDL_Color){.r = 255, .g = 255, .b = 255, .a = 255};
 }
 
-void sdl_draw_polygon(polygon_t *poly, rgb_color_t color) {
-  list_t *points = polygon_get_points(poly);
+void sdl_draw_polygon(sdl_context_t *sdl, polygon_t *poly, rgb_color_t color) {
+  vertex_span_t points = polygon_get_vertices(poly);
   // Check parameters
-  size_t n = list_size(points);
+  size_t n = points.size;
   assert(n >= 3);
+  sdl_flush_sprites(sdl);
 
-  vector_t window_center = get_window_center();
-
-  // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+  // Convert the vertices to points on screen all at once
+  if (sdl->polygon_capacity < n) {
+    sdl->polygon_capacity = 2 * n;
+    sdl->polygon_pixels =
+        draw_realloc(sdl, sdl->polygon_pixels,
+                     sdl->polygon_capacity * sizeof(vector_t));
+  }
+  sdl_scene_to_window(sdl, points.data, sdl->polygon_pixels, n);
+  size_t first = push_points(sdl, n);
+  int16_t *x_points = &sdl->recording.points_x[first],
+          *y_points = &sdl->recording.points_y[first];
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
+    x_points[i] = sdl->polygon_pixels[i].x;
+    y_points[i] = sdl->polygon_pixels[i].y;
   }
 
   // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+  draw_command_t *command = push_command(sdl, DRAW_POLYGON);
+  command->color = (SDL_Color){
+      .r = color.r * 255, .g = color.g * 255, .b = color.b * 255, .a = 255};
+  command->first = first;
+  command->count = n;
 }
 
-void sdl_show(void) {
+void sdl_show(sdl_context_t *sdl) {
+  sdl_flush_sprites(sdl);
+  sdl->last_sprite_stats = sdl->sprite_stats;
+  sdl->sprite_stats = (sprite_stats_t){0};
+  sdl->last_frame_allocations = sdl->frame_allocations;
+  sdl->frame_allocations = 0;
+
   // Draw boundary lines
-  vector_t window_center = get_window_center();
-  vector_t max = vec_add(center, max_diff),
-           min = vec_subtract(center, max_diff);
-  vector_t max_pixel = get_window_position(max, window_center),
-           min_pixel = get_window_position(min, window_center);
-  SDL_Rect *boundary = malloc(sizeof(*boundary));
-  boundary->x = min_pixel.x;
-  boundary->y = max_pixel.y;
-  boundary->w = max_pixel.x - min_pixel.x;
-  boundary->h = min_pixel.y - max_pixel.y;
-  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderDrawRect(renderer, boundary);
-  free(boundary);
-
-  SDL_RenderPresent(renderer);
-}
-
-void sdl_render_scene(scene_t *scene, void *aux) {
-  sdl_clear();
+  vector_t max = vec_add(sdl->center, sdl->max_diff),
+           min = vec_subtract(sdl->center, sdl->max_diff);
+  vector_t max_pixel = get_window_position(sdl, max),
+           min_pixel = get_window_position(sdl, min);
+  SDL_Rect boundary = {.x = min_pixel.x,
+                       .y = max_pixel.y,
+                       .w = max_pixel.x - min_pixel.x,
+                       .h = min_pixel.y - max_pixel.y};
+  draw_command_t *command = push_command(sdl, DRAW_RECT);
+  command->color = (SDL_Color){.r = 0, .g = 0, .b = 0, .a = 255};
+  command->rect = boundary;
+
+  push_command(sdl, DRAW_PRESENT);
+  draw_list_execute(sdl, &sdl->recording);
+}
+
+void sdl_render_scene(sdl_context_t *sdl, scene_t *scene, void *aux) {
+  sdl_clear(sdl);
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    polygon_t *poly = polygon_init(shape, (vector_t){0, 0}, 0, 0, 0, 0);
-    sdl_draw_polygon(poly, *body_get_color(body));
-    list_free(shape);
+    sdl_draw_polygon(sdl, body_get_polygon(body), *body_get_color(body));
   }
   if (aux != NULL) {
     body_t *body = aux;
-    sdl_draw_polygon(body_get_polygon(body), *body_get_color(body));
+    sdl_draw_polygon(sdl, body_get_polygon(body), *body_get_color(body));
   }
-  sdl_show();
+  sdl_show(sdl);
 }
 
-void sdl_on_key(key_handler_t handler) { key_handler = handler; }
+void sdl_on_key(sdl_context_t *sdl, key_handler_t handler) {
+  sdl->key_handler = handler;
+}
+
+void sdl_on_click(sdl_context_t *sdl, mouse_handler_t handler) {
+  sdl->mouse_handler = handler;
+}
 
-double time_since_last_tick(void) {
+double time_since_last_tick(sdl_context_t *sdl) {
   clock_t now = clock();
-  double difference = last_clock
-                          ? (double)(now - last_clock) / CLOCKS_PER_SEC
+  double difference = sdl->last_clock
+                          ? (double)(now - sdl->last_clock) / CLOCKS_PER_SEC
                           : 0.0; // return 0 the first time this is called
-  last_clock = now;
+  sdl->last_clock = now;
   return difference;
 }
 
-SDL_Texture *sdl_load_image(const char *path) {
+SDL_Texture *sdl_load_image(sdl_context_t *sdl, const char *path) {
   // Load the image
-  return IMG_LoadTexture(renderer, path);
+  SDL_Surface *surface = IMG_Load(path);
+  if (surface == NULL) {
+    return NULL;
+  }
+  SDL_Texture *texture = create_texture(sdl, surface);
+  SDL_FreeSurface(surface);
+  return texture;
 }
 
-void sdl_display_image(SDL_Texture *image, vector_t loc, vector_t size) {
-  SDL_Rect *rectangle = malloc(sizeof(SDL_Rect));
-  assert(rectangle != NULL);
-  rectangle->x = loc.x; // Center the scaled image
-  rectangle->y = loc.y;
-  rectangle->w = size.x;
-  rectangle->h = size.y;
+void sdl_flush_sprites(sdl_context_t *sdl) {
+  if (sdl->num_sprites > 0) {
+    draw_command_t *command = push_command(sdl, DRAW_GEOMETRY);
+    command->texture = sdl->sprite_texture;
+    command->first = sdl->batch_first;
+    command->count = sdl->num_sprites;
+    sdl->sprite_stats.draw_calls++;
+    sdl->sprite_stats.vertices += 4 * sdl->num_sprites;
+    sdl->num_sprites = 0;
+  }
+  // The texture may be destroyed before the next sprite is drawn
+  sdl->sprite_texture = NULL;
+}
 
-  SDL_RenderCopy(renderer, image, NULL, rectangle);
+/**
+ * Adds a quad to the sprite batch, flushing the batch first if it uses another
+ * texture or is full, and returns the quad's vertices to fill in.
+ */
+static SDL_Vertex *batch_quad(sdl_context_t *sdl, SDL_Texture *texture) {
+  if (texture != sdl->sprite_texture ||
+      sdl->num_sprites == SPRITE_BATCH_MAX) {
+    sdl_flush_sprites(sdl);
+    sdl->sprite_texture = texture;
+    sdl->sprite_texture_size = sdl_get_texture_size(sdl, texture);
+    sdl->batch_first = sdl->recording.num_vertices;
+  }
+  sdl->num_sprites++;
+  return push_vertices(sdl, 4);
+}
 
-  free(rectangle);
+/**
+ * Checks whether a box in window coordinates misses the window, or the texture
+ * being drawn into, entirely.
+ */
+static bool is_off_screen(sdl_context_t *sdl, vector_t min, vector_t max) {
+  vector_t size = sdl->is_targeting ? sdl->target_size : get_window_size(sdl);
+  return max.x < 0 || max.y < 0 || min.x > size.x || min.y > size.y;
+}
+
+void sdl_draw_sprite(sdl_context_t *sdl, SDL_Texture *texture,
+                     const SDL_Rect *source, SDL_Rect destination,
+                     double theta) {
+  if (texture == NULL) {
+    return; // e.g. an image that failed to load
+  }
+  // Rotate the corners about the center of the destination, counterclockwise
+  // on screen like a rotation by theta in the scene
+  double half_w = destination.w / 2.0, half_h = destination.h / 2.0;
+  vector_t center = {.x = destination.x + half_w, .y = destination.y + half_h};
+  double c = cos(theta), s = sin(theta);
+  vector_t corners[4] = {{-half_w, -half_h},
+                         {half_w, -half_h},
+                         {half_w, half_h},
+                         {-half_w, half_h}};
+  vector_t min = {.x = INFINITY, .y = INFINITY};
+  vector_t max = {.x = -INFINITY, .y = -INFINITY};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t d = corners[i];
+    corners[i] = (vector_t){.x = center.x + d.x * c + d.y * s,
+                            .y = center.y - d.x * s + d.y * c};
+    min = (vector_t){.x = fmin(min.x, corners[i].x),
+                     .y = fmin(min.y, corners[i].y)};
+    max = (vector_t){.x = fmax(max.x, corners[i].x),
+                     .y = fmax(max.y, corners[i].y)};
+  }
+  // Skip sprites the camera can't see before they can split a batch
+  if (is_off_screen(sdl, min, max)) {
+    sdl->sprite_stats.culled++;
+    return;
+  }
+
+  SDL_Vertex *quad = batch_quad(sdl, texture);
+  float u0 = 0, v0 = 0, u1 = 1, v1 = 1;
+  if (source != NULL) {
+    vector_t size = sdl->sprite_texture_size;
+    u0 = source->x / size.x;
+    v0 = source->y / size.y;
+    u1 = (source->x + source->w) / size.x;
+    v1 = (source->y + source->h) / size.y;
+  }
+  float u[4] = {u0, u1, u1, u0};
+  float v[4] = {v0, v0, v1, v1};
+  for (size_t i = 0; i < 4; i++) {
+    quad[i] = (SDL_Vertex){
+        .position = {corners[i].x, corners[i].y},
+        .color = {255, 255, 255, 255},
+        .tex_coord = {u[i], v[i]},
+    };
+  }
+  sdl->sprite_stats.sprites++;
+}
+
+sprite_stats_t sdl_get_sprite_stats(sdl_context_t *sdl) {
+  return sdl->last_sprite_stats;
+}
+
+SDL_Texture *sdl_start_render_target(sdl_context_t *sdl, int width,
+                                     int height) {
+  assert(!sdl->is_targeting);
+  SDL_Texture *texture =
+      SDL_CreateTexture(sdl->renderer, SDL_PIXELFORMAT_RGBA32,
+                        SDL_TEXTUREACCESS_TARGET, width, height);
+  assert(texture != NULL);
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  remember_texture_size(sdl, texture, width, height);
+  sdl_flush_sprites(sdl);
+  push_command(sdl, DRAW_TARGET)->texture = texture;
+  // Start from transparent pixels, so the texture can be drawn over anything
+  push_command(sdl, DRAW_CLEAR)->color =
+      (SDL_Color){.r = 0, .g = 0, .b = 0, .a = 0};
+  sdl->target_size = (vector_t){.x = width, .y = height};
+  sdl->is_targeting = true;
+  return texture;
+}
+
+void sdl_finish_render_target(sdl_context_t *sdl) {
+  assert(sdl->is_targeting);
+  sdl_flush_sprites(sdl);
+  push_command(sdl, DRAW_TARGET)->texture = NULL;
+  sdl->is_targeting = false;
+}
+
+size_t sdl_get_target_resets(sdl_context_t *sdl) {
+  return sdl->target_resets;
+}
+
+void sdl_display_image(sdl_context_t *sdl, SDL_Texture *image, vector_t loc,
+                       vector_t size) {
+  SDL_Rect destination = {.x = loc.x, .y = loc.y, .w = size.x, .h = size.y};
+  sdl_draw_sprite(sdl, image, NULL, destination, 0);
+}
+
+void sdl_display_image_with_angle(sdl_context_t *sdl, SDL_Texture *img,
+                                  SDL_Rect bounding_box, double theta,
+                                  vector_t centroid) {
+  sdl_draw_sprite(sdl, img, NULL, bounding_box, theta);
 }
 
-void sdl_display_image_with_angle(SDL_Texture *img, SDL_Rect bounding_box,
-                                  double theta, vector_t centroid) {
-  /* vector_t window_center = get_window_center();
-  centroid = get_window_position(centroid, window_center);
-  SDL_Point center = {.x = (int32_t)centroid.x, .y = (int32_t)centroid.y}; */
-  SDL_RenderCopyEx(renderer, img, NULL, &bounding_box, -theta * 180 / M_PI,
-                   NULL, SDL_FLIP_NONE);
+/** Sorts pack items from the tallest to the shortest */
+static int compare_heights(const void *a, const void *b) {
+  const pack_item_t *item_a = a, *item_b = b;
+  return item_b->surface->h - item_a->surface->h;
+}
+
+void sdl_pack_images(sdl_context_t *sdl, const char *const *paths,
+                     size_t count, texture_region_t *regions, list_t *pages) {
+  pack_item_t *items = malloc(count * sizeof(pack_item_t));
+  assert(items != NULL);
+  size_t num_items = 0;
+  for (size_t i = 0; i < count; i++) {
+    regions[i] = (texture_region_t){.texture = NULL};
+    SDL_Surface *loaded = IMG_Load(paths[i]);
+    if (loaded == NULL) {
+      continue;
+    }
+    if (loaded->w > MAX_PACKED_SIZE || loaded->h > MAX_PACKED_SIZE) {
+      SDL_FreeSurface(loaded);
+      continue;
+    }
+    SDL_Surface *surface =
+        SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    assert(surface != NULL);
+    // Copy the alpha channel instead of blending onto the empty page
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    items[num_items++] = (pack_item_t){.surface = surface, .index = i};
+  }
+  qsort(items, num_items, sizeof(pack_item_t), compare_heights);
+
+  // Fill each page with shelves of images, tallest first; whatever doesn't
+  // fit goes on the next page
+  size_t num_placed = 0;
+  for (size_t page = 0; num_placed < num_items; page++) {
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(
+        0, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+    assert(sheet != NULL);
+    int x = 0, y = 0, shelf_height = 0;
+    for (size_t i = 0; i < num_items; i++) {
+      pack_item_t *item = &items[i];
+      if (item->is_placed) {
+        continue;
+      }
+      int w = item->surface->w + ATLAS_PADDING;
+      int h = item->surface->h + ATLAS_PADDING;
+      if (x + w > ATLAS_PAGE_SIZE) {
+        x = 0;
+        y += shelf_height;
+        shelf_height = 0;
+      }
+      if (y + h > ATLAS_PAGE_SIZE) {
+        continue;
+      }
+      SDL_Rect source = {
+          .x = x, .y = y, .w = item->surface->w, .h = item->surface->h};
+      SDL_BlitSurface(item->surface, NULL, sheet, &source);
+      regions[item->index].source = source;
+      item->page = page;
+      item->is_placed = true;
+      num_placed++;
+      x += w;
+      shelf_height = h > shelf_height ? h : shelf_height;
+    }
+    SDL_Texture *texture = create_texture(sdl, sheet);
+    assert(texture != NULL);
+    SDL_FreeSurface(sheet);
+    list_add(pages, texture);
+    for (size_t i = 0; i < num_items; i++) {
+      if (items[i].is_placed && items[i].page == page) {
+        regions[items[i].index].texture = texture;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_items; i++) {
+    SDL_FreeSurface(items[i].surface);
+  }
+  free(items);
+}
+
+tiled_image_t *sdl_load_tiled_image(sdl_context_t *sdl, const char *path) {
+  SDL_Surface *loaded = IMG_Load(path);
+  assert(loaded != NULL);
+  tiled_image_t *image = malloc(sizeof(tiled_image_t));
+  assert(image != NULL);
+  image->sdl = sdl;
+  image->pixels = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+  assert(image->pixels != NULL);
+  SDL_FreeSurface(loaded);
+  image->cols = (image->pixels->w + TILE_SIZE - 1) / TILE_SIZE;
+  image->rows = (image->pixels->h + TILE_SIZE - 1) / TILE_SIZE;
+  image->tiles = calloc(image->cols * image->rows, sizeof(tile_t));
+  assert(image->tiles != NULL);
+  image->num_resident = 0;
+  image->frame = 0;
+  image->has_last_destination = false;
+  return image;
+}
+
+void sdl_free_tiled_image(tiled_image_t *image) {
+  for (size_t i = 0; i < image->cols * image->rows; i++) {
+    if (image->tiles[i].texture != NULL) {
+      sdl_destroy_texture(image->sdl, image->tiles[i].texture);
+    }
+  }
+  free(image->tiles);
+  SDL_FreeSurface(image->pixels);
+  free(image);
+}
+
+/**
+ * Finds the tiles overlapping a box in window coordinates, when the whole
+ * image is drawn at `destination`.
+ *
+ * @return false if the box misses the image
+ */
+static bool tile_range(tiled_image_t *image, SDL_Rect destination,
+                       vector_t min, vector_t max, size_t lo[2],
+                       size_t hi[2]) {
+  vector_t scale = {.x = (double)destination.w / image->pixels->w,
+                    .y = (double)destination.h / image->pixels->h};
+  vector_t from = {.x = (min.x - destination.x) / scale.x,
+                   .y = (min.y - destination.y) / scale.y};
+  vector_t to = {.x = (max.x - destination.x) / scale.x,
+                 .y = (max.y - destination.y) / scale.y};
+  if (to.x < 0 || to.y < 0 || from.x >= image->pixels->w ||
+      from.y >= image->pixels->h) {
+    return false;
+  }
+  lo[0] = (size_t)fmax(from.x, 0) / TILE_SIZE;
+  lo[1] = (size_t)fmax(from.y, 0) / TILE_SIZE;
+  hi[0] = (size_t)fmin(to.x, image->pixels->w - 1) / TILE_SIZE;
+  hi[1] = (size_t)fmin(to.y, image->pixels->h - 1) / TILE_SIZE;
+  return true;
+}
+
+/** Returns the pixels of a tile: its rectangle in the whole image */
+static SDL_Rect tile_source(tiled_image_t *image, size_t col, size_t row) {
+  SDL_Rect source = {.x = col * TILE_SIZE, .y = row * TILE_SIZE};
+  source.w = fmin(TILE_SIZE, image->pixels->w - source.x);
+  source.h = fmin(TILE_SIZE, image->pixels->h - source.y);
+  return source;
+}
+
+/** Uploads a tile's pixels to a new texture */
+static void tile_load(tiled_image_t *image, size_t col, size_t row) {
+  tile_t *tile = &image->tiles[row * image->cols + col];
+  SDL_Rect source = tile_source(image, col, row);
+  uint8_t *pixels = (uint8_t *)image->pixels->pixels +
+                    source.y * image->pixels->pitch +
+                    source.x * BYTES_PER_PIXEL;
+  // A surface over the tile's pixels in the whole image, so nothing is copied
+  SDL_Surface *view = SDL_CreateRGBSurfaceWithFormatFrom(
+      pixels, source.w, source.h, 32, image->pixels->pitch,
+      SDL_PIXELFORMAT_RGBA32);
+  assert(view != NULL);
+  tile->texture = create_texture(image->sdl, view);
+  assert(tile->texture != NULL);
+  SDL_FreeSurface(view);
+  image->num_resident++;
+}
+
+/**
+ * Frees the least recently used tiles until few enough are resident, without
+ * touching the tiles used this frame.
+ */
+static void tile_evict(tiled_image_t *image) {
+  while (image->num_resident > MAX_RESIDENT_TILES) {
+    tile_t *oldest = NULL;
+    for (size_t i = 0; i < image->cols * image->rows; i++) {
+      tile_t *tile = &image->tiles[i];
+      if (tile->texture != NULL && tile->last_used < image->frame &&
+          (oldest == NULL || tile->last_used < oldest->last_used)) {
+        oldest = tile;
+      }
+    }
+    if (oldest == NULL) {
+      return;
+    }
+    sdl_destroy_texture(image->sdl, oldest->texture);
+    oldest->texture = NULL;
+    image->num_resident--;
+  }
+}
+
+void sdl_draw_tiled_image(sdl_context_t *sdl, tiled_image_t *image,
+                          SDL_Rect destination) {
+  image->frame++;
+  vector_t window_max = get_window_size(sdl);
+  vector_t scale = {.x = (double)destination.w / image->pixels->w,
+                    .y = (double)destination.h / image->pixels->h};
+  size_t lo[2], hi[2];
+  if (tile_range(image, destination, VEC_ZERO, window_max, lo, hi)) {
+    for (size_t row = lo[1]; row <= hi[1]; row++) {
+      for (size_t col = lo[0]; col <= hi[0]; col++) {
+        tile_t *tile = &image->tiles[row * image->cols + col];
+        if (tile->texture == NULL) {
+          tile_load(image, col, row);
+        }
+        tile->last_used = image->frame;
+        // Round both edges of each tile, so neighbouring tiles meet exactly
+        SDL_Rect source = tile_source(image, col, row);
+        int x0 = destination.x + round(source.x * scale.x);
+        int y0 = destination.y + round(source.y * scale.y);
+        int x1 = destination.x + round((source.x + source.w) * scale.x);
+        int y1 = destination.y + round((source.y + source.h) * scale.y);
+        SDL_Rect tile_box = {.x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0};
+        sdl_draw_sprite(sdl, tile->texture, NULL, tile_box, 0);
+      }
+    }
+  }
+
+  // The image moves the opposite way to the camera, so look that far ahead
+  if (image->has_last_destination) {
+    vector_t motion = {.x = destination.x - image->last_destination.x,
+                       .y = destination.y - image->last_destination.y};
+    vector_t ahead = vec_multiply(-PREFETCH_FRAMES, motion);
+    size_t uploads = 0;
+    if (tile_range(image, destination, ahead, vec_add(window_max, ahead), lo,
+                   hi)) {
+      for (size_t row = lo[1]; row <= hi[1]; row++) {
+        for (size_t col = lo[0]; col <= hi[0]; col++) {
+          tile_t *tile = &image->tiles[row * image->cols + col];
+          if (tile->texture == NULL && uploads < MAX_PREFETCH_UPLOADS) {
+            tile_load(image, col, row);
+            uploads++;
+          }
+          tile->last_used = image->frame;
+        }
+      }
+    }
+  }
+  image->last_destination = destination;
+  image->has_last_destination = true;
+  tile_evict(image);
+}
+
+size_t sdl_tiled_image_resident(tiled_image_t *image) {
+  return image->num_resident;
 }
 
 TTF_Font *sdl_load_font(const char *path, size_t size) {
@@ -302,79 +1129,172 @@ TTF_Font *sdl_load_font(const char *path, size_t size) {
   return TTF_OpenFont(path, size);
 }
 
-void sdl_display_message(TTF_Font *font, const char *message, vector_t loc,
-                         SDL_Color color) {
+glyph_atlas_t *sdl_load_glyph_atlas(sdl_context_t *sdl, const char *path,
+                                    size_t size) {
+  TTF_Font *font = sdl_load_font(path, size);
   assert(font != NULL);
-  assert(message != NULL);
-
-  int32_t *w = malloc(sizeof(int32_t));
-  int32_t *h = malloc(sizeof(int32_t));
-  assert(w != NULL);
-  assert(h != NULL);
-  SDL_Surface *surface_message = TTF_RenderText_Solid(font, message, color);
-  SDL_Texture *texture_message =
-      SDL_CreateTextureFromSurface(renderer, surface_message);
-  TTF_SizeUTF8(font, message, w, h);
-
-  SDL_Rect *rectangle = malloc(sizeof(SDL_Rect));
-  assert(rectangle != NULL);
-  rectangle->x = loc.x;
-  rectangle->y = loc.y;
-  rectangle->w = *w;
-  rectangle->h = *h;
-
-  SDL_RenderCopy(renderer, texture_message, NULL, rectangle);
-
-  // Cleanup
-  free(rectangle);
-  free(w);
-  free(h);
-  SDL_FreeSurface(surface_message);
-  SDL_DestroyTexture(texture_message);
-}
-
-SDL_Rect sdl_get_bounding_box(body_t *body) {
-  double min_x = __DBL_MAX__;
-  double min_y = __DBL_MAX__;
-  double max_x = -__DBL_MAX__;
-  double max_y = -__DBL_MAX__;
-
-  vector_t window_center = get_window_center();
-  list_t *points = body_get_shape(body);
-  size_t num_points = list_size(points);
-
-  for (size_t i = 0; i < num_points; i++) {
-    vector_t *point = list_get(points, i);
-    if (min_x >= point->x) {
-      min_x = point->x;
-    } else if (max_x <= point->x) {
-      max_x = point->x;
+  glyph_atlas_t *atlas = malloc(sizeof(glyph_atlas_t));
+  assert(atlas != NULL);
+  atlas->sdl = sdl;
+  atlas->font = font;
+  atlas->height = TTF_FontHeight(font);
+
+  // Render every glyph once, in white so vertex colors can tint it
+  SDL_Color white = {.r = 255, .g = 255, .b = 255, .a = 255};
+  SDL_Surface *surfaces[ATLAS_NUM_GLYPHS];
+  int cell_width = 1;
+  for (size_t i = 0; i < ATLAS_NUM_GLYPHS; i++) {
+    uint16_t c = ATLAS_FIRST_GLYPH + i;
+    surfaces[i] = TTF_RenderGlyph_Blended(font, c, white);
+    int advance = 0;
+    TTF_GlyphMetrics(font, c, NULL, NULL, NULL, NULL, &advance);
+    atlas->glyphs[i].advance = advance;
+    if (surfaces[i] != NULL && surfaces[i]->w > cell_width) {
+      cell_width = surfaces[i]->w;
     }
-    if (min_y >= point->y) {
-      min_y = point->y;
-    } else if (max_y <= point->y) {
-      max_y = point->y;
+  }
+
+  // Pack the glyphs into a grid of equal cells
+  int cols = ATLAS_COLUMNS;
+  int rows = (ATLAS_NUM_GLYPHS + cols - 1) / cols;
+  SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(
+      0, cols * cell_width, rows * atlas->height, 32, SDL_PIXELFORMAT_RGBA32);
+  assert(sheet != NULL);
+  for (size_t i = 0; i < ATLAS_NUM_GLYPHS; i++) {
+    SDL_Rect cell = {.x = (i % cols) * cell_width,
+                     .y = (i / cols) * atlas->height,
+                     .w = 0,
+                     .h = 0};
+    if (surfaces[i] != NULL) {
+      cell.w = surfaces[i]->w;
+      cell.h = surfaces[i]->h;
+      // Copy the alpha channel instead of blending onto the empty sheet
+      SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+      SDL_BlitSurface(surfaces[i], NULL, sheet, &cell);
+      SDL_FreeSurface(surfaces[i]);
     }
+    atlas->glyphs[i].source = cell;
   }
+  atlas->texture = create_texture(sdl, sheet);
+  assert(atlas->texture != NULL);
+  atlas->texture_size = (vector_t){.x = sheet->w, .y = sheet->h};
+  SDL_FreeSurface(sheet);
+  return atlas;
+}
 
-  vector_t top_left = {.x = min_x, .y = max_y};
-  top_left = get_window_position(top_left, window_center);
-  free(points);
+void sdl_free_glyph_atlas(glyph_atlas_t *atlas) {
+  // Drop the atlas's cached strings, so a later atlas at the same address
+  // can't be given them
+  sdl_context_t *sdl = atlas->sdl;
+  text_entry_t *entry = sdl->oldest_text;
+  while (entry != NULL) {
+    text_entry_t *newer = entry->newer;
+    if (entry->key.atlas == atlas) {
+      text_entry_free(sdl, entry);
+    }
+    entry = newer;
+  }
+  TTF_CloseFont(atlas->font);
+  sdl_destroy_texture(sdl, atlas->texture);
+  free(atlas);
+}
 
-  SDL_Rect bounding_box = {
-      .x = top_left.x, .y = top_left.y, .w = max_x - min_x, .h = max_y - min_y};
+void sdl_draw_text(sdl_context_t *sdl, glyph_atlas_t *atlas, const char *text,
+                   vector_t loc, SDL_Color color) {
+  assert(text != NULL);
+  double pen = loc.x;
+  for (const char *c = text; *c != '\0'; c++) {
+    size_t index = (unsigned char)*c - ATLAS_FIRST_GLYPH;
+    if (index >= ATLAS_NUM_GLYPHS) {
+      index = '?' - ATLAS_FIRST_GLYPH;
+    }
+    const glyph_t *glyph = &atlas->glyphs[index];
+    SDL_Rect source = glyph->source;
+    if (source.w > 0) {
+      float u0 = source.x / atlas->texture_size.x;
+      float v0 = source.y / atlas->texture_size.y;
+      float u1 = (source.x + source.w) / atlas->texture_size.x;
+      float v1 = (source.y + source.h) / atlas->texture_size.y;
+      float x0 = pen, y0 = loc.y;
+      float x1 = x0 + source.w, y1 = y0 + source.h;
+      // Glyphs share the sprite batches, so a string is one draw call
+      SDL_Vertex *quad = batch_quad(sdl, atlas->texture);
+      quad[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+      quad[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+      quad[2] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+      quad[3] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+    }
+    pen += glyph->advance;
+  }
+}
+
+void sdl_draw_cached_text(sdl_context_t *sdl, glyph_atlas_t *atlas,
+                          const char *text, vector_t loc, SDL_Color color) {
+  assert(text != NULL);
+  sdl_flush_sprites(sdl);
+  text_key_t key = {.atlas = atlas, .text = text, .color = color};
+  text_entry_t *entry = hash_map_get(sdl->text_cache, &key);
+  if (entry != NULL) {
+    sdl->text_stats.hits++;
+    text_unlink(sdl, entry);
+    text_push_newest(sdl, entry);
+  } else {
+    sdl->text_stats.misses++;
+    SDL_Surface *surface = TTF_RenderText_Blended(atlas->font, text, color);
+    if (surface == NULL) {
+      return; // e.g. an empty string
+    }
+    entry = draw_realloc(sdl, NULL, sizeof(text_entry_t));
+    size_t length = strlen(text);
+    char *copy = draw_realloc(sdl, NULL, length + 1);
+    memcpy(copy, text, length + 1);
+    entry->key = (text_key_t){.atlas = atlas, .text = copy, .color = color};
+    entry->texture = create_texture(sdl, surface);
+    entry->w = surface->w;
+    entry->h = surface->h;
+    SDL_FreeSurface(surface);
+    hash_map_put(sdl->text_cache, &entry->key, entry);
+    text_push_newest(sdl, entry);
+    sdl->text_stats.bytes += (size_t)entry->w * entry->h * BYTES_PER_PIXEL;
+    sdl->text_stats.entries++;
+    // Evict the least recently drawn strings, but never the one being drawn
+    while (sdl->text_stats.bytes > TEXT_CACHE_BUDGET &&
+           sdl->oldest_text != entry) {
+      text_entry_free(sdl, sdl->oldest_text);
+      sdl->text_stats.evictions++;
+    }
+  }
+  SDL_Rect destination = {
+      .x = loc.x, .y = loc.y, .w = entry->w, .h = entry->h};
+  draw_command_t *command = push_command(sdl, DRAW_COPY);
+  command->texture = entry->texture;
+  command->rect = destination;
+}
 
+text_cache_stats_t sdl_get_text_cache_stats(sdl_context_t *sdl) {
+  return sdl->text_stats;
+}
+
+SDL_Rect sdl_get_bounding_box(sdl_context_t *sdl, body_t *body) {
+  vector_t min, max;
+  polygon_get_bounds(body_get_polygon(body), &min, &max);
+  vector_t top_left = {.x = min.x, .y = max.y};
+  top_left = get_window_position(sdl, top_left);
+  SDL_Rect bounding_box = {.x = top_left.x,
+                           .y = top_left.y,
+                           .w = max.x - min.x,
+                           .h = max.y - min.y};
   return bounding_box;
 }
 
-SDL_Rect sdl_update_bounding_box_body(body_t *body, SDL_Rect bounding_box) {
+SDL_Rect sdl_update_bounding_box_body(sdl_context_t *sdl, body_t *body,
+                                      SDL_Rect bounding_box) {
 
   vector_t centroid = body_get_centroid(body);
-  vector_t window_center = get_window_center();
 
   vector_t top_left = {.x = centroid.x - bounding_box.w / 2,
                        .y = centroid.y + bounding_box.h / 2};
-  top_left = get_window_position(top_left, window_center);
+  top_left = get_window_position(sdl, top_left);
 
   SDL_Rect next_bounding_box = {.x = top_left.x,
                                 .y = top_left.y,
@@ -382,4 +1302,8 @@ SDL_Rect sdl_update_bounding_box_body(body_t *body, SDL_Rect bounding_box) {
                                 .h = bounding_box.h};
 
   return next_bounding_box;
-}
\ No newline at end of file
+}
+
+size_t sdl_get_frame_allocations(sdl_context_t *sdl) {
+  return sdl->last_frame_allocations;
+}
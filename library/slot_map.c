@@ -0,0 +1,146 @@
+#include "slot_map.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+/**
+ * An entry in the sparse array that handles index into.
+ * While a slot is occupied, `dense` is the index of its value in the packed
+ * arrays; while it is free, `dense` is the next free slot.
+ */
+typedef struct slot {
+  uint32_t generation;
+  uint32_t dense;
+  bool occupied;
+} slot_t;
+
+struct slot_map {
+  slot_t *slots;
+  size_t num_slots;
+  uint32_t free_head;
+
+  // The values, packed together, and the slot each one is in
+  void **values;
+  uint32_t *value_slots;
+  size_t size;
+
+  size_t capacity; // of the slots and the packed arrays alike
+  free_func_t freer;
+};
+
+slot_map_t *slot_map_init(size_t initial_size, free_func_t freer) {
+  slot_map_t *map = malloc(sizeof(slot_map_t));
+  assert(map != NULL);
+  map->capacity = initial_size > 0 ? initial_size : 1;
+  map->slots = malloc(map->capacity * sizeof(slot_t));
+  map->values = malloc(map->capacity * sizeof(void *));
+  map->value_slots = malloc(map->capacity * sizeof(uint32_t));
+  assert(map->slots != NULL && map->values != NULL &&
+         map->value_slots != NULL);
+  map->num_slots = 0;
+  map->free_head = NO_FREE_SLOT;
+  map->size = 0;
+  map->freer = freer;
+  return map;
+}
+
+void slot_map_free(slot_map_t *map) {
+  if (map->freer != NULL) {
+    for (size_t i = 0; i < map->size; i++) {
+      map->freer(map->values[i]);
+    }
+  }
+  free(map->slots);
+  free(map->values);
+  free(map->value_slots);
+  free(map);
+}
+
+size_t slot_map_size(slot_map_t *map) { return map->size; }
+
+/**
+ * Doubles the capacity of a full slot map.
+ */
+static void slot_map_grow(slot_map_t *map) {
+  assert(map->capacity < NO_FREE_SLOT / 2);
+  map->capacity *= 2;
+  map->slots = realloc(map->slots, map->capacity * sizeof(slot_t));
+  map->values = realloc(map->values, map->capacity * sizeof(void *));
+  map->value_slots =
+      realloc(map->value_slots, map->capacity * sizeof(uint32_t));
+  assert(map->slots != NULL && map->values != NULL &&
+         map->value_slots != NULL);
+}
+
+handle_t slot_map_insert(slot_map_t *map, void *value) {
+  assert(value != NULL);
+  uint32_t index = map->free_head;
+  if (index != NO_FREE_SLOT) {
+    map->free_head = map->slots[index].dense;
+  } else {
+    if (map->num_slots == map->capacity) {
+      slot_map_grow(map);
+    }
+    index = map->num_slots++;
+    map->slots[index].generation = 1; // so the zero handle is never valid
+  }
+  slot_t *slot = &map->slots[index];
+  slot->occupied = true;
+  slot->dense = map->size;
+  map->values[map->size] = value;
+  map->value_slots[map->size] = index;
+  map->size++;
+  return (handle_t){.index = index, .generation = slot->generation};
+}
+
+/**
+ * Returns the occupied slot a handle refers to, or NULL if it is stale.
+ */
+static slot_t *slot_map_find(slot_map_t *map, handle_t handle) {
+  if (handle.index >= map->num_slots) {
+    return NULL;
+  }
+  slot_t *slot = &map->slots[handle.index];
+  if (!slot->occupied || slot->generation != handle.generation) {
+    return NULL;
+  }
+  return slot;
+}
+
+void *slot_map_get(slot_map_t *map, handle_t handle) {
+  slot_t *slot = slot_map_find(map, handle);
+  return slot != NULL ? map->values[slot->dense] : NULL;
+}
+
+void *slot_map_remove(slot_map_t *map, handle_t handle) {
+  slot_t *slot = slot_map_find(map, handle);
+  if (slot == NULL) {
+    return NULL;
+  }
+  void *value = map->values[slot->dense];
+  // Move the last value into the hole
+  size_t last = map->size - 1;
+  map->values[slot->dense] = map->values[last];
+  map->value_slots[slot->dense] = map->value_slots[last];
+  map->slots[map->value_slots[slot->dense]].dense = slot->dense;
+  map->size--;
+
+  slot->occupied = false;
+  slot->generation++;
+  slot->dense = map->free_head;
+  map->free_head = handle.index;
+  return value;
+}
+
+void *slot_map_get_at(slot_map_t *map, size_t index) {
+  assert(index < map->size);
+  return map->values[index];
+}
+
+handle_t slot_map_handle_at(slot_map_t *map, size_t index) {
+  assert(index < map->size);
+  uint32_t slot = map->value_slots[index];
+  return (handle_t){.index = slot,
+                    .generation = map->slots[slot].generation};
+}
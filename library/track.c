@@ -0,0 +1,194 @@
+#include "track.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct track {
+  const uint8_t *data;
+  size_t size;
+  const track_header_t *header;
+};
+
+/**
+ * Checks that a section of `count` elements of `elem_size` bytes starting at
+ * `offset` is aligned and lies entirely inside the file.
+ */
+static bool section_is_valid(size_t file_size, uint32_t offset, size_t count,
+                             size_t elem_size) {
+  if (offset % sizeof(double) != 0 || offset > file_size) {
+    return false;
+  }
+  return (file_size - offset) / elem_size >= count;
+}
+
+/**
+ * Validates everything in the header that the accessors rely on.
+ */
+static bool header_is_valid(const track_header_t *header, size_t file_size,
+                            const char *path) {
+  if (header->magic != TRACK_MAGIC) {
+    fprintf(stderr, "%s is not a compiled track\n", path);
+    return false;
+  }
+  if (header->version != TRACK_VERSION) {
+    fprintf(stderr, "%s has track version %u, expected %u\n", path,
+            header->version, TRACK_VERSION);
+    return false;
+  }
+  if (header->file_size != file_size ||
+      memchr(header->background_path, '\0', TRACK_PATH_MAX) == NULL) {
+    fprintf(stderr, "%s is truncated or corrupt\n", path);
+    return false;
+  }
+  size_t num_cells = (size_t)header->grid.cols * header->grid.rows;
+  bool valid =
+      header->num_gates >= 2 && header->num_path == header->num_gates &&
+      header->grid.cell_size > 0 && num_cells > 0 &&
+      section_is_valid(file_size, header->walls_offset, header->num_walls,
+                       sizeof(track_wall_t)) &&
+      section_is_valid(file_size, header->gates_offset, header->num_gates,
+                       sizeof(track_gate_t)) &&
+      section_is_valid(file_size, header->path_offset, header->num_path,
+                       sizeof(track_path_point_t)) &&
+      section_is_valid(file_size, header->boxes_offset, header->num_boxes,
+                       sizeof(vector_t)) &&
+      section_is_valid(file_size, header->cells_offset, num_cells + 1,
+                       sizeof(uint32_t)) &&
+      section_is_valid(file_size, header->cell_walls_offset,
+                       header->num_cell_walls, sizeof(uint32_t));
+  if (!valid) {
+    fprintf(stderr, "%s has a section outside of the file\n", path);
+    return false;
+  }
+  const uint32_t *cells =
+      (const uint32_t *)((const uint8_t *)header + header->cells_offset);
+  const uint32_t *cell_walls =
+      (const uint32_t *)((const uint8_t *)header + header->cell_walls_offset);
+  bool grid_valid =
+      cells[0] == 0 && cells[num_cells] == header->num_cell_walls;
+  for (size_t i = 0; grid_valid && i < num_cells; i++) {
+    grid_valid = cells[i] <= cells[i + 1];
+  }
+  for (size_t i = 0; grid_valid && i < header->num_cell_walls; i++) {
+    grid_valid = cell_walls[i] < header->num_walls;
+  }
+  if (!grid_valid) {
+    fprintf(stderr, "%s has a corrupt wall grid\n", path);
+    return false;
+  }
+  return true;
+}
+
+track_t *track_load(const char *path) {
+  assert(path != NULL);
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Couldn't open track %s\n", path);
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(track_header_t)) {
+    fprintf(stderr, "%s is too small to be a track\n", path);
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file alive
+  if (data == MAP_FAILED) {
+    fprintf(stderr, "Couldn't map track %s\n", path);
+    return NULL;
+  }
+  if (!header_is_valid(data, size, path)) {
+    munmap(data, size);
+    return NULL;
+  }
+  track_t *track = malloc(sizeof(track_t));
+  assert(track != NULL);
+  track->data = data;
+  track->size = size;
+  track->header = data;
+  return track;
+}
+
+void track_free(track_t *track) {
+  munmap((void *)track->data, track->size);
+  free(track);
+}
+
+const char *track_get_background_path(track_t *track) {
+  return track->header->background_path;
+}
+
+void track_get_background_bounds(track_t *track, vector_t *min, vector_t *max) {
+  *min = track->header->background_min;
+  *max = track->header->background_max;
+}
+
+vector_t track_get_spawn(track_t *track) { return track->header->spawn; }
+
+double track_get_spawn_rotation(track_t *track) {
+  return track->header->spawn_rotation;
+}
+
+const track_wall_t *track_get_walls(track_t *track, size_t *count) {
+  *count = track->header->num_walls;
+  return (const track_wall_t *)(track->data + track->header->walls_offset);
+}
+
+const track_gate_t *track_get_gates(track_t *track, size_t *count) {
+  *count = track->header->num_gates;
+  return (const track_gate_t *)(track->data + track->header->gates_offset);
+}
+
+const track_path_point_t *track_get_path(track_t *track, size_t *count) {
+  *count = track->header->num_path;
+  return (const track_path_point_t *)(track->data +
+                                      track->header->path_offset);
+}
+
+double track_get_path_length(track_t *track) {
+  return track->header->path_length;
+}
+
+const vector_t *track_get_boxes(track_t *track, size_t *count) {
+  *count = track->header->num_boxes;
+  return (const vector_t *)(track->data + track->header->boxes_offset);
+}
+
+track_grid_t track_get_grid(track_t *track) { return track->header->grid; }
+
+const uint32_t *track_get_cell_walls(track_t *track, size_t col, size_t row,
+                                     size_t *count) {
+  track_grid_t grid = track->header->grid;
+  assert(col < grid.cols && row < grid.rows);
+  const uint32_t *cells =
+      (const uint32_t *)(track->data + track->header->cells_offset);
+  const uint32_t *cell_walls =
+      (const uint32_t *)(track->data + track->header->cell_walls_offset);
+  size_t cell = row * grid.cols + col;
+  *count = cells[cell + 1] - cells[cell];
+  return cell_walls + cells[cell];
+}
+
+bool track_get_cell_range(track_t *track, vector_t min, vector_t max,
+                          size_t lo[2], size_t hi[2]) {
+  track_grid_t grid = track->header->grid;
+  vector_t from = vec_multiply(1 / grid.cell_size, vec_subtract(min, grid.min));
+  vector_t to = vec_multiply(1 / grid.cell_size, vec_subtract(max, grid.min));
+  if (to.x < 0 || to.y < 0 || from.x >= grid.cols || from.y >= grid.rows) {
+    return false;
+  }
+  lo[0] = (size_t)fmax(from.x, 0);
+  lo[1] = (size_t)fmax(from.y, 0);
+  hi[0] = (size_t)fmin(to.x, grid.cols - 1);
+  hi[1] = (size_t)fmin(to.y, grid.rows - 1);
+  return true;
+}
@@ -0,0 +1,70 @@
+#include "arena.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_arena_alignment() {
+  arena_t *arena = arena_init(64);
+  for (size_t size = 1; size < 40; size++) {
+    char *memory = arena_alloc(arena, size);
+    assert((uintptr_t)memory % alignof(max_align_t) == 0);
+    memset(memory, 0xAB, size);
+  }
+  arena_free(arena);
+}
+
+void test_arena_separate() {
+  arena_t *arena = arena_init(100);
+  int *values[50];
+  for (int i = 0; i < 50; i++) {
+    values[i] = arena_alloc(arena, sizeof(int));
+    *values[i] = i;
+  }
+  // An allocation larger than a chunk gets its own
+  double *big = arena_alloc(arena, 1000 * sizeof(double));
+  for (size_t i = 0; i < 1000; i++) {
+    big[i] = i;
+  }
+  for (int i = 0; i < 50; i++) {
+    assert(*values[i] == i);
+  }
+  assert(arena_used(arena) >= 50 * sizeof(int) + 1000 * sizeof(double));
+  arena_free(arena);
+}
+
+void test_arena_reset() {
+  arena_t *arena = arena_init(256);
+  void *first = arena_alloc(arena, 16);
+  for (int i = 0; i < 100; i++) {
+    arena_alloc(arena, 24);
+  }
+  arena_reset(arena);
+  assert(arena_used(arena) == 0);
+  // The chunks are reused from the start
+  assert(arena_alloc(arena, 16) == first);
+  for (int i = 0; i < 100; i++) {
+    int *value = arena_alloc(arena, sizeof(int));
+    *value = i;
+  }
+  arena_free(arena);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_arena_alignment)
+  DO_TEST(test_arena_separate)
+  DO_TEST(test_arena_reset)
+
+  puts("arena_test PASS");
+}
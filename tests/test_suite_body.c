@@ -30,6 +30,35 @@ void test_body_init() {
   body_free(body);
 }
 
+// Tests that bodies built from a rectangle or an array of vertices match the
+// same shape built from a list, with and without an arena
+void test_body_init_rect() {
+  vector_t v[] = {{1, 1}, {3, 1}, {3, 2}, {1, 2}};
+  const size_t VERTICES = sizeof(v) / sizeof(*v);
+  rgb_color_t color = {0, 0.5, 1};
+  arena_t *arena = arena_init(1024);
+  body_t *bodies[] = {
+      body_init_rect(NULL, (vector_t){2, 1.5}, 2, 1, 3, color, NULL, NULL),
+      body_init_rect(arena, (vector_t){2, 1.5}, 2, 1, 3, color, NULL, NULL),
+      body_init_span(NULL, (vertex_span_t){.data = v, .size = VERTICES}, 3,
+                     color, NULL, NULL),
+      body_init_span(arena, (vertex_span_t){.data = v, .size = VERTICES}, 3,
+                     color, NULL, NULL)};
+  for (size_t i = 0; i < sizeof(bodies) / sizeof(*bodies); i++) {
+    body_t *body = bodies[i];
+    vertex_span_t span = polygon_get_vertices(body_get_polygon(body));
+    assert(span.size == VERTICES);
+    for (size_t j = 0; j < VERTICES; j++) {
+      assert(vec_isclose(span.data[j], v[j]));
+    }
+    assert(vec_isclose(body_get_centroid(body), (vector_t){2, 1.5}));
+    assert(body_get_color(body)->g == color.g);
+    assert(body_get_mass(body) == 3);
+    body_free(body);
+  }
+  arena_free(arena);
+}
+
 void test_body_setters() {
   list_t *shape = list_init(3, free);
   vector_t *v = malloc(sizeof(*v));
@@ -199,6 +228,35 @@ void test_body_remove() {
   body_free(body);
 }
 
+void test_body_kinematic() {
+  list_t *shape = list_init(3, free);
+  vector_t *v = malloc(sizeof(*v));
+  *v = (vector_t){+1, 0};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){0, +1};
+  list_add(shape, v);
+  v = malloc(sizeof(*v));
+  *v = (vector_t){-1, 0};
+  list_add(shape, v);
+  body_t *body = body_init(shape, 1, (rgb_color_t){0, 0, 0});
+  vector_t start = body_get_centroid(body);
+  assert(!body_is_kinematic(body));
+  body_set_kinematic(body, true);
+  assert(body_is_kinematic(body));
+  // Kinematic bodies ignore their velocity and forces
+  body_set_velocity(body, (vector_t){1, 2});
+  body_add_force(body, (vector_t){3, 4});
+  body_tick(body, 1);
+  assert(vec_isclose(body_get_centroid(body), start));
+  // ...but can still be moved by hand, and the forces don't carry over
+  body_set_centroid(body, (vector_t){5, 6});
+  body_set_kinematic(body, false);
+  body_tick(body, 1);
+  assert(vec_isclose(body_get_centroid(body), (vector_t){6, 8}));
+  body_free(body);
+}
+
 void test_body_info() {
   list_t *shape = list_init(3, free);
   vector_t *v = malloc(sizeof(*v));
@@ -248,6 +306,29 @@ void test_body_info_freer() {
   body_free(body);
 }
 
+// Polygons with more vertices than fit inline are stored on the heap
+void test_body_many_vertices() {
+  const size_t VERTICES = 7;
+  list_t *shape = list_init(VERTICES, free);
+  for (size_t i = 0; i < VERTICES; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = vec_rotate((vector_t){1, 0}, 2 * M_PI * i / VERTICES);
+    list_add(shape, v);
+  }
+  body_t *body = body_init(shape, 1, (rgb_color_t){0, 0, 0});
+  assert(vec_isclose(body_get_centroid(body), VEC_ZERO));
+  body_set_centroid(body, (vector_t){3, 4});
+  body_set_rotation(body, M_PI / 2);
+  vertex_span_t vertices = polygon_get_vertices(body_get_polygon(body));
+  assert(vertices.size == VERTICES);
+  for (size_t i = 0; i < VERTICES; i++) {
+    vector_t offset = vec_rotate((vector_t){0, 1}, 2 * M_PI * i / VERTICES);
+    vector_t expected = vec_add((vector_t){3, 4}, offset);
+    assert(vec_isclose(vertices.data[i], expected));
+  }
+  body_free(body);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -258,13 +339,16 @@ int main(int argc, char *argv[]) {
   }
 
   DO_TEST(test_body_init)
+  DO_TEST(test_body_init_rect)
   DO_TEST(test_body_setters)
   DO_TEST(test_body_tick)
   DO_TEST(test_infinite_mass)
   DO_TEST(test_forces)
   DO_TEST(test_body_remove)
+  DO_TEST(test_body_kinematic)
   DO_TEST(test_body_info)
   DO_TEST(test_body_info_freer)
+  DO_TEST(test_body_many_vertices)
 
   puts("body_test PASS");
 }
@@ -1,5 +1,7 @@
+#include "collision.h"
 #include "forces.h"
 #include "test_util.h"
+#include "track.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
@@ -95,6 +97,352 @@ void test_forces_removed() {
   scene_free(scene);
 }
 
+// Tests polygons against segments, capsules and circles
+void test_polygon_segment() {
+  vector_t vertices[] = {{-1, -1}, {+1, -1}, {+1, +1}, {-1, +1}};
+  vertex_span_t square = {.data = vertices, .size = 4};
+  double depth;
+  // A segment crossing the top edge of the square
+  collision_info_t info = find_collision_polygon_segment(
+      square, (vector_t){-2, 0.75}, (vector_t){2, 0.75}, 0, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  assert(isclose(depth, 0.25));
+  // Missed as a segment, but hit as a capsule
+  info = find_collision_polygon_segment(square, (vector_t){-2, 1.5},
+                                        (vector_t){2, 1.5}, 0, NULL);
+  assert(!info.collided);
+  info = find_collision_polygon_segment(square, (vector_t){-2, 1.5},
+                                        (vector_t){2, 1.5}, 1, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  assert(isclose(depth, 0.5));
+  // The rounded end of a capsule misses the corner of the square
+  info = find_collision_polygon_segment(square, (vector_t){1.5, 1.5},
+                                        (vector_t){3, 3}, 0.6, NULL);
+  assert(!info.collided);
+  // A circle to the left of the square
+  info = find_collision_polygon_segment(square, (vector_t){-1.5, 0},
+                                        (vector_t){-1.5, 0}, 1, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){-1, 0}));
+  assert(isclose(depth, 0.5));
+}
+
+// Tests circles against segments, capsules and other circles
+void test_circle_segment() {
+  double depth;
+  collision_info_t info = find_collision_circle_segment(
+      (vector_t){0, 0}, 1, (vector_t){-5, 0.5}, (vector_t){5, 0.5}, 0, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, 1}));
+  assert(isclose(depth, 0.5));
+  // Past the end of the segment
+  info = find_collision_circle_segment((vector_t){0, 0}, 1, (vector_t){1, 1},
+                                       (vector_t){5, 1}, 0, NULL);
+  assert(!info.collided);
+  info = find_collision_circle_segment((vector_t){0, 0}, 1, (vector_t){1, 1},
+                                       (vector_t){5, 1}, 0.5, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){sqrt(2) / 2, sqrt(2) / 2}));
+  assert(isclose(depth, 1.5 - sqrt(2)));
+  // Two circles
+  info = find_collision_circle_segment((vector_t){0, 0}, 1, (vector_t){0, -3},
+                                       (vector_t){0, -3}, 2.5, &depth);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){0, -1}));
+  assert(isclose(depth, 0.5));
+}
+
+// Tests rays against segments, capsules and circles
+void test_raycast_segment() {
+  double distance;
+  vector_t normal;
+  // Straight into a segment, from either side
+  assert(raycast_segment((vector_t){0, 0}, (vector_t){1, 0}, 10,
+                         (vector_t){5, -1}, (vector_t){5, 1}, 0, &distance,
+                         &normal));
+  assert(isclose(distance, 5));
+  assert(vec_isclose(normal, (vector_t){-1, 0}));
+  assert(raycast_segment((vector_t){10, 0}, (vector_t){-1, 0}, 10,
+                         (vector_t){5, -1}, (vector_t){5, 1}, 0, &distance,
+                         &normal));
+  assert(vec_isclose(normal, (vector_t){1, 0}));
+  // Too short, past the end, and parallel
+  assert(!raycast_segment((vector_t){0, 0}, (vector_t){1, 0}, 4,
+                          (vector_t){5, -1}, (vector_t){5, 1}, 0, &distance,
+                          &normal));
+  assert(!raycast_segment((vector_t){0, 2}, (vector_t){1, 0}, 10,
+                          (vector_t){5, -1}, (vector_t){5, 1}, 0, &distance,
+                          &normal));
+  assert(!raycast_segment((vector_t){0, 0}, (vector_t){1, 0}, 10,
+                          (vector_t){1, 1}, (vector_t){5, 1}, 0, &distance,
+                          &normal));
+  // Past the end, but into the rounded end of a capsule
+  assert(raycast_segment((vector_t){0, 2}, (vector_t){1, 0}, 10,
+                         (vector_t){5, -1}, (vector_t){5, 1}, 1, &distance,
+                         &normal));
+  assert(isclose(distance, 5));
+  assert(vec_isclose(normal, (vector_t){0, 1}));
+  // The flat side of a capsule
+  assert(raycast_segment((vector_t){0, 0}, (vector_t){1, 0}, 10,
+                         (vector_t){5, -1}, (vector_t){5, 1}, 1, &distance,
+                         &normal));
+  assert(isclose(distance, 4));
+  // A circle, and a ray starting inside it
+  assert(raycast_segment((vector_t){0, 0}, (vector_t){0, 1}, 10,
+                         (vector_t){0, 5}, (vector_t){0, 5}, 2, &distance,
+                         &normal));
+  assert(isclose(distance, 3));
+  assert(vec_isclose(normal, (vector_t){0, -1}));
+  assert(!raycast_segment((vector_t){0, 4}, (vector_t){0, 1}, 10,
+                          (vector_t){0, 5}, (vector_t){0, 5}, 2, &distance,
+                          &normal));
+}
+
+// Tests that find_collision() dispatches on the collider types of the bodies
+void test_circle_bodies() {
+  body_t *circle = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_circle_collider(circle, 1);
+  body_t *square = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  // The corner of the square is inside the circle's box but not the circle
+  body_set_centroid(square, (vector_t){1.8, 1.8});
+  assert(!find_collision(circle, square).collided);
+  assert(!find_collision(square, circle).collided);
+  body_set_centroid(square, (vector_t){1.5, 0});
+  collision_info_t info = find_collision(circle, square);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){1, 0}));
+  info = find_collision(square, circle);
+  assert(info.collided);
+  assert(vec_isclose(info.axis, (vector_t){-1, 0}));
+  body_free(circle);
+  body_free(square);
+}
+
+void count_collision(body_t *body1, body_t *body2, vector_t axis, void *aux,
+                     double force_const) {
+  (*(int *)aux)++;
+}
+
+// Tests that group collisions find the same pairs as pairwise collisions,
+// and only call the handler when a pair starts colliding
+void test_group_collision() {
+  scene_t *scene = scene_init();
+  list_t *group = list_init(4, NULL);
+  list_t *evens = list_init(2, NULL);
+  list_t *odds = list_init(2, NULL);
+  double xs[] = {0, 1.5, 10, 11};
+  for (size_t i = 0; i < 4; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){xs[i], 0});
+    scene_add_body(scene, body);
+    list_add(group, body);
+    list_add(i % 2 == 0 ? evens : odds, body);
+  }
+  int within = 0;
+  int across = 0;
+  create_group_collision(scene, group, NULL, count_collision, &within, 0);
+  create_group_collision(scene, evens, odds, count_collision, &across, 0);
+  scene_tick(scene, 1);
+  scene_tick(scene, 1);
+  assert(within == 2);
+  assert(across == 2);
+  // Separate the last pair, then bring it back together
+  body_t *last = list_get(group, 3);
+  body_set_centroid(last, (vector_t){20, 0});
+  scene_tick(scene, 1);
+  body_set_centroid(last, (vector_t){0.5, 0});
+  scene_tick(scene, 1);
+  // The last body now collides with the first two, and not the third
+  assert(within == 4);
+  assert(across == 3);
+  list_free(group);
+  list_free(evens);
+  list_free(odds);
+  scene_free(scene);
+}
+
+// Tests that a group of 64 bodies packed into a grid finds every touching
+// pair through the broadphase, the same pairs a brute force check finds
+void test_group_collision_64() {
+  const size_t side = 8;
+  scene_t *scene = scene_init();
+  list_t *group = list_init(side * side, NULL);
+  for (size_t i = 0; i < side * side; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    // Rows are staggered so that not every neighbour touches
+    double x = (i % side) * 1.5 + (i / side % 2) * 0.75;
+    body_set_centroid(body, (vector_t){x, (i / side) * 1.9});
+    scene_add_body(scene, body);
+    list_add(group, body);
+  }
+  int expected = 0;
+  for (size_t i = 0; i < side * side; i++) {
+    for (size_t j = i + 1; j < side * side; j++) {
+      if (find_collision(list_get(group, i), list_get(group, j)).collided) {
+        expected++;
+      }
+    }
+  }
+  int within = 0;
+  create_group_collision(scene, group, NULL, count_collision, &within, 0);
+  scene_tick(scene, 1);
+  assert(expected > 0);
+  assert(within == expected);
+  // The pairs that keep touching don't call the handler again
+  scene_tick(scene, 1);
+  assert(within == expected);
+  list_free(group);
+  scene_free(scene);
+}
+
+// Tests that a body whose collisions are reset calls the handlers again,
+// while the pairs without it still wait for a new contact
+void test_reset_collisions() {
+  scene_t *scene = scene_init();
+  list_t *group = list_init(3, NULL);
+  for (size_t i = 0; i < 3; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){i * 0.5, 0});
+    scene_add_body(scene, body);
+    list_add(group, body);
+  }
+  body_t *first = list_get(group, 0);
+  body_t *second = list_get(group, 1);
+  int pair = 0;
+  int within = 0;
+  create_collision(scene, first, second, count_collision, &pair, 0);
+  create_group_collision(scene, group, NULL, count_collision, &within, 0);
+  scene_tick(scene, 1);
+  scene_tick(scene, 1);
+  assert(pair == 1);
+  assert(within == 3);
+  // Only the pairs with the first body collide afresh
+  reset_collisions(scene, first);
+  scene_tick(scene, 1);
+  assert(pair == 2);
+  assert(within == 5);
+  list_free(group);
+  scene_free(scene);
+}
+
+// Tests that resetting a slot of a collision only forgets the pairs of the
+// body in that slot
+void test_collision_reset() {
+  scene_t *scene = scene_init();
+  list_t *group = list_init(3, NULL);
+  for (size_t i = 0; i < 3; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){i * 0.5, 0});
+    scene_add_body(scene, body);
+    list_add(group, body);
+  }
+  int pair = 0;
+  int within = 0;
+  collision_t *pair_collision =
+      create_collision(scene, list_get(group, 1), list_get(group, 2),
+                       count_collision, &pair, 0);
+  collision_t *group_collision =
+      create_group_collision(scene, group, NULL, count_collision, &within, 0);
+  scene_tick(scene, 1);
+  assert(pair == 1);
+  assert(within == 3);
+  // The last body is slot 1 of the pair and slot 2 of the group
+  collision_reset(pair_collision, 1);
+  collision_reset(group_collision, 2);
+  scene_tick(scene, 1);
+  assert(pair == 2);
+  assert(within == 5);
+  scene_tick(scene, 1);
+  assert(pair == 2);
+  assert(within == 5);
+  list_free(group);
+  scene_free(scene);
+}
+
+// Tests that a body driven into a track wall at a kart's top speed bounces off
+// it, even over a long frame, instead of tunneling through
+void test_track_wall_stops_body() {
+  const double WALL_RADIUS = 5;
+  const double TOP_SPEED = 250;
+  const double FRAME = 0.1;
+  track_t *track = track_load("assets/tracks/caltech.trk");
+  size_t num_walls;
+  const track_wall_t *walls = track_get_walls(track, &num_walls);
+  // The longest wall, so the body hits it away from its ends
+  const track_wall_t *wall = &walls[0];
+  for (size_t i = 1; i < num_walls; i++) {
+    if (vec_get_length(vec_subtract(walls[i].b, walls[i].a)) >
+        vec_get_length(vec_subtract(wall->b, wall->a))) {
+      wall = &walls[i];
+    }
+  }
+  vector_t mid = vec_multiply(0.5, vec_add(wall->a, wall->b));
+
+  scene_t *scene = scene_init();
+  body_t *wall_body =
+      body_init_track_walls(track, WALL_RADIUS, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, wall_body);
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(body, vec_add(mid, vec_multiply(40, wall->normal)));
+  body_set_velocity(body, vec_multiply(-TOP_SPEED, wall->normal));
+  scene_add_body(scene, body);
+  create_physics_collision(scene, body, wall_body, 1);
+  for (size_t i = 0; i < 5; i++) {
+    scene_tick_bounded(scene, FRAME, WALL_RADIUS);
+  }
+  // The body ends up back on the drivable side, moving away from the wall
+  vector_t offset = vec_subtract(body_get_centroid(body), mid);
+  assert(vec_dot(offset, wall->normal) > 0);
+  assert(vec_dot(body_get_velocity(body), wall->normal) > 0);
+  scene_free(scene);
+  track_free(track);
+}
+
+// Tests that a body reaching a second wall while it still touches the first
+// collides with the second one too
+void test_track_wall_corner() {
+  track_t *track = track_load("assets/tracks/caltech.trk");
+  size_t num_walls;
+  const track_wall_t *walls = track_get_walls(track, &num_walls);
+  // Two walls that meet, the first long enough that its middle is far from
+  // the second
+  size_t first = num_walls;
+  for (size_t i = 0; i + 1 < num_walls; i++) {
+    if (vec_equal(walls[i].b, walls[i + 1].a) &&
+        vec_get_length(vec_subtract(walls[i].b, walls[i].a)) > 50) {
+      first = i;
+      break;
+    }
+  }
+  assert(first < num_walls);
+  const track_wall_t *wall = &walls[first];
+  const track_wall_t *next = &walls[first + 1];
+
+  scene_t *scene = scene_init();
+  body_t *wall_body = body_init_track_walls(track, 5, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, wall_body);
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, body);
+  int count = 0;
+  create_collision(scene, body, wall_body, count_collision, &count, 0);
+  vector_t mid = vec_multiply(0.5, vec_add(wall->a, wall->b));
+  body_set_centroid(body, vec_add(mid, vec_multiply(4, wall->normal)));
+  scene_tick(scene, 0);
+  scene_tick(scene, 0);
+  assert(count == 1);
+  // Slide into the corner, still touching the first wall
+  vector_t corner_normal = vec_add(wall->normal, next->normal);
+  corner_normal =
+      vec_multiply(1 / vec_get_length(corner_normal), corner_normal);
+  body_set_centroid(body, vec_add(wall->b, vec_multiply(4, corner_normal)));
+  scene_tick(scene, 0);
+  assert(count == 2);
+  scene_free(scene);
+  track_free(track);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -106,6 +454,16 @@ int main(int argc, char *argv[]) {
 
   DO_TEST(test_collisions)
   DO_TEST(test_forces_removed)
+  DO_TEST(test_polygon_segment)
+  DO_TEST(test_circle_segment)
+  DO_TEST(test_raycast_segment)
+  DO_TEST(test_circle_bodies)
+  DO_TEST(test_group_collision)
+  DO_TEST(test_group_collision_64)
+  DO_TEST(test_reset_collisions)
+  DO_TEST(test_collision_reset)
+  DO_TEST(test_track_wall_stops_body)
+  DO_TEST(test_track_wall_corner)
 
   puts("collision_test PASS");
 }
@@ -0,0 +1,129 @@
+#include "hash_map.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_hash_map_put_get() {
+  hash_map_t *map = hash_map_init(1, hash_string, string_equal, NULL);
+  char keys[100][8];
+  int values[100];
+  for (size_t i = 0; i < 100; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%zu", i);
+    assert(hash_map_put(map, keys[i], &values[i]) == NULL);
+    assert(hash_map_size(map) == i + 1);
+  }
+  for (size_t i = 0; i < 100; i++) {
+    // Lookups compare contents, not addresses
+    char key[8];
+    snprintf(key, sizeof(key), "key%zu", i);
+    assert(hash_map_get(map, key) == &values[i]);
+  }
+  assert(hash_map_get(map, "key100") == NULL);
+
+  // Putting an existing key replaces its value
+  int other;
+  assert(hash_map_put(map, "key7", &other) == &values[7]);
+  assert(hash_map_get(map, keys[7]) == &other);
+  assert(hash_map_size(map) == 100);
+  hash_map_free(map);
+}
+
+void test_hash_map_remove() {
+  hash_map_t *map = hash_map_init(4, hash_pointer, pointer_equal, NULL);
+  int values[64];
+  for (size_t i = 0; i < 64; i++) {
+    hash_map_put(map, &values[i], &values[i]);
+  }
+  for (size_t i = 0; i < 64; i += 2) {
+    assert(hash_map_remove(map, &values[i]) == &values[i]);
+  }
+  assert(hash_map_remove(map, &values[0]) == NULL);
+  assert(hash_map_size(map) == 32);
+  // Every remaining key is still reachable after the entries shift back
+  for (size_t i = 0; i < 64; i++) {
+    assert(hash_map_get(map, &values[i]) == (i % 2 == 0 ? NULL : &values[i]));
+  }
+  for (size_t i = 0; i < 64; i += 2) {
+    hash_map_put(map, &values[i], &values[i]);
+  }
+  assert(hash_map_size(map) == 64);
+  for (size_t i = 0; i < 64; i++) {
+    assert(hash_map_get(map, &values[i]) == &values[i]);
+  }
+  hash_map_free(map);
+}
+
+uint64_t collide(const void *key) { return 3; }
+
+void test_hash_map_collisions() {
+  // With every key in one probe sequence, removal has to move the rest back
+  hash_map_t *map = hash_map_init(0, collide, pointer_equal, NULL);
+  int values[6];
+  for (size_t i = 0; i < 6; i++) {
+    hash_map_put(map, &values[i], &values[i]);
+  }
+  for (size_t i = 0; i < 6; i++) {
+    assert(hash_map_remove(map, &values[i]) == &values[i]);
+    for (size_t j = i + 1; j < 6; j++) {
+      assert(hash_map_get(map, &values[j]) == &values[j]);
+    }
+  }
+  assert(hash_map_size(map) == 0);
+  hash_map_free(map);
+}
+
+void count_entry(const void *key, void *value, void *aux) {
+  assert(key == value);
+  (*(size_t *)aux)++;
+}
+
+void test_hash_map_for_each() {
+  hash_map_t *map = hash_map_init(0, hash_pointer, pointer_equal, free);
+  for (size_t i = 0; i < 20; i++) {
+    int *value = malloc(sizeof(int));
+    assert(value != NULL);
+    hash_map_put(map, value, value);
+  }
+  size_t count = 0;
+  hash_map_for_each(map, count_entry, &count);
+  assert(count == 20);
+  hash_map_free(map); // the values are freed here
+}
+
+void test_string_intern() {
+  string_pool_t *pool = string_pool_init();
+  char buffer[16];
+  strcpy(buffer, "assets/a.png");
+  const char *a = string_intern(pool, buffer);
+  assert(a != buffer && strcmp(a, "assets/a.png") == 0);
+
+  // The interned copy outlives the caller's buffer
+  strcpy(buffer, "assets/b.png");
+  assert(strcmp(a, "assets/a.png") == 0);
+  const char *b = string_intern(pool, buffer);
+  assert(b != a);
+  assert(string_intern(pool, "assets/a.png") == a);
+  assert(string_intern(pool, "assets/b.png") == b);
+  string_pool_free(pool);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_hash_map_put_get)
+  DO_TEST(test_hash_map_remove)
+  DO_TEST(test_hash_map_collisions)
+  DO_TEST(test_hash_map_for_each)
+  DO_TEST(test_string_intern)
+
+  puts("hash_map_test PASS");
+}
@@ -0,0 +1,137 @@
+#include "list.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+list_t *make_list(int *values, size_t size) {
+  list_t *list = list_init(0, NULL);
+  for (size_t i = 0; i < size; i++) {
+    list_add(list, &values[i]);
+  }
+  return list;
+}
+
+void test_list_remove() {
+  int values[] = {0, 1, 2, 3, 4};
+  list_t *list = make_list(values, 5);
+  assert(list_remove(list, 1) == &values[1]);
+  int expected[] = {0, 2, 3, 4};
+  assert(list_size(list) == 4);
+  for (size_t i = 0; i < 4; i++) {
+    assert(*(int *)list_get(list, i) == expected[i]);
+  }
+  list_free(list);
+}
+
+void test_list_swap_remove() {
+  int values[] = {0, 1, 2, 3, 4};
+  list_t *list = make_list(values, 5);
+  assert(list_swap_remove(list, 1) == &values[1]);
+  assert(list_size(list) == 4);
+  int expected[] = {0, 4, 2, 3};
+  for (size_t i = 0; i < 4; i++) {
+    assert(*(int *)list_get(list, i) == expected[i]);
+  }
+  // Removing the last element
+  assert(list_swap_remove(list, 3) == &values[3]);
+  assert(list_size(list) == 3);
+  assert(*(int *)list_get(list, 2) == 2);
+  list_free(list);
+}
+
+bool is_odd(void *element, void *aux) { return *(int *)element % 2 == 1; }
+
+bool above(void *element, void *aux) {
+  return *(int *)element > *(int *)aux;
+}
+
+void test_list_remove_if() {
+  int values[] = {0, 1, 2, 3, 4, 5, 6};
+  list_t *list = make_list(values, 7);
+  assert(list_remove_if(list, is_odd, NULL) == 3);
+  int expected[] = {0, 2, 4, 6};
+  assert(list_size(list) == 4);
+  for (size_t i = 0; i < 4; i++) {
+    assert(*(int *)list_get(list, i) == expected[i]);
+  }
+  int limit = 10;
+  assert(list_remove_if(list, above, &limit) == 0);
+  assert(list_size(list) == 4);
+  limit = -1;
+  assert(list_remove_if(list, above, &limit) == 4);
+  assert(list_size(list) == 0);
+  list_free(list);
+}
+
+size_t freed = 0;
+
+void count_free(void *element) {
+  freed++;
+  free(element);
+}
+
+void test_list_remove_if_frees() {
+  list_t *list = list_init(1, count_free);
+  for (int i = 0; i < 10; i++) {
+    int *value = malloc(sizeof(int));
+    *value = i;
+    list_add(list, value);
+  }
+  freed = 0;
+  assert(list_remove_if(list, is_odd, NULL) == 5);
+  assert(freed == 5);
+  list_free(list);
+  assert(freed == 10);
+}
+
+void test_list_reserve_shrink() {
+  int values[100];
+  list_t *list = list_init(0, NULL);
+  list_reserve(list, 100);
+  for (size_t i = 0; i < 100; i++) {
+    values[i] = i;
+    list_add(list, &values[i]);
+  }
+  list_shrink(list);
+  for (size_t i = 0; i < 100; i++) {
+    assert(*(int *)list_get(list, i) == (int)i);
+  }
+  // The list still grows after being shrunk
+  list_add(list, &values[0]);
+  assert(list_size(list) == 101);
+  while (list_size(list) > 0) {
+    list_swap_remove(list, 0);
+  }
+  list_shrink(list);
+  list_add(list, &values[1]);
+  assert(list_get(list, 0) == &values[1]);
+  list_free(list);
+}
+
+void swap_remove_empty(void *list) { list_swap_remove(list, 0); }
+
+void test_list_swap_remove_invalid() {
+  list_t *list = list_init(1, NULL);
+  assert(test_assert_fail(swap_remove_empty, list));
+  list_free(list);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_list_remove)
+  DO_TEST(test_list_swap_remove)
+  DO_TEST(test_list_remove_if)
+  DO_TEST(test_list_remove_if_frees)
+  DO_TEST(test_list_reserve_shrink)
+  DO_TEST(test_list_swap_remove_invalid)
+
+  puts("list_test PASS");
+}
@@ -0,0 +1,79 @@
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+void test_rng_reference() {
+  // xoshiro256** seeded with splitmix64, as in the reference implementation
+  rng_t rng = rng_init(0);
+  assert(rng_next(&rng) == 0x99ec5f36cb75f2b4);
+  assert(rng_next(&rng) == 0xbf6e1f784956452a);
+  assert(rng_next(&rng) == 0x1a5f849d4933e6e0);
+}
+
+void test_rng_seeding() {
+  rng_t a = rng_init(42);
+  rng_t b = rng_init(42);
+  rng_t c = rng_init(43);
+  bool differs = false;
+  for (size_t i = 0; i < 100; i++) {
+    uint64_t x = rng_next(&a);
+    assert(x == rng_next(&b));
+    differs |= x != rng_next(&c);
+  }
+  assert(differs);
+
+  // Copying a generator forks its sequence
+  rng_t fork = a;
+  for (size_t i = 0; i < 10; i++) {
+    assert(rng_next(&fork) == rng_next(&a));
+  }
+}
+
+void test_rng_ranges() {
+  rng_t rng = rng_init(1);
+  const size_t BOUND = 6;
+  size_t counts[6] = {0};
+  for (size_t i = 0; i < 6000; i++) {
+    size_t x = rng_below(&rng, BOUND);
+    assert(x < BOUND);
+    counts[x]++;
+  }
+  for (size_t i = 0; i < BOUND; i++) {
+    assert(counts[i] > 800 && counts[i] < 1200);
+  }
+  assert(rng_below(&rng, 1) == 0);
+
+  double sum = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    double x = rng_double(&rng);
+    assert(x >= 0 && x < 1);
+    sum += x;
+  }
+  assert(within(0.05, sum / 1000, 0.5));
+}
+
+void below_zero(void *rng) { rng_below(rng, 0); }
+
+void test_rng_below_zero() {
+  rng_t rng = rng_init(0);
+  assert(test_assert_fail(below_zero, &rng));
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_rng_reference)
+  DO_TEST(test_rng_seeding)
+  DO_TEST(test_rng_ranges)
+  DO_TEST(test_rng_below_zero)
+
+  puts("rng_test PASS");
+}
@@ -265,6 +265,212 @@ void test_reaping() {
   scene_free(scene);
 }
 
+bool not_body(body_t *body, void *aux) { return body != aux; }
+
+// Tests rays, swept circles and overlaps against polygons and circles
+void test_scene_queries() {
+  scene_t *scene = scene_init();
+  body_t *square = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(square, (vector_t){5, 0});
+  scene_add_body(scene, square);
+  body_t *circle = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_circle_collider(circle, 1);
+  body_set_centroid(circle, (vector_t){10, 0});
+  scene_add_body(scene, circle);
+  // Lots of bodies out of the way, so the index has something to skip
+  for (int i = 0; i < 100; i++) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_set_centroid(body, (vector_t){i * 3 - 150, 100});
+    scene_add_body(scene, body);
+  }
+
+  scene_hit_t hit = scene_raycast(scene, VEC_ZERO, (vector_t){2, 0}, 20, NULL,
+                                  NULL);
+  assert(hit.body == square);
+  assert(isclose(hit.distance, 4));
+  assert(vec_isclose(hit.point, (vector_t){4, 0}));
+  assert(vec_isclose(hit.normal, (vector_t){-1, 0}));
+  hit = scene_raycast(scene, VEC_ZERO, (vector_t){1, 0}, 3, NULL, NULL);
+  assert(hit.body == NULL);
+  hit = scene_raycast(scene, VEC_ZERO, (vector_t){1, 0}, 20, not_body, square);
+  assert(hit.body == circle);
+  assert(isclose(hit.distance, 9));
+  // A ray starting inside the square only sees the circle
+  hit = scene_raycast(scene, (vector_t){5, 0}, (vector_t){1, 0}, 20, NULL,
+                      NULL);
+  assert(hit.body == circle);
+
+  // Passes over the square as a ray, but not as a circle
+  hit = scene_raycast(scene, (vector_t){0, 1.5}, (vector_t){1, 0}, 20, NULL,
+                      NULL);
+  assert(hit.body == NULL);
+  hit = scene_shape_cast(scene, (vector_t){0, 1.5}, 1, (vector_t){1, 0}, 20,
+                         NULL, NULL);
+  assert(hit.body == square);
+  // It clips the top left corner
+  assert(isclose(hit.distance, 4 - sqrt(0.75)));
+  assert(vec_isclose(hit.normal, (vector_t){-sqrt(0.75), 0.5}));
+
+  // The index is rebuilt after the scene changes
+  body_set_centroid(square, (vector_t){5, 50});
+  scene_center_body(scene, circle, (vector_t){10, 0});
+  hit = scene_raycast(scene, VEC_ZERO, (vector_t){1, 0}, 20, NULL, NULL);
+  assert(hit.body == circle);
+
+  body_t *shape = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_centroid(shape, (vector_t){11.5, 0});
+  list_t *results = list_init(1, NULL);
+  assert(scene_overlap(scene, shape, NULL, NULL, results) == 1);
+  assert(list_get(results, 0) == circle);
+  assert(scene_overlap(scene, shape, not_body, circle, results) == 0);
+  list_free(results);
+  body_free(shape);
+  scene_free(scene);
+}
+
+void test_scene_seed() {
+  scene_t *a = scene_init();
+  scene_t *b = scene_init();
+  // Fresh scenes share a fixed seed
+  assert(rng_next(scene_get_rng(a)) == rng_next(scene_get_rng(b)));
+  scene_seed(a, 7);
+  scene_seed(b, 7);
+  for (size_t i = 0; i < 10; i++) {
+    assert(rng_below(scene_get_rng(a), 100) ==
+           rng_below(scene_get_rng(b), 100));
+  }
+  scene_free(a);
+  scene_free(b);
+}
+
+// Records the order timers ran in, and when
+typedef struct timer_log {
+  scene_t *scene;
+  size_t count;
+  int ids[10];
+  double times[10];
+} timer_log_t;
+
+typedef struct timer_aux {
+  timer_log_t *log;
+  int id;
+} timer_aux_t;
+
+void log_timer(timer_aux_t *aux) {
+  timer_log_t *log = aux->log;
+  log->ids[log->count] = aux->id;
+  log->times[log->count] = scene_get_time(log->scene);
+  log->count++;
+}
+
+// Schedules another timer with no delay, which runs in the same tick
+void chain_timer(timer_aux_t *aux) {
+  log_timer(aux);
+  aux->id++;
+  scene_add_timer(aux->log->scene, 0, NULL, (timer_callback_t)log_timer, aux);
+}
+
+void test_scene_timers() {
+  scene_t *scene = scene_init();
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, body);
+  timer_log_t log = {.scene = scene, .count = 0};
+  timer_aux_t aux[] = {{&log, 0}, {&log, 1}, {&log, 2}, {&log, 3}, {&log, 4}};
+  scene_add_timer(scene, 2.5, NULL, (timer_callback_t)log_timer, &aux[0]);
+  scene_add_timer(scene, 0.5, NULL, (timer_callback_t)log_timer, &aux[1]);
+  scene_add_timer(scene, 2.5, NULL, (timer_callback_t)log_timer, &aux[2]);
+  scene_add_timer(scene, 1.5, body, (timer_callback_t)log_timer, &aux[3]);
+  scene_add_timer(scene, 3.5, NULL, (timer_callback_t)chain_timer, &aux[4]);
+  assert(scene_get_time(scene) == 0);
+
+  scene_tick(scene, 1);
+  assert(log.count == 1 && log.ids[0] == 1 && log.times[0] == 1);
+  // The body's timer is dropped along with it
+  body_remove(body);
+  for (int i = 0; i < 3; i++) {
+    scene_tick(scene, 1);
+  }
+  assert(scene_get_time(scene) == 4);
+  assert(log.count == 5);
+  // Timers expiring together run in the order they were added
+  int ids[] = {1, 0, 2, 4, 5};
+  double times[] = {1, 3, 3, 4, 4};
+  for (size_t i = 0; i < log.count; i++) {
+    assert(log.ids[i] == ids[i]);
+    assert(log.times[i] == times[i]);
+  }
+  scene_free(scene);
+}
+
+void count_free(void *info) { (*(int *)info)++; }
+
+// Clearing a scene drops its bodies, force creators and timers together, and
+// the scene can be reused afterwards. Bodies from the arena still have their
+// infos freed.
+void test_scene_clear() {
+  scene_t *scene = scene_init();
+  timer_log_t log = {.scene = scene, .count = 0};
+  timer_aux_t aux = {&log, 0};
+  int infos_freed = 0;
+  for (int race = 0; race < 2; race++) {
+    body_t *body1 = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+    body_t *body2 =
+        body_init_in_arena(scene_get_arena(scene), make_shape(), 1,
+                           (rgb_color_t){0, 0, 0}, &infos_freed, count_free);
+    body_set_centroid(body2, (vector_t){10, 0});
+    scene_add_body(scene, body1);
+    scene_add_body(scene, body2);
+    create_spring(scene, 1, body1, body2);
+    scene_add_timer(scene, 1.5, NULL, (timer_callback_t)log_timer, &aux);
+    assert(arena_used(scene_get_arena(scene)) > 0);
+    scene_tick(scene, 1);
+    assert(body_get_velocity(body1).x > 0);
+    scene_clear(scene);
+    assert(scene_bodies(scene) == 0);
+    assert(scene_get_time(scene) == 0);
+    assert(arena_used(scene_get_arena(scene)) == 0);
+    assert(infos_freed == race + 1);
+    scene_tick(scene, 1);
+    scene_tick(scene, 1);
+  }
+  assert(log.count == 0);
+  scene_free(scene);
+}
+
+void count_steps(void *aux) { (*(int *)aux)++; }
+
+// Tests that a bounded tick takes enough steps for its fastest body that isn't
+// kinematic, up to a cap, and runs the timers once at the end
+void test_scene_tick_bounded() {
+  scene_t *scene = scene_init();
+  body_t *body = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_velocity(body, (vector_t){3, 0});
+  scene_add_body(scene, body);
+  body_t *parked = body_init(make_shape(), 1, (rgb_color_t){0, 0, 0});
+  body_set_kinematic(parked, true);
+  body_set_velocity(parked, (vector_t){1e9, 0});
+  scene_add_body(scene, parked);
+  int steps = 0;
+  scene_add_bodies_force_creator_with_freer(scene, count_steps, &steps,
+                                            list_init(0, NULL), NULL);
+  timer_log_t log = {.scene = scene, .count = 0};
+  timer_aux_t aux = {&log, 0};
+  scene_add_timer(scene, 0.5, NULL, (timer_callback_t)log_timer, &aux);
+
+  scene_tick_bounded(scene, 1, 1);
+  assert(steps == 3);
+  assert(vec_isclose(body_get_centroid(body), (vector_t){3, 0}));
+  assert(scene_get_time(scene) == 1);
+  assert(log.count == 1 && log.times[0] == 1);
+
+  // A runaway body only takes so many steps
+  steps = 0;
+  body_set_velocity(body, (vector_t){1e9, 0});
+  scene_tick_bounded(scene, 1, 1);
+  assert(steps > 3 && steps < 100);
+  scene_free(scene);
+}
+
 int main(int argc, char *argv[]) {
   // Run all tests if there are no command-line arguments
   bool all_tests = argc == 1;
@@ -279,6 +485,11 @@ int main(int argc, char *argv[]) {
   DO_TEST(test_force_creator)
   DO_TEST(test_force_creator_aux)
   DO_TEST(test_reaping)
+  DO_TEST(test_scene_queries)
+  DO_TEST(test_scene_seed)
+  DO_TEST(test_scene_timers)
+  DO_TEST(test_scene_clear)
+  DO_TEST(test_scene_tick_bounded)
 
   puts("scene_test PASS");
 }
@@ -0,0 +1,111 @@
+#include "slot_map.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+void test_slot_map_insert_get() {
+  slot_map_t *map = slot_map_init(1, NULL);
+  int values[10];
+  handle_t handles[10];
+  for (size_t i = 0; i < 10; i++) {
+    handles[i] = slot_map_insert(map, &values[i]);
+    assert(slot_map_size(map) == i + 1);
+  }
+  for (size_t i = 0; i < 10; i++) {
+    assert(slot_map_get(map, handles[i]) == &values[i]);
+  }
+  assert(slot_map_get(map, (handle_t){0}) == NULL);
+  assert(slot_map_get(map, (handle_t){.index = 10, .generation = 1}) == NULL);
+  slot_map_free(map);
+}
+
+void test_slot_map_stale_handles() {
+  slot_map_t *map = slot_map_init(2, NULL);
+  int a, b, c;
+  handle_t ha = slot_map_insert(map, &a);
+  handle_t hb = slot_map_insert(map, &b);
+  assert(slot_map_remove(map, ha) == &a);
+  assert(slot_map_get(map, ha) == NULL);
+  assert(slot_map_remove(map, ha) == NULL);
+  assert(slot_map_size(map) == 1);
+
+  // The freed slot is reused, but the old handle still doesn't resolve
+  handle_t hc = slot_map_insert(map, &c);
+  assert(hc.index == ha.index && hc.generation != ha.generation);
+  assert(slot_map_get(map, ha) == NULL);
+  assert(slot_map_get(map, hb) == &b);
+  assert(slot_map_get(map, hc) == &c);
+  slot_map_free(map);
+}
+
+void test_slot_map_iteration() {
+  slot_map_t *map = slot_map_init(4, NULL);
+  int values[5];
+  handle_t handles[5];
+  for (size_t i = 0; i < 5; i++) {
+    handles[i] = slot_map_insert(map, &values[i]);
+  }
+  slot_map_remove(map, handles[1]);
+  slot_map_remove(map, handles[3]);
+  assert(slot_map_size(map) == 3);
+  bool seen[5] = {false};
+  for (size_t i = 0; i < slot_map_size(map); i++) {
+    int *value = slot_map_get_at(map, i);
+    size_t index = value - values;
+    assert(!seen[index]);
+    seen[index] = true;
+    handle_t handle = slot_map_handle_at(map, i);
+    assert(handle.index == handles[index].index &&
+           handle.generation == handles[index].generation);
+  }
+  assert(seen[0] && !seen[1] && seen[2] && !seen[3] && seen[4]);
+
+  // Removing from the end while iterating visits every value
+  for (size_t i = slot_map_size(map); i > 0; i--) {
+    slot_map_remove(map, slot_map_handle_at(map, i - 1));
+  }
+  assert(slot_map_size(map) == 0);
+  for (size_t i = 0; i < 5; i++) {
+    assert(slot_map_get(map, handles[i]) == NULL);
+  }
+  slot_map_free(map);
+}
+
+void test_slot_map_free_values() {
+  slot_map_t *map = slot_map_init(2, free);
+  for (size_t i = 0; i < 3; i++) {
+    int *value = malloc(sizeof(int));
+    assert(value != NULL);
+    *value = i;
+    slot_map_insert(map, value);
+  }
+  free(slot_map_remove(map, slot_map_handle_at(map, 0)));
+  slot_map_free(map); // the remaining values are freed here
+}
+
+void get_out_of_range(void *map) { slot_map_get_at(map, 0); }
+
+void test_slot_map_get_at_invalid() {
+  slot_map_t *map = slot_map_init(1, NULL);
+  assert(test_assert_fail(get_out_of_range, map));
+  slot_map_free(map);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_slot_map_insert_get)
+  DO_TEST(test_slot_map_stale_handles)
+  DO_TEST(test_slot_map_iteration)
+  DO_TEST(test_slot_map_free_values)
+  DO_TEST(test_slot_map_get_at_invalid)
+
+  puts("slot_map_test PASS");
+}
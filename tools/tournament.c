@@ -0,0 +1,485 @@
+/**
+ * Runs a tournament of headless AI races across every core, to evaluate the
+ * AI tuning without playing. Usage:
+ *
+ *   bin/tournament [-r races] [-j workers] [-n cars] [-l laps] [-s seed]
+ *                  [-E easy speed] [-M medium speed] [-H hard speed]
+ *                  [-t path tolerance] [-T track] [-o output.csv]
+ *
+ * Race i seeds its scene's generator with (seed + i), which picks the car type
+ * and villain type of every car on the grid and jitters their starting
+ * headings, so a race plays out the same on every machine. The races are
+ * split between forked worker processes, which send each car's result back
+ * through a pipe. Lap time distributions and win rates for every combination
+ * of car type and villain type are written to the CSV file.
+ *
+ * Item boxes are left out: they need the renderer for their images and the AI
+ * never uses items anyway.
+ */
+#include <assert.h>
+#include <getopt.h>
+#include <math.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ai.h"
+#include "car.h"
+#include "checkpoints.h"
+#include "color.h"
+#include "forces.h"
+#include "scene.h"
+#include "track.h"
+
+// The same physics and grid as demo/game.c
+const double TRACK_MU = 2;
+const double WALL_ELASTICITY = 1;
+const double WALL_RADIUS = 5.0;
+const double STUN_ROT_SPEED = 2 * M_PI;
+const vector_t AI_START_OFFSET = {-120, 0};
+const double GRID_ROW_SPACING = 80;
+// The best lap time the game starts with, which sets the ghost's speed
+const double GHOST_BEST_TIME = 170;
+
+const size_t NUM_CAR_TYPES = 3;
+const size_t NUM_VILLAIN_TYPES = 4;
+const char *CAR_NAMES[] = {"F1", "GOLF_CART", "PICKUP"};
+const char *VILLAIN_NAMES[] = {"EASY_AI", "MEDIUM_AI", "HARD_AI", "GHOST"};
+
+// Races are simulated at a fixed 60 ticks per second
+const double DT = 1.0 / 60;
+// Cars that haven't finished by then are counted as not finishing
+const double MAX_RACE_TIME = 600;
+// The most a car's starting heading is turned either way
+const double START_JITTER = 0.05;
+#define MAX_LAPS 10
+#define MAX_CARS 64
+
+typedef struct options {
+  size_t races;
+  size_t workers;
+  size_t cars;
+  size_t laps;
+  unsigned seed;
+  ai_tuning_t tuning;
+  const char *track_path;
+  const char *output_path;
+} options_t;
+
+/**
+ * How one car did in one race. This is what workers send to the parent, so it
+ * is plain data.
+ */
+typedef struct result {
+  uint8_t car_type;
+  uint8_t villain_type;
+  uint8_t place; // 1 for the winner, 0 if the car didn't finish
+  uint8_t laps;  // the number of laps completed
+  double lap_times[MAX_LAPS];
+} result_t;
+
+/**
+ * Everything recorded for one combination of car type and villain type.
+ */
+typedef struct stats {
+  size_t entries;
+  size_t wins;
+  size_t finishes;
+  double *lap_times;
+  size_t num_laps;
+  size_t capacity;
+} stats_t;
+
+/**
+ * Returns where the car in a grid slot starts: two abreast across the track,
+ * in rows behind the start, as in the game.
+ */
+static vector_t grid_slot(track_t *track, size_t slot) {
+  vector_t spawn = track_get_spawn(track);
+  double theta = track_get_spawn_rotation(track);
+  vector_t direction = {.x = sin(theta), .y = -cos(theta)};
+  vector_t side = vec_multiply(slot % 2, AI_START_OFFSET);
+  vector_t back = vec_multiply(-GRID_ROW_SPACING * (slot / 2), direction);
+  return vec_add(spawn, vec_add(side, back));
+}
+
+/**
+ * Simulates one race between AI cars and stores each car's result.
+ */
+static void run_race(track_t *track, const options_t *options, unsigned seed,
+                     result_t *results) {
+  size_t n = options->cars;
+  scene_t *scene = scene_init();
+  scene_seed(scene, seed);
+  rng_t *rng = scene_get_rng(scene);
+  size_t num_gates;
+  const track_gate_t *gates = track_get_gates(track, &num_gates);
+  arena_t *arena = scene_get_arena(scene);
+  list_t *checkpoints = make_checkpoints(arena, gates, num_gates);
+  for (size_t i = 0; i < num_gates; i++) {
+    scene_add_body(scene, list_get(checkpoints, i));
+  }
+
+  ai_t *ai = ai_init(options->tuning.path_tolerance, STUN_ROT_SPEED);
+  list_t *cars = list_init(n, NULL);
+  list_t *solid_cars = list_init(n, NULL); // ghosts drive through other cars
+  double spawn_rotation = track_get_spawn_rotation(track);
+  for (size_t i = 0; i < n; i++) {
+    car_type_t car_type = rng_below(rng, NUM_CAR_TYPES);
+    villain_type_t villain_type = rng_below(rng, NUM_VILLAIN_TYPES);
+    double jitter = START_JITTER * (2 * rng_double(rng) - 1);
+    body_t *car = make_car(arena, car_type);
+    body_set_centroid(car, grid_slot(track, i));
+    body_set_rotation(car, spawn_rotation + jitter);
+    scene_add_body(scene, car);
+    create_drag(scene, TRACK_MU, car);
+    change_top_speed(car, ai_villain_speed(options->tuning, villain_type,
+                                           GHOST_BEST_TIME));
+    car_set_checkpoint_state(car, checkpoint_state_init(checkpoints));
+    ai_add_car(ai, car);
+    list_add(cars, car);
+    if (villain_type != GHOST) {
+      list_add(solid_cars, car);
+    }
+    results[i] = (result_t){.car_type = car_type,
+                            .villain_type = villain_type,
+                            .place = 0,
+                            .laps = 0};
+  }
+  create_car_collisions(scene, solid_cars);
+  create_checkpoint_collisions(scene, cars, checkpoints);
+
+  body_t *walls = body_init_track_walls(track, WALL_RADIUS, get_blue());
+  scene_add_body(scene, walls);
+  for (size_t i = 0; i < n; i++) {
+    create_physics_collision(scene, list_get(cars, i), walls,
+                             WALL_ELASTICITY);
+  }
+  ai_set_track(ai, scene, track, walls, checkpoints);
+
+  double time = 0;
+  double lap_start[MAX_CARS] = {0};
+  size_t finished = 0;
+  while (finished < n && time < MAX_RACE_TIME) {
+    time += DT;
+    scene_tick_bounded(scene, DT, WALL_RADIUS);
+    ai_tick(ai, NULL, DT);
+    for (size_t i = 0; i < n; i++) {
+      result_t *result = &results[i];
+      size_t laps = car_get_laps_done(list_get(cars, i));
+      if (laps <= result->laps || result->laps == options->laps) {
+        continue;
+      }
+      result->lap_times[result->laps] = time - lap_start[i];
+      result->laps++;
+      lap_start[i] = time;
+      if (result->laps == options->laps) {
+        result->place = ++finished;
+      }
+    }
+  }
+
+  ai_free(ai);
+  list_free(cars);
+  list_free(solid_cars);
+  scene_free(scene);
+  list_free(checkpoints);
+}
+
+/**
+ * Writes all of a buffer to a pipe, retrying after partial writes.
+ */
+static void write_all(int fd, const void *buffer, size_t size) {
+  const uint8_t *bytes = buffer;
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    assert(written > 0);
+    bytes += written;
+    size -= written;
+  }
+}
+
+/**
+ * Runs every race assigned to a worker and sends the results to the parent.
+ * Worker w runs races w, w + workers, w + 2 * workers, ...
+ */
+static void run_worker(const options_t *options, size_t worker, int fd) {
+  track_t *track = track_load(options->track_path);
+  if (track == NULL) {
+    exit(1);
+  }
+  result_t results[MAX_CARS];
+  for (size_t race = worker; race < options->races;
+       race += options->workers) {
+    run_race(track, options, options->seed + race, results);
+    write_all(fd, results, options->cars * sizeof(result_t));
+  }
+  track_free(track);
+}
+
+static void stats_add(stats_t *stats, const result_t *result) {
+  stats->entries++;
+  if (result->place == 1) {
+    stats->wins++;
+  }
+  if (result->place != 0) {
+    stats->finishes++;
+  }
+  for (size_t i = 0; i < result->laps; i++) {
+    if (stats->num_laps == stats->capacity) {
+      stats->capacity = stats->capacity == 0 ? 16 : 2 * stats->capacity;
+      stats->lap_times =
+          realloc(stats->lap_times, stats->capacity * sizeof(double));
+      assert(stats->lap_times != NULL);
+    }
+    stats->lap_times[stats->num_laps++] = result->lap_times[i];
+  }
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Returns the value below which a fraction of the sorted values fall.
+ */
+static double percentile(const double *sorted, size_t size, double fraction) {
+  size_t idx = (size_t)round(fraction * (size - 1));
+  return sorted[idx];
+}
+
+static void write_csv(FILE *file, stats_t stats[][NUM_VILLAIN_TYPES]) {
+  fprintf(file, "car,villain,entries,wins,win_rate,finishes,laps,lap_mean,"
+                "lap_stddev,lap_min,lap_p10,lap_p50,lap_p90,lap_max\n");
+  for (size_t c = 0; c < NUM_CAR_TYPES; c++) {
+    for (size_t v = 0; v < NUM_VILLAIN_TYPES; v++) {
+      stats_t *s = &stats[c][v];
+      if (s->entries == 0) {
+        continue;
+      }
+      fprintf(file, "%s,%s,%zu,%zu,%.4f,%zu,%zu", CAR_NAMES[c],
+              VILLAIN_NAMES[v], s->entries, s->wins,
+              (double)s->wins / s->entries, s->finishes, s->num_laps);
+      if (s->num_laps == 0) {
+        fprintf(file, ",,,,,,,\n");
+        continue;
+      }
+      qsort(s->lap_times, s->num_laps, sizeof(double), compare_doubles);
+      double sum = 0;
+      double sum_squares = 0;
+      for (size_t i = 0; i < s->num_laps; i++) {
+        sum += s->lap_times[i];
+        sum_squares += s->lap_times[i] * s->lap_times[i];
+      }
+      double mean = sum / s->num_laps;
+      double variance = fmax(sum_squares / s->num_laps - mean * mean, 0);
+      fprintf(file, ",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", mean,
+              sqrt(variance), s->lap_times[0],
+              percentile(s->lap_times, s->num_laps, 0.1),
+              percentile(s->lap_times, s->num_laps, 0.5),
+              percentile(s->lap_times, s->num_laps, 0.9),
+              s->lap_times[s->num_laps - 1]);
+    }
+  }
+}
+
+/**
+ * Reads the results from every worker as they arrive, until all of the
+ * pipes are closed. Returns the number of races received.
+ */
+static size_t collect_results(const options_t *options, int *fds,
+                              stats_t stats[][NUM_VILLAIN_TYPES]) {
+  size_t race_size = options->cars * sizeof(result_t);
+  struct pollfd *polls = malloc(options->workers * sizeof(struct pollfd));
+  assert(polls != NULL);
+  // Each worker's partially received race
+  uint8_t *buffers = malloc(options->workers * race_size);
+  size_t *filled = calloc(options->workers, sizeof(size_t));
+  assert(buffers != NULL && filled != NULL);
+  for (size_t w = 0; w < options->workers; w++) {
+    polls[w] = (struct pollfd){.fd = fds[w], .events = POLLIN};
+  }
+
+  size_t races = 0;
+  size_t open = options->workers;
+  while (open > 0) {
+    if (poll(polls, options->workers, -1) < 0) {
+      continue; // interrupted
+    }
+    for (size_t w = 0; w < options->workers; w++) {
+      if (polls[w].fd < 0 || polls[w].revents == 0) {
+        continue;
+      }
+      uint8_t *buffer = buffers + w * race_size;
+      ssize_t got = read(fds[w], buffer + filled[w], race_size - filled[w]);
+      if (got <= 0) {
+        close(fds[w]);
+        polls[w].fd = -1;
+        open--;
+        continue;
+      }
+      filled[w] += got;
+      if (filled[w] < race_size) {
+        continue;
+      }
+      const result_t *results = (const result_t *)buffer;
+      for (size_t i = 0; i < options->cars; i++) {
+        stats_add(&stats[results[i].car_type][results[i].villain_type],
+                  &results[i]);
+      }
+      filled[w] = 0;
+      races++;
+    }
+  }
+  free(polls);
+  free(buffers);
+  free(filled);
+  return races;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [-r races] [-j workers] [-n cars] [-l laps] [-s seed]\n"
+          "          [-E easy speed] [-M medium speed] [-H hard speed]\n"
+          "          [-t path tolerance] [-T track] [-o output.csv]\n",
+          program);
+  exit(1);
+}
+
+static options_t parse_options(int argc, char *argv[]) {
+  options_t options = {.races = 1000,
+                       .workers = sysconf(_SC_NPROCESSORS_ONLN),
+                       .cars = 4,
+                       .laps = 3,
+                       .seed = 1,
+                       .tuning = ai_default_tuning(),
+                       .track_path = "assets/tracks/caltech.trk",
+                       .output_path = "tournament.csv"};
+  int opt;
+  while ((opt = getopt(argc, argv, "r:j:n:l:s:E:M:H:t:T:o:")) != -1) {
+    switch (opt) {
+    case 'r':
+      options.races = strtoul(optarg, NULL, 10);
+      break;
+    case 'j':
+      options.workers = strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      options.cars = strtoul(optarg, NULL, 10);
+      break;
+    case 'l':
+      options.laps = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      options.seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'E':
+      options.tuning.easy_speed = strtod(optarg, NULL);
+      break;
+    case 'M':
+      options.tuning.medium_speed = strtod(optarg, NULL);
+      break;
+    case 'H':
+      options.tuning.hard_speed = strtod(optarg, NULL);
+      break;
+    case 't':
+      options.tuning.path_tolerance = strtod(optarg, NULL);
+      break;
+    case 'T':
+      options.track_path = optarg;
+      break;
+    case 'o':
+      options.output_path = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind != argc || options.races == 0 || options.workers == 0 ||
+      options.cars == 0 || options.cars > MAX_CARS || options.laps == 0 ||
+      options.laps > MAX_LAPS) {
+    usage(argv[0]);
+  }
+  if (options.workers > options.races) {
+    options.workers = options.races;
+  }
+  return options;
+}
+
+int main(int argc, char *argv[]) {
+  options_t options = parse_options(argc, argv);
+  FILE *output = fopen(options.output_path, "w");
+  if (output == NULL) {
+    fprintf(stderr, "Couldn't open %s\n", options.output_path);
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int *fds = malloc(options.workers * sizeof(int));
+  assert(fds != NULL);
+  for (size_t w = 0; w < options.workers; w++) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      perror("pipe");
+      return 1;
+    }
+    fflush(NULL); // so buffered output isn't written by every worker
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pid == 0) {
+      // Workers only need the write end of their own pipe
+      for (size_t i = 0; i < w; i++) {
+        close(fds[i]);
+      }
+      close(pipe_fds[0]);
+      run_worker(&options, w, pipe_fds[1]);
+      close(pipe_fds[1]);
+      _exit(0);
+    }
+    close(pipe_fds[1]);
+    fds[w] = pipe_fds[0];
+  }
+
+  stats_t stats[NUM_CAR_TYPES][NUM_VILLAIN_TYPES];
+  memset(stats, 0, sizeof(stats));
+  size_t races = collect_results(&options, fds, stats);
+  bool failed = false;
+  for (size_t w = 0; w < options.workers; w++) {
+    int status;
+    wait(&status);
+    failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  free(fds);
+
+  write_csv(output, stats);
+  fclose(output);
+  for (size_t c = 0; c < NUM_CAR_TYPES; c++) {
+    for (size_t v = 0; v < NUM_VILLAIN_TYPES; v++) {
+      free(stats[c][v].lap_times);
+    }
+  }
+
+  double elapsed =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("%zu races on %zu workers in %.2f s: %.2f races/s/core\n", races,
+         options.workers, elapsed, races / elapsed / options.workers);
+  printf("Results written to %s\n", options.output_path);
+  if (failed || races != options.races) {
+    fprintf(stderr, "Only %zu of %zu races finished\n", races, options.races);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,399 @@
+/**
+ * Compiles a text track description into the binary format read by
+ * track_load(). Usage:
+ *
+ *   bin/track_compiler assets/tracks/caltech.track assets/tracks/caltech.trk
+ *
+ * See assets/tracks/caltech.track for the description syntax.
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "track.h"
+#include "vector.h"
+
+const size_t MAX_LINE = 256;
+const size_t INITIAL_POINTS = 16;
+const double DEFAULT_CELL_SIZE = 500.0;
+
+typedef struct {
+  vector_t *points;
+  size_t size;
+  size_t capacity;
+} point_array_t;
+
+typedef struct {
+  double scale;
+  char background_path[TRACK_PATH_MAX];
+  vector_t background_min;
+  vector_t background_max;
+  point_array_t inner;
+  point_array_t outer;
+  track_gate_t start;
+  size_t start_offset;
+  vector_t spawn;
+  double spawn_rotation;
+  size_t boxes_per_row;
+  size_t box_row_stride;
+  double cell_size;
+} track_source_t;
+
+/**
+ * Prints an error about line `line_no` of the source and exits.
+ */
+static void fail(const char *path, size_t line_no, const char *message) {
+  fprintf(stderr, "%s:%zu: %s\n", path, line_no, message);
+  exit(1);
+}
+
+static void point_array_add(point_array_t *array, vector_t point) {
+  if (array->size == array->capacity) {
+    array->capacity =
+        array->capacity == 0 ? INITIAL_POINTS : 2 * array->capacity;
+    array->points =
+        realloc(array->points, array->capacity * sizeof(vector_t));
+    assert(array->points != NULL);
+  }
+  array->points[array->size++] = point;
+}
+
+/**
+ * Reads "x y" lines into `loop` until a line containing "end".
+ */
+static void parse_loop(FILE *f, const char *path, size_t *line_no,
+                       point_array_t *loop) {
+  char line[MAX_LINE];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    (*line_no)++;
+    char word[MAX_LINE];
+    if (sscanf(line, "%255s", word) != 1 || word[0] == '#') {
+      continue;
+    }
+    if (strcmp(word, "end") == 0) {
+      return;
+    }
+    vector_t point;
+    if (sscanf(line, "%lf %lf", &point.x, &point.y) != 2) {
+      fail(path, *line_no, "expected a point or \"end\"");
+    }
+    point_array_add(loop, point);
+  }
+  fail(path, *line_no, "loop is missing \"end\"");
+}
+
+static track_source_t parse_source(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    printf("Couldn't open file %s\n", path);
+    exit(1);
+  }
+  track_source_t src = {.scale = 1.0,
+                        .spawn_rotation = 0.0,
+                        .boxes_per_row = 0,
+                        .box_row_stride = 1,
+                        .cell_size = DEFAULT_CELL_SIZE};
+  bool has_background = false, has_start = false, has_spawn = false;
+  char line[MAX_LINE];
+  size_t line_no = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    line_no++;
+    char word[MAX_LINE];
+    if (sscanf(line, "%255s", word) != 1 || word[0] == '#') {
+      continue;
+    }
+    const char *args = line + strspn(line, " \t") + strlen(word);
+    if (strcmp(word, "scale") == 0) {
+      if (sscanf(args, "%lf", &src.scale) != 1 || src.scale <= 0) {
+        fail(path, line_no, "expected a positive scale");
+      }
+    } else if (strcmp(word, "background") == 0) {
+      char image[MAX_LINE];
+      if (sscanf(args, "%255s %lf %lf %lf %lf", image, &src.background_min.x,
+                 &src.background_min.y, &src.background_max.x,
+                 &src.background_max.y) != 5) {
+        fail(path, line_no, "expected an image path and its bounds");
+      }
+      if (strlen(image) >= TRACK_PATH_MAX) {
+        fail(path, line_no, "background path is too long");
+      }
+      strcpy(src.background_path, image);
+      has_background = true;
+    } else if (strcmp(word, "inner") == 0) {
+      parse_loop(f, path, &line_no, &src.inner);
+    } else if (strcmp(word, "outer") == 0) {
+      parse_loop(f, path, &line_no, &src.outer);
+    } else if (strcmp(word, "start") == 0) {
+      if (sscanf(args, "%lf %lf %lf %lf", &src.start.in.x, &src.start.in.y,
+                 &src.start.out.x, &src.start.out.y) != 4) {
+        fail(path, line_no, "expected the two ends of the start line");
+      }
+      has_start = true;
+    } else if (strcmp(word, "start_offset") == 0) {
+      if (sscanf(args, "%zu", &src.start_offset) != 1) {
+        fail(path, line_no, "expected a loop index");
+      }
+    } else if (strcmp(word, "spawn") == 0) {
+      if (sscanf(args, "%lf %lf %lf", &src.spawn.x, &src.spawn.y,
+                 &src.spawn_rotation) != 3) {
+        fail(path, line_no, "expected a position and a rotation");
+      }
+      has_spawn = true;
+    } else if (strcmp(word, "boxes") == 0) {
+      if (sscanf(args, "%zu %zu", &src.boxes_per_row, &src.box_row_stride) !=
+              2 ||
+          src.box_row_stride == 0) {
+        fail(path, line_no, "expected boxes per row and a nonzero stride");
+      }
+    } else if (strcmp(word, "grid") == 0) {
+      if (sscanf(args, "%lf", &src.cell_size) != 1 || src.cell_size <= 0) {
+        fail(path, line_no, "expected a positive cell size");
+      }
+    } else {
+      fail(path, line_no, "unknown statement");
+    }
+  }
+  fclose(f);
+
+  if (!has_background || !has_start || !has_spawn) {
+    fail(path, line_no, "missing background, start or spawn");
+  }
+  if (src.inner.size < 3 || src.inner.size != src.outer.size) {
+    fail(path, line_no, "inner and outer loops must have the same length");
+  }
+  if (src.start_offset >= src.inner.size) {
+    fail(path, line_no, "start_offset is past the end of the loops");
+  }
+  // The loops and background are drawn in image units; everything else is
+  // already in world units.
+  for (size_t i = 0; i < src.inner.size; i++) {
+    src.inner.points[i] = vec_multiply(src.scale, src.inner.points[i]);
+    src.outer.points[i] = vec_multiply(src.scale, src.outer.points[i]);
+  }
+  src.background_min = vec_multiply(src.scale, src.background_min);
+  src.background_max = vec_multiply(src.scale, src.background_max);
+  return src;
+}
+
+/**
+ * Builds the walls along `loop`, with normals facing towards `other`.
+ */
+static void build_walls(point_array_t *loop, point_array_t *other,
+                        track_wall_t *walls) {
+  size_t n = loop->size;
+  for (size_t i = 0; i < n; i++) {
+    vector_t a = loop->points[i];
+    vector_t b = loop->points[(i + 1) % n];
+    vector_t side = vec_subtract(b, a);
+    side = (vector_t){-side.y, side.x};
+    side = vec_multiply(1 / vec_get_length(side), side);
+    // The wall's solid side faces away from the other loop
+    if (vec_dot(side, vec_subtract(a, other->points[i])) > 0) {
+      side = vec_negate(side);
+    }
+    walls[i] = (track_wall_t){.a = a, .b = b, .normal = side};
+  }
+}
+
+/**
+ * Returns the range of grid cells overlapped by a wall's bounding box,
+ * clamped to the grid.
+ */
+static void wall_cells(track_grid_t grid, track_wall_t wall, size_t *col0,
+                       size_t *col1, size_t *row0, size_t *row1) {
+  double x0 = (fmin(wall.a.x, wall.b.x) - grid.min.x) / grid.cell_size;
+  double x1 = (fmax(wall.a.x, wall.b.x) - grid.min.x) / grid.cell_size;
+  double y0 = (fmin(wall.a.y, wall.b.y) - grid.min.y) / grid.cell_size;
+  double y1 = (fmax(wall.a.y, wall.b.y) - grid.min.y) / grid.cell_size;
+  *col0 = (size_t)fmax(0, fmin(grid.cols - 1, floor(x0)));
+  *col1 = (size_t)fmax(0, fmin(grid.cols - 1, floor(x1)));
+  *row0 = (size_t)fmax(0, fmin(grid.rows - 1, floor(y0)));
+  *row1 = (size_t)fmax(0, fmin(grid.rows - 1, floor(y1)));
+}
+
+/**
+ * Rounds a file offset up to the alignment of every section.
+ */
+static size_t align_offset(size_t offset) {
+  return (offset + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+}
+
+/**
+ * Writes `size` bytes at `offset` into the output buffer.
+ */
+static void put_section(uint8_t *out, size_t offset, const void *data,
+                        size_t size) {
+  if (size > 0) {
+    memcpy(out + offset, data, size);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <source.track> <output.trk>\n", argv[0]);
+    return 1;
+  }
+  track_source_t src = parse_source(argv[1]);
+  size_t n = src.inner.size;
+
+  // Walls: the inside loop followed by the outside loop
+  size_t num_walls = 2 * n;
+  track_wall_t *walls = malloc(num_walls * sizeof(track_wall_t));
+  assert(walls != NULL);
+  build_walls(&src.inner, &src.outer, walls);
+  build_walls(&src.outer, &src.inner, walls + n);
+
+  // Gates: the start line, then one per loop point in race order
+  size_t num_gates = n + 1;
+  track_gate_t *gates = malloc(num_gates * sizeof(track_gate_t));
+  assert(gates != NULL);
+  gates[0] = src.start;
+  for (size_t i = 0; i < n; i++) {
+    size_t idx = (src.start_offset + i) % n;
+    gates[i + 1] = (track_gate_t){src.inner.points[idx], src.outer.points[idx]};
+  }
+
+  // Centerline: the midpoints of the gates
+  track_path_point_t *path = malloc(num_gates * sizeof(track_path_point_t));
+  assert(path != NULL);
+  double distance = 0.0;
+  for (size_t i = 0; i < num_gates; i++) {
+    vector_t mid = vec_multiply(0.5, vec_add(gates[i].in, gates[i].out));
+    if (i > 0) {
+      distance += vec_get_length(vec_subtract(mid, path[i - 1].point));
+    }
+    path[i] = (track_path_point_t){.point = mid, .distance = distance};
+  }
+  double path_length =
+      distance + vec_get_length(vec_subtract(path[0].point,
+                                             path[num_gates - 1].point));
+
+  // Item boxes: rows spread evenly across the track
+  size_t rows = src.boxes_per_row == 0 ? 0 : (n + src.box_row_stride - 1) /
+                                                 src.box_row_stride;
+  size_t num_boxes = rows * src.boxes_per_row;
+  vector_t *boxes = malloc((num_boxes + 1) * sizeof(vector_t));
+  assert(boxes != NULL);
+  size_t box = 0;
+  for (size_t i = 0; i < n && src.boxes_per_row > 0; i += src.box_row_stride) {
+    vector_t in = src.inner.points[i];
+    vector_t out = src.outer.points[i];
+    for (size_t j = 1; j <= src.boxes_per_row; j++) {
+      vector_t center = vec_add(vec_multiply(j, in),
+                                vec_multiply(src.boxes_per_row + 1 - j, out));
+      boxes[box++] = vec_multiply(1.0 / (src.boxes_per_row + 1.0), center);
+    }
+  }
+  assert(box == num_boxes);
+
+  // Wall grid, stored as a compressed cell -> walls table
+  track_grid_t grid = {.min = src.background_min, .cell_size = src.cell_size};
+  grid.cols = (uint32_t)ceil((src.background_max.x - src.background_min.x) /
+                             src.cell_size);
+  grid.rows = (uint32_t)ceil((src.background_max.y - src.background_min.y) /
+                             src.cell_size);
+  if (grid.cols == 0 || grid.rows == 0) {
+    fail(argv[1], 0, "background bounds are empty");
+  }
+  size_t num_cells = (size_t)grid.cols * grid.rows;
+  uint32_t *cells = calloc(num_cells + 1, sizeof(uint32_t));
+  assert(cells != NULL);
+  for (size_t i = 0; i < num_walls; i++) {
+    size_t col0, col1, row0, row1;
+    wall_cells(grid, walls[i], &col0, &col1, &row0, &row1);
+    for (size_t r = row0; r <= row1; r++) {
+      for (size_t c = col0; c <= col1; c++) {
+        cells[r * grid.cols + c + 1]++;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_cells; i++) {
+    cells[i + 1] += cells[i];
+  }
+  size_t num_cell_walls = cells[num_cells];
+  uint32_t *cell_walls = malloc((num_cell_walls + 1) * sizeof(uint32_t));
+  uint32_t *cursor = malloc(num_cells * sizeof(uint32_t));
+  assert(cell_walls != NULL && cursor != NULL);
+  memcpy(cursor, cells, num_cells * sizeof(uint32_t));
+  for (size_t i = 0; i < num_walls; i++) {
+    size_t col0, col1, row0, row1;
+    wall_cells(grid, walls[i], &col0, &col1, &row0, &row1);
+    for (size_t r = row0; r <= row1; r++) {
+      for (size_t c = col0; c <= col1; c++) {
+        cell_walls[cursor[r * grid.cols + c]++] = i;
+      }
+    }
+  }
+  free(cursor);
+
+  // Lay out the file
+  track_header_t header = {0};
+  header.magic = TRACK_MAGIC;
+  header.version = TRACK_VERSION;
+  strcpy(header.background_path, src.background_path);
+  header.background_min = src.background_min;
+  header.background_max = src.background_max;
+  header.spawn = src.spawn;
+  header.spawn_rotation = src.spawn_rotation;
+  header.path_length = path_length;
+  header.grid = grid;
+
+  size_t offset = align_offset(sizeof(track_header_t));
+  header.num_walls = num_walls;
+  header.walls_offset = offset;
+  offset = align_offset(offset + num_walls * sizeof(track_wall_t));
+  header.num_gates = num_gates;
+  header.gates_offset = offset;
+  offset = align_offset(offset + num_gates * sizeof(track_gate_t));
+  header.num_path = num_gates;
+  header.path_offset = offset;
+  offset = align_offset(offset + num_gates * sizeof(track_path_point_t));
+  header.num_boxes = num_boxes;
+  header.boxes_offset = offset;
+  offset = align_offset(offset + num_boxes * sizeof(vector_t));
+  header.cells_offset = offset;
+  offset = align_offset(offset + (num_cells + 1) * sizeof(uint32_t));
+  header.num_cell_walls = num_cell_walls;
+  header.cell_walls_offset = offset;
+  offset = align_offset(offset + num_cell_walls * sizeof(uint32_t));
+  header.file_size = offset;
+
+  uint8_t *out = calloc(offset, 1);
+  assert(out != NULL);
+  put_section(out, 0, &header, sizeof(header));
+  put_section(out, header.walls_offset, walls,
+              num_walls * sizeof(track_wall_t));
+  put_section(out, header.gates_offset, gates,
+              num_gates * sizeof(track_gate_t));
+  put_section(out, header.path_offset, path,
+              num_gates * sizeof(track_path_point_t));
+  put_section(out, header.boxes_offset, boxes, num_boxes * sizeof(vector_t));
+  put_section(out, header.cells_offset, cells,
+              (num_cells + 1) * sizeof(uint32_t));
+  put_section(out, header.cell_walls_offset, cell_walls,
+              num_cell_walls * sizeof(uint32_t));
+
+  FILE *f = fopen(argv[2], "wb");
+  if (f == NULL || fwrite(out, 1, offset, f) != offset) {
+    fprintf(stderr, "Couldn't write %s\n", argv[2]);
+    return 1;
+  }
+  fclose(f);
+  printf("%s: %zu walls, %zu gates, %zu boxes, %ux%u grid, %zu bytes\n",
+         argv[2], num_walls, num_gates, num_boxes, grid.cols, grid.rows,
+         offset);
+
+  free(out);
+  free(cell_walls);
+  free(cells);
+  free(boxes);
+  free(path);
+  free(gates);
+  free(walls);
+  free(src.inner.points);
+  free(src.outer.points);
+  return 0;
+}